@@ -198,11 +198,16 @@ int main(int argc, char **argv)
         int in = -1;
         int out = -1;
         QString target;
+        QList<int> segments;
         // get in and out point, we need them to calculate the progress in some cases
         if (!consumer.isNull()) {
             in = consumer.attribute(QStringLiteral("in"), QString::number(-1)).toInt();
             out = consumer.attribute(QStringLiteral("out"), QString::number(-1)).toInt();
             target = consumer.attribute(QStringLiteral("target"));
+            const QStringList splitPoints = consumer.attribute(QStringLiteral("kdenlive:segments")).split(QLatin1Char(','), Qt::SkipEmptyParts);
+            for (const QString &point : splitPoints) {
+                segments << point.toInt();
+            }
             QString output = parser.value(outputOption);
             if (!output.isEmpty()) {
                 // A custom output target was set.
@@ -236,6 +241,7 @@ int main(int argc, char **argv)
         QString subtitleFile = parser.value(subtitleOption);
 
         auto *rJob = new RenderJob(render, playlist, target, pid, in, out, subtitleFile, &app);
+        rJob->setSegments(segments);
         QObject::connect(rJob, &RenderJob::renderingFinished, rJob, [&]() {
             rJob->deleteLater();
             app.quit();
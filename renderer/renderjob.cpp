@@ -16,8 +16,11 @@
 #endif
 #include <QDebug>
 #include <QDir>
+#include <QDomDocument>
 #include <QElapsedTimer>
+#include <QMap>
 #include <QStandardPaths>
+#include <algorithm>
 #include <utility>
 // Can't believe I need to do this to sleep.
 class SleepThread : QThread
@@ -49,6 +52,10 @@ RenderJob::RenderJob(const QString &render, const QString &scenelist, const QStr
     , m_pid(pid)
     , m_dualpass(false)
     , m_subtitleFile(subtitleFile)
+    , m_segmentFolder(nullptr)
+    , m_runningSegments(0)
+    , m_nextSegment(0)
+    , m_copiedFrames(0)
 {
     m_renderProcess = new QProcess(&m_looper);
     m_renderProcess->setReadChannel(QProcess::StandardError);
@@ -78,9 +85,21 @@ RenderJob::~RenderJob()
     delete m_kdenlivesocket;
 #endif
     delete m_renderProcess;
+    for (QProcess *process : qAsConst(m_segmentProcesses)) {
+        process->disconnect(this);
+        process->kill();
+        process->waitForFinished();
+    }
+    qDeleteAll(m_segmentProcesses);
+    delete m_segmentFolder;
     m_logfile.close();
 }
 
+void RenderJob::setSegments(const QList<int> &splitPoints)
+{
+    m_segments = splitPoints;
+}
+
 void RenderJob::slotAbort(const QString &url)
 {
     if (m_dest == url) {
@@ -119,6 +138,10 @@ void RenderJob::sendFinish(int status, const QString &error)
 void RenderJob::slotAbort()
 {
     m_renderProcess->kill();
+    for (QProcess *process : qAsConst(m_segmentProcesses)) {
+        process->disconnect(this);
+        process->kill();
+    }
     sendFinish(-3, QString());
     if (m_erase) {
         QFile(m_scenelist).remove();
@@ -273,12 +296,279 @@ void RenderJob::start()
 
     // Because of the logging, we connect to stderr in all cases.
     connect(m_renderProcess, &QProcess::readyReadStandardError, this, &RenderJob::receivedStderr);
-    m_renderProcess->start(m_prog, m_args);
-    m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << "\n";
-    m_logstream.flush();
+    if (prepareSegments()) {
+        startSegments();
+    } else {
+        m_renderProcess->start(m_prog, m_args);
+        m_logstream << "Started render process: " << m_prog << ' ' << m_args.join(QLatin1Char(' ')) << "\n";
+        m_logstream.flush();
+    }
     m_looper.exec();
 }
 
+bool RenderJob::prepareSegments()
+{
+    if (m_framein < 0 || m_frameout <= m_framein || m_dest.contains(QLatin1Char('%'))) {
+        return false;
+    }
+    QFile file(m_scenelist);
+    QDomDocument doc;
+    if (!file.open(QIODevice::ReadOnly) || !doc.setContent(&file, false)) {
+        return false;
+    }
+    file.close();
+    QDomElement consumer = doc.documentElement().firstChildElement(QStringLiteral("consumer"));
+    if (consumer.isNull() || consumer.attribute(QStringLiteral("vn")) == QLatin1String("1")) {
+        return false;
+    }
+    // Timeline preview chunks that can be copied instead of rendered
+    QMap<int, QString> chunks;
+    const int chunkSize = consumer.attribute(QStringLiteral("kdenlive:chunksize")).toInt();
+    if (chunkSize > 0) {
+        const QDir chunkFolder(consumer.attribute(QStringLiteral("kdenlive:chunkfolder")));
+        const QString extension = consumer.attribute(QStringLiteral("kdenlive:chunkextension"));
+        const QStringList positions = consumer.attribute(QStringLiteral("kdenlive:chunks")).split(QLatin1Char(','), Qt::SkipEmptyParts);
+        for (const QString &position : positions) {
+            const int frame = position.toInt();
+            const QString chunkFile = chunkFolder.absoluteFilePath(QStringLiteral("%1.%2").arg(frame).arg(extension));
+            // The preview may have been invalidated since the job was created
+            if (frame >= m_framein && frame + chunkSize - 1 <= m_frameout && QFile::exists(chunkFile)) {
+                chunks.insert(frame, chunkFile);
+            }
+        }
+    }
+    if (m_segments.isEmpty() && chunks.isEmpty()) {
+        return false;
+    }
+    if (QStandardPaths::findExecutable(QStringLiteral("ffmpeg")).isEmpty()) {
+        m_logstream << "ffmpeg not found, rendering in a single process\n";
+        return false;
+    }
+    const QFileInfo destination(m_dest);
+    m_segmentFolder = new QTemporaryDir(destination.absoluteDir().absoluteFilePath(QStringLiteral(".kdenlive-segments-XXXXXX")));
+    if (!m_segmentFolder->isValid()) {
+        delete m_segmentFolder;
+        m_segmentFolder = nullptr;
+        return false;
+    }
+    m_segmentFormat = consumer.attribute(QStringLiteral("f"));
+    const QString audioCodec = consumer.attribute(QStringLiteral("acodec"));
+    const bool hasAudio = consumer.attribute(QStringLiteral("an")) != QLatin1String("1");
+    for (const QString &attribute : {QStringLiteral("kdenlive:segments"), QStringLiteral("kdenlive:chunks"), QStringLiteral("kdenlive:chunksize"),
+                                     QStringLiteral("kdenlive:chunkfolder"), QStringLiteral("kdenlive:chunkextension")}) {
+        consumer.removeAttribute(attribute);
+    }
+
+    auto addProcess = [this, &doc](const QString &name, int length) {
+        QFile playlist(m_segmentFolder->filePath(name));
+        if (!playlist.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            return false;
+        }
+        QTextStream outStream(&playlist);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        outStream.setCodec("UTF-8");
+#endif
+        outStream << doc.toString();
+        playlist.close();
+        auto *process = new QProcess(this);
+        process->setReadChannel(QProcess::StandardError);
+        process->setProgram(m_prog);
+        process->setArguments({QStringLiteral("-progress"), playlist.fileName()});
+        m_segmentProcesses << process;
+        m_segmentLengths << length;
+        m_segmentProgress << 0;
+        return true;
+    };
+
+    // Audio is rendered separately in one pass, so that segment boundaries cannot be heard
+    consumer.setAttribute(QStringLiteral("an"), 1);
+    consumer.removeAttribute(QStringLiteral("acodec"));
+    // Pieces start at the split points and around each copied chunk, a split point inside a chunk is dropped
+    QList<int> starts = {m_framein};
+    for (int point : qAsConst(m_segments)) {
+        auto chunk = chunks.upperBound(point);
+        if (chunk == chunks.begin() || std::prev(chunk).key() + chunkSize <= point) {
+            starts << point;
+        }
+    }
+    for (auto chunk = chunks.constBegin(); chunk != chunks.constEnd(); ++chunk) {
+        starts << chunk.key() << chunk.key() + chunkSize;
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+    while (!starts.isEmpty() && starts.last() > m_frameout) {
+        starts.removeLast();
+    }
+    for (int i = 0; i < starts.count(); i++) {
+        const int in = starts.at(i);
+        const int out = i + 1 < starts.count() ? starts.at(i + 1) - 1 : m_frameout;
+        if (chunks.contains(in)) {
+            m_segmentFiles << chunks.value(in);
+            m_copiedFrames += out - in + 1;
+            continue;
+        }
+        const QString segmentFile = m_segmentFolder->filePath(QStringLiteral("segment-%1.%2").arg(i).arg(destination.suffix()));
+        consumer.setAttribute(QStringLiteral("in"), in);
+        consumer.setAttribute(QStringLiteral("out"), out);
+        consumer.setAttribute(QStringLiteral("target"), segmentFile);
+        if (!addProcess(QStringLiteral("segment-%1.mlt").arg(i), out - in + 1)) {
+            return false;
+        }
+        m_segmentFiles << segmentFile;
+    }
+    if (!chunks.isEmpty()) {
+        m_logstream << "Reusing " << chunks.count() << " timeline preview chunks\n";
+    }
+    if (hasAudio) {
+        m_segmentAudioFile = m_segmentFolder->filePath(QStringLiteral("audio.mka"));
+        consumer.removeAttribute(QStringLiteral("an"));
+        if (!audioCodec.isEmpty()) {
+            consumer.setAttribute(QStringLiteral("acodec"), audioCodec);
+        }
+        consumer.setAttribute(QStringLiteral("vn"), 1);
+        consumer.removeAttribute(QStringLiteral("vcodec"));
+        consumer.setAttribute(QStringLiteral("f"), QStringLiteral("matroska"));
+        consumer.setAttribute(QStringLiteral("in"), m_framein);
+        consumer.setAttribute(QStringLiteral("out"), m_frameout);
+        consumer.setAttribute(QStringLiteral("target"), m_segmentAudioFile);
+        if (!addProcess(QStringLiteral("audio.mlt"), 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderJob::startSegments()
+{
+    m_runningSegments = m_segmentProcesses.count();
+    if (m_runningSegments == 0) {
+        // Everything is copied from the timeline preview
+        concatSegments();
+        return;
+    }
+    for (int i = 0; i < m_segmentProcesses.count(); i++) {
+        QProcess *process = m_segmentProcesses.at(i);
+        connect(process, &QProcess::readyReadStandardError, this, [this, i]() { segmentProgress(i); });
+        connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, i]() { segmentFinished(i); });
+        connect(process, &QProcess::errorOccurred, this, [this, i](QProcess::ProcessError error) {
+            if (error == QProcess::FailedToStart) {
+                segmentFinished(i);
+            }
+        });
+    }
+    // The audio pass runs along the video pieces, which are limited to the requested segment count
+    if (!m_segmentAudioFile.isEmpty()) {
+        startSegment(m_segmentProcesses.count() - 1);
+    }
+    const int videoPieces = m_segmentProcesses.count() - (m_segmentAudioFile.isEmpty() ? 0 : 1);
+    while (m_nextSegment < videoPieces && m_nextSegment <= m_segments.count()) {
+        startSegment(m_nextSegment++);
+    }
+}
+
+void RenderJob::startSegment(int index)
+{
+    QProcess *process = m_segmentProcesses.at(index);
+    process->start();
+    m_logstream << "Started segment render process: " << m_prog << ' ' << process->arguments().join(QLatin1Char(' ')) << "\n";
+    m_logstream.flush();
+}
+
+void RenderJob::segmentProgress(int index)
+{
+    QProcess *process = m_segmentProcesses.at(index);
+    QString result = QString::fromLocal8Bit(process->readAllStandardError()).simplified();
+    if (!result.startsWith(QLatin1String("Current Frame"))) {
+        m_errorMessage.append(result + QStringLiteral("<br>"));
+        m_logstream << result;
+        return;
+    }
+    int percent = result.section(QLatin1Char(' '), -1).toInt();
+    if (m_segmentLengths.at(index) == 0 || percent <= m_segmentProgress.at(index) || percent > 100) {
+        // Audio pass, it is much faster than the video and not counted
+        return;
+    }
+    m_segmentProgress[index] = percent;
+    qint64 done = m_copiedFrames;
+    qint64 total = m_copiedFrames;
+    for (int i = 0; i < m_segmentLengths.count(); i++) {
+        done += qint64(m_segmentLengths.at(i)) * m_segmentProgress.at(i) / 100;
+        total += m_segmentLengths.at(i);
+    }
+    // Keep the last percent for the joining step
+    int progress = int(99 * done / qMax(qint64(1), total));
+    if (progress <= m_progress) {
+        return;
+    }
+    m_progress = progress;
+    qint64 elapsedTime = m_startTime.secsTo(QDateTime::currentDateTime());
+    if (elapsedTime == m_seconds) {
+        return;
+    }
+    int frame = m_framein + int(done);
+    int speed = (frame - m_frame) / (elapsedTime - m_seconds);
+    m_seconds = elapsedTime;
+    m_frame = frame;
+    updateProgress(speed);
+}
+
+void RenderJob::segmentFinished(int index)
+{
+    QProcess *process = m_segmentProcesses.at(index);
+    if (process->error() == QProcess::FailedToStart || process->exitStatus() == QProcess::CrashExit || process->exitCode() != 0) {
+        m_logstream << "Segment render process " << index << " failed\n";
+        for (QProcess *segmentProcess : qAsConst(m_segmentProcesses)) {
+            segmentProcess->disconnect(this);
+            segmentProcess->kill();
+        }
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    if (--m_runningSegments == 0) {
+        concatSegments();
+        return;
+    }
+    const int videoPieces = m_segmentProcesses.count() - (m_segmentAudioFile.isEmpty() ? 0 : 1);
+    if (m_nextSegment < videoPieces) {
+        startSegment(m_nextSegment++);
+    }
+}
+
+void RenderJob::concatSegments()
+{
+    QFile list(m_segmentFolder->filePath(QStringLiteral("segments.txt")));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        m_errorMessage.append(tr("Cannot write to %1, check permissions.").arg(list.fileName()));
+        slotIsOver(QProcess::CrashExit);
+        return;
+    }
+    QTextStream listStream(&list);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    listStream.setCodec("UTF-8");
+#endif
+    for (QString segment : qAsConst(m_segmentFiles)) {
+        // Quote for the concat demuxer
+        segment.replace(QLatin1Char('\''), QLatin1String("'\\''"));
+        listStream << "file '" << segment << "'\n";
+    }
+    list.close();
+    QStringList args = {QStringLiteral("-y"),     QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-f"), QStringLiteral("concat"),
+                        QStringLiteral("-safe"), QStringLiteral("0"), QStringLiteral("-i"),    list.fileName()};
+    if (!m_segmentAudioFile.isEmpty()) {
+        args << QStringLiteral("-i") << m_segmentAudioFile << QStringLiteral("-map") << QStringLiteral("0:v") << QStringLiteral("-map") << QStringLiteral("1:a");
+    }
+    args << QStringLiteral("-c") << QStringLiteral("copy");
+    if (!m_segmentFormat.isEmpty()) {
+        args << QStringLiteral("-f") << m_segmentFormat;
+    }
+    args << m_dest;
+    const QString ffmpegExe = QStandardPaths::findExecutable(QStringLiteral("ffmpeg"));
+    m_logstream << "Joining segments: " << ffmpegExe << ' ' << args.join(QLatin1Char(' ')) << "\n";
+    m_logstream.flush();
+    // The usual end of job handling happens once the joining process exits
+    m_renderProcess->start(ffmpegExe, args);
+}
+
 #ifndef NODBUS
 void RenderJob::initKdenliveDbusInterface()
 {
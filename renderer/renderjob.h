@@ -16,6 +16,7 @@
 #include <QFile>
 #include <QObject>
 #include <QProcess>
+#include <QTemporaryDir>
 // Testing
 #include <QTextStream>
 
@@ -27,6 +28,9 @@ public:
     RenderJob(const QString &render, const QString &scenelist, const QString &target, int pid = -1, int in = -1, int out = -1,
               const QString &subtitleFile = QString(), QObject *parent = nullptr);
     ~RenderJob() override;
+    /** @brief Render the video in parallel segments starting at @param splitPoints,
+     *  and join them with the audio rendered in a single pass */
+    void setSegments(const QList<int> &splitPoints);
 
 public Q_SLOTS:
     void start();
@@ -72,6 +76,30 @@ private:
     QStringList m_args;
     /** @brief Used to write to the log file. */
     QTextStream m_logstream;
+    /** @brief First frame of each video segment except the first one */
+    QList<int> m_segments;
+    QTemporaryDir *m_segmentFolder;
+    /** @brief One melt process per video segment, followed by the audio process if any */
+    QList<QProcess *> m_segmentProcesses;
+    QList<int> m_segmentLengths;
+    QList<int> m_segmentProgress;
+    QStringList m_segmentFiles;
+    QString m_segmentAudioFile;
+    QString m_segmentFormat;
+    int m_runningSegments;
+    /** @brief Index of the next video segment process to start */
+    int m_nextSegment;
+    /** @brief Frames copied from timeline preview chunks instead of rendered */
+    int m_copiedFrames;
+    /** @brief Write the playlists of the video segments and audio pass.
+     *  @returns false if the job cannot be rendered in segments */
+    bool prepareSegments();
+    void startSegments();
+    void startSegment(int index);
+    void segmentProgress(int index);
+    void segmentFinished(int index);
+    /** @brief Join the rendered segments and audio into the destination file, without re-encoding */
+    void concatSegments();
 #ifdef NODBUS
     void fromServer();
 #else
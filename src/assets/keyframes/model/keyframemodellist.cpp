@@ -443,7 +443,7 @@ void KeyframeModelList::setParametersFromTask(const paramVector &params)
         refresh();
         UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo);
     }
-    pCore->pushUndo(undo, redo, i18n("Update effect"));
+    pCore->pushUndo(undo, redo, i18n("Update effect"), AssetParameterModel::memoryCost(params) + AssetParameterModel::memoryCost(currentValues));
 }
 
 void KeyframeModelList::reset()
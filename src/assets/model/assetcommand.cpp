@@ -7,10 +7,11 @@
 #include "assets/keyframes/model/keyframemodellist.hpp"
 #include "effects/effectsrepository.hpp"
 #include "transitions/transitionsrepository.hpp"
+#include <QDataStream>
 #include <memory>
 #include <utility>
 AssetCommand::AssetCommand(const std::shared_ptr<AssetParameterModel> &model, const QModelIndex &index, QString value, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : AccountedUndoCommand(parent)
     , m_model(model)
     , m_index(index)
     , m_value(std::move(value))
@@ -29,6 +30,7 @@ AssetCommand::AssetCommand(const std::shared_ptr<AssetParameterModel> &model, co
 
 void AssetCommand::undo()
 {
+    reload();
     if (m_name.contains(QLatin1Char('\n'))) {
         // Check if it is a multi param
         auto type = m_model->data(m_index, AssetParameterModel::TypeRole).value<ParamType>();
@@ -48,6 +50,7 @@ void AssetCommand::undo()
 
 void AssetCommand::redo()
 {
+    reload();
     if (m_name.contains(QLatin1Char('\n'))) {
         // Check if it is a multi param
         auto type = m_model->data(m_index, AssetParameterModel::TypeRole).value<ParamType>();
@@ -78,14 +81,38 @@ bool AssetCommand::mergeWith(const QUndoCommand *other)
         m_stamp.msecsTo(static_cast<const AssetCommand *>(other)->m_stamp) > 3000) {
         return false;
     }
+    reload();
     m_value = static_cast<const AssetCommand *>(other)->m_value;
     m_stamp = static_cast<const AssetCommand *>(other)->m_stamp;
     return true;
 }
 
+qint64 AssetCommand::memoryCost() const
+{
+    return AccountedUndoCommand::memoryCost() + (m_value.size() + m_oldValue.size() + m_name.size()) * qint64(sizeof(QChar));
+}
+
+QByteArray AssetCommand::takeState()
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream << m_value << m_oldValue;
+    m_value.clear();
+    m_value.squeeze();
+    m_oldValue.clear();
+    m_oldValue.squeeze();
+    return state;
+}
+
+void AssetCommand::restoreState(const QByteArray &state)
+{
+    QDataStream stream(state);
+    stream >> m_value >> m_oldValue;
+}
+
 AssetMultiCommand::AssetMultiCommand(const std::shared_ptr<AssetParameterModel> &model, const QList<QModelIndex> &indexes, const QStringList &values,
                                      QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : AccountedUndoCommand(parent)
     , m_model(model)
     , m_indexes(indexes)
     , m_values(values)
@@ -108,6 +135,7 @@ AssetMultiCommand::AssetMultiCommand(const std::shared_ptr<AssetParameterModel>
 
 void AssetMultiCommand::undo()
 {
+    reload();
     int indx = 0;
     int max = m_indexes.size() - 1;
     for (const QModelIndex &ix : qAsConst(m_indexes)) {
@@ -118,6 +146,7 @@ void AssetMultiCommand::undo()
 // virtual
 void AssetMultiCommand::redo()
 {
+    reload();
     int indx = 0;
     int max = m_indexes.size() - 1;
     for (const QModelIndex &ix : qAsConst(m_indexes)) {
@@ -139,14 +168,46 @@ bool AssetMultiCommand::mergeWith(const QUndoCommand *other)
         m_stamp.msecsTo(static_cast<const AssetMultiCommand *>(other)->m_stamp) > 3000) {
         return false;
     }
+    reload();
     m_values = static_cast<const AssetMultiCommand *>(other)->m_values;
     m_stamp = static_cast<const AssetMultiCommand *>(other)->m_stamp;
     return true;
 }
 
+// virtual
+qint64 AssetMultiCommand::memoryCost() const
+{
+    qint64 size = m_name.size();
+    for (const QString &value : m_values) {
+        size += value.size();
+    }
+    for (const QString &value : m_oldValues) {
+        size += value.size();
+    }
+    return AccountedUndoCommand::memoryCost() + size * qint64(sizeof(QChar));
+}
+
+// virtual
+QByteArray AssetMultiCommand::takeState()
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream << m_values << m_oldValues;
+    m_values.clear();
+    m_oldValues.clear();
+    return state;
+}
+
+// virtual
+void AssetMultiCommand::restoreState(const QByteArray &state)
+{
+    QDataStream stream(state);
+    stream >> m_values >> m_oldValues;
+}
+
 AssetKeyframeCommand::AssetKeyframeCommand(const std::shared_ptr<AssetParameterModel> &model, const QModelIndex &index, QVariant value, GenTime pos,
                                            QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : AccountedUndoCommand(parent)
     , m_model(model)
     , m_index(index)
     , m_value(std::move(value))
@@ -192,7 +253,7 @@ bool AssetKeyframeCommand::mergeWith(const QUndoCommand *other)
 }
 
 AssetUpdateCommand::AssetUpdateCommand(const std::shared_ptr<AssetParameterModel> &model, QVector<QPair<QString, QVariant>> parameters, QUndoCommand *parent)
-    : QUndoCommand(parent)
+    : AccountedUndoCommand(parent)
     , m_model(model)
     , m_value(std::move(parameters))
 {
@@ -207,11 +268,13 @@ AssetUpdateCommand::AssetUpdateCommand(const std::shared_ptr<AssetParameterModel
 
 void AssetUpdateCommand::undo()
 {
+    reload();
     m_model->setParameters(m_oldValue);
 }
 // virtual
 void AssetUpdateCommand::redo()
 {
+    reload();
     m_model->setParameters(m_value);
 }
 
@@ -220,3 +283,29 @@ int AssetUpdateCommand::id() const
 {
     return 3;
 }
+
+// virtual
+qint64 AssetUpdateCommand::memoryCost() const
+{
+    return AccountedUndoCommand::memoryCost() + AssetParameterModel::memoryCost(m_value) + AssetParameterModel::memoryCost(m_oldValue);
+}
+
+// virtual
+QByteArray AssetUpdateCommand::takeState()
+{
+    QByteArray state;
+    QDataStream stream(&state, QIODevice::WriteOnly);
+    stream << m_value << m_oldValue;
+    m_value.clear();
+    m_value.squeeze();
+    m_oldValue.clear();
+    m_oldValue.squeeze();
+    return state;
+}
+
+// virtual
+void AssetUpdateCommand::restoreState(const QByteArray &state)
+{
+    QDataStream stream(state);
+    stream >> m_value >> m_oldValue;
+}
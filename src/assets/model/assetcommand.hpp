@@ -6,6 +6,7 @@
 #pragma once
 
 #include "assetparametermodel.hpp"
+#include "undohelper.hpp"
 #include <QPersistentModelIndex>
 #include <QTime>
 #include <QUndoCommand>
@@ -14,7 +15,7 @@
     @brief \@todo Describe class AssetCommand
     @todo Describe class AssetCommand
  */
-class AssetCommand : public QUndoCommand
+class AssetCommand : public AccountedUndoCommand
 {
 public:
     AssetCommand(const std::shared_ptr<AssetParameterModel> &model, const QModelIndex &index, QString value, QUndoCommand *parent = nullptr);
@@ -22,6 +23,11 @@ public:
     void redo() override;
     int id() const override;
     bool mergeWith(const QUndoCommand *other) override;
+    qint64 memoryCost() const override;
+
+protected:
+    QByteArray takeState() override;
+    void restoreState(const QByteArray &state) override;
 
 private:
     std::shared_ptr<AssetParameterModel> m_model;
@@ -37,7 +43,7 @@ private:
     @brief \@todo Describe class AssetMultiCommand
     @todo Describe class AssetMultiCommand
  */
-class AssetMultiCommand : public QUndoCommand
+class AssetMultiCommand : public AccountedUndoCommand
 {
 public:
     AssetMultiCommand(const std::shared_ptr<AssetParameterModel> &model, const QList<QModelIndex> &indexes, const QStringList &values,
@@ -46,6 +52,11 @@ public:
     void redo() override;
     int id() const override;
     bool mergeWith(const QUndoCommand *other) override;
+    qint64 memoryCost() const override;
+
+protected:
+    QByteArray takeState() override;
+    void restoreState(const QByteArray &state) override;
 
 private:
     std::shared_ptr<AssetParameterModel> m_model;
@@ -61,7 +72,7 @@ private:
     @brief \@todo Describe class AssetKeyframeCommand
     @todo Describe class AssetKeyframeCommand
  */
-class AssetKeyframeCommand : public QUndoCommand
+class AssetKeyframeCommand : public AccountedUndoCommand
 {
 public:
     AssetKeyframeCommand(const std::shared_ptr<AssetParameterModel> &model, const QModelIndex &index, QVariant value, GenTime pos,
@@ -85,13 +96,18 @@ private:
     @brief \@todo Describe class AssetUpdateCommand
     @todo Describe class AssetUpdateCommand
  */
-class AssetUpdateCommand : public QUndoCommand
+class AssetUpdateCommand : public AccountedUndoCommand
 {
 public:
     AssetUpdateCommand(const std::shared_ptr<AssetParameterModel> &model, QVector<QPair<QString, QVariant>> parameters, QUndoCommand *parent = nullptr);
     void undo() override;
     void redo() override;
     int id() const override;
+    qint64 memoryCost() const override;
+
+protected:
+    QByteArray takeState() override;
+    void restoreState(const QByteArray &state) override;
 
 private:
     std::shared_ptr<AssetParameterModel> m_model;
@@ -911,6 +911,16 @@ bool AssetParameterModel::isActive() const
     return m_active;
 }
 
+// static
+qint64 AssetParameterModel::memoryCost(const paramVector &params)
+{
+    qint64 size = 0;
+    for (const auto &param : params) {
+        size += param.first.size() + param.second.toString().size();
+    }
+    return size * qint64(sizeof(QChar));
+}
+
 QVector<QPair<QString, QVariant>> AssetParameterModel::getAllParameters() const
 {
     QVector<QPair<QString, QVariant>> res;
@@ -1407,7 +1417,7 @@ void AssetParameterModel::setParametersFromTask(const paramVector &params)
             return true;
         };
         redo();
-        pCore->pushUndo(undo, redo, i18n("Update effect"));
+        pCore->pushUndo(undo, redo, i18n("Update effect"), memoryCost(params) + memoryCost(previousParams));
     }
 }
 
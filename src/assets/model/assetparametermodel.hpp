@@ -150,6 +150,8 @@ public:
 
     /** @brief Return all the parameters as pairs (parameter name, parameter value) */
     QVector<QPair<QString, QVariant>> getAllParameters() const;
+    /** @brief Returns the memory held by the names and values of @param params, in bytes */
+    static qint64 memoryCost(const paramVector &params);
     /** @brief Get a parameter value from its name */
     const QVariant getParamFromName(const QString &paramName);
     /** @brief Get a parameter index from its name */
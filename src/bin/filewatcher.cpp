@@ -6,40 +6,171 @@
 #include "filewatcher.hpp"
 
 #include <KDirWatch>
+#include <QDateTime>
+#include <QFile>
 #include <QFileInfo>
+#include <QtConcurrent>
+
+/// Directories with more watched files than this are polled, comparing all their files on each notification would be too slow
+static const int hugeFolderFiles = 2000;
+/// Maximum number of directories registered in KDirWatch on each event loop turn
+static const int registerBatchSize = 100;
 
 FileWatcher::FileWatcher(QObject *parent)
     : QObject(parent)
     , m_fileWatcher(new KDirWatch)
+    , m_watchBudget(watchBudget())
 {
     // Init clip modification tracker
     m_modifiedTimer.setInterval(2000);
-    connect(m_fileWatcher.get(), &KDirWatch::dirty, this, &FileWatcher::slotUrlModified);
-    connect(m_fileWatcher.get(), &KDirWatch::deleted, this, &FileWatcher::slotUrlMissing);
-    connect(m_fileWatcher.get(), &KDirWatch::created, this, &FileWatcher::slotUrlAdded);
+    connect(m_fileWatcher.get(), &KDirWatch::dirty, this, &FileWatcher::slotDirChanged);
+    connect(m_fileWatcher.get(), &KDirWatch::deleted, this, &FileWatcher::slotDirChanged);
+    connect(m_fileWatcher.get(), &KDirWatch::created, this, &FileWatcher::slotDirChanged);
     connect(&m_modifiedTimer, &QTimer::timeout, this, &FileWatcher::slotProcessModifiedUrls);
     m_queueTimer.setInterval(300);
     m_queueTimer.setSingleShot(true);
     connect(&m_queueTimer, &QTimer::timeout, this, &FileWatcher::slotProcessQueue);
+    connect(&m_statWatcher, &QFutureWatcher<StatList>::finished, this, &FileWatcher::slotRegisterFiles);
+    m_pollTimer.setInterval(10000);
+    connect(&m_pollTimer, &QTimer::timeout, this, &FileWatcher::slotPollDirs);
+    connect(&m_pollWatcher, &QFutureWatcher<StatList>::finished, this, &FileWatcher::slotPollDone);
+    m_dirChangeTimer.setInterval(200);
+    m_dirChangeTimer.setSingleShot(true);
+    connect(&m_dirChangeTimer, &QTimer::timeout, this, &FileWatcher::slotCheckChangedDirs);
+    connect(&m_dirStatWatcher, &QFutureWatcher<StatList>::finished, this, &FileWatcher::slotChangedDirsChecked);
+}
+
+// static
+int FileWatcher::watchBudget()
+{
+    // Each watched directory uses an inotify watch, leave most of the user limit to other applications
+    QFile limit(QStringLiteral("/proc/sys/fs/inotify/max_user_watches"));
+    if (limit.open(QIODevice::ReadOnly)) {
+        bool ok = false;
+        int maxWatches = limit.readAll().trimmed().toInt(&ok);
+        if (ok && maxWatches > 0) {
+            return qBound(64, maxWatches / 8, 16384);
+        }
+    }
+    return 1024;
+}
+
+// static
+FileWatcher::StatList FileWatcher::statFiles(const QStringList &paths)
+{
+    StatList states;
+    states.reserve(size_t(paths.size()));
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+        FileState state;
+        state.exists = info.exists();
+        if (state.exists) {
+            state.size = info.size();
+            state.modified = info.lastModified().toMSecsSinceEpoch();
+        }
+        states.emplace_back(path, state);
+    }
+    return states;
 }
 
 void FileWatcher::slotProcessQueue()
 {
-    if (m_pendingUrls.size() == 0) {
+    if (m_pendingUrls.size() == 0 || m_statWatcher.isRunning()) {
+        // A running batch will restart the queue when done
         return;
     }
-    auto iter = m_pendingUrls.begin();
-    doAddFile(iter->first, iter->second);
-    m_pendingUrls.erase(iter->first);
-    if (m_pendingUrls.size() > 0 && !m_queueTimer.isActive()) {
+    // Reading the initial state of the files can be slow on network storage, do it in a worker thread
+    m_statBatch.clear();
+    QStringList paths;
+    for (const auto &pending : m_pendingUrls) {
+        m_statBatch.emplace_back(pending.first, pending.second);
+        if (m_files.count(pending.second) == 0) {
+            paths << pending.second;
+        }
+    }
+    m_pendingUrls.clear();
+    paths.removeDuplicates();
+    m_statWatcher.setFuture(QtConcurrent::run([paths]() { return statFiles(paths); }));
+}
+
+void FileWatcher::slotRegisterFiles()
+{
+    if (!m_statBatch.empty()) {
+        std::unordered_map<QString, FileState> states;
+        for (const auto &state : m_statWatcher.result()) {
+            states[state.first] = state.second;
+        }
+        for (const auto &item : m_statBatch) {
+            const QString &binId = item.first;
+            const QString &url = item.second;
+            if (url.isEmpty()) {
+                // Removed while checked
+                continue;
+            }
+            if (m_binClipPaths.count(binId) > 0 && m_binClipPaths.at(binId) != url) {
+                detachFile(binId);
+            }
+            auto file = m_files.find(url);
+            if (file == m_files.end()) {
+                WatchedFile watched;
+                watched.dir = QFileInfo(url).absolutePath();
+                if (states.count(url) > 0) {
+                    watched.state = states.at(url);
+                }
+                file = m_files.emplace(url, watched).first;
+                WatchedDir &dir = m_dirs[watched.dir];
+                dir.files.insert(url);
+                if (!dir.registered && !m_pendingDirs.contains(watched.dir)) {
+                    m_pendingDirs << watched.dir;
+                }
+            }
+            file->second.binIds.insert(binId);
+            m_binClipPaths[binId] = url;
+        }
+        m_statBatch.clear();
+    }
+    // Register the directories by batches to keep the UI responsive
+    int count = 0;
+    m_fileWatcher->stopScan();
+    while (!m_pendingDirs.isEmpty() && count < registerBatchSize) {
+        const QString path = m_pendingDirs.takeFirst();
+        auto dir = m_dirs.find(path);
+        if (dir == m_dirs.end() || dir->second.registered) {
+            continue;
+        }
+        dir->second.registered = true;
+        if (m_registeredDirs >= m_watchBudget || dir->second.files.size() > size_t(hugeFolderFiles)) {
+            dir->second.polled = true;
+            if (!m_pollTimer.isActive()) {
+                m_pollTimer.start();
+            }
+        } else {
+            m_fileWatcher->addDir(path, KDirWatch::WatchFiles);
+            m_registeredDirs++;
+        }
+        count++;
+    }
+    m_fileWatcher->startScan();
+    if (!m_pendingDirs.isEmpty()) {
+        QMetaObject::invokeMethod(this, &FileWatcher::slotRegisterFiles, Qt::QueuedConnection);
+    } else if (!m_pendingUrls.empty() && !m_queueTimer.isActive()) {
         m_queueTimer.start();
     }
 }
 
 void FileWatcher::addFile(const QString &binId, const QString &url)
 {
-    if (m_occurences.count(url) > 0) {
-        // Already queued
+    if (url.isEmpty()) {
+        return;
+    }
+    auto file = m_files.find(url);
+    if (file != m_files.end()) {
+        // Already watched
+        if (m_binClipPaths.count(binId) > 0 && m_binClipPaths.at(binId) != url) {
+            detachFile(binId);
+        }
+        file->second.binIds.insert(binId);
+        m_binClipPaths[binId] = url;
         return;
     }
     m_pendingUrls[binId] = url;
@@ -48,56 +179,168 @@ void FileWatcher::addFile(const QString &binId, const QString &url)
     }
 }
 
-void FileWatcher::doAddFile(const QString &binId, const QString &url)
+void FileWatcher::removeFile(const QString &binId)
 {
-    if (url.isEmpty()) {
+    m_pendingUrls.erase(binId);
+    for (auto &item : m_statBatch) {
+        if (item.first == binId) {
+            // Ignore the result of the running check
+            item.second.clear();
+        }
+    }
+    detachFile(binId);
+}
+
+void FileWatcher::detachFile(const QString &binId)
+{
+    auto path = m_binClipPaths.find(binId);
+    if (path == m_binClipPaths.end()) {
         return;
     }
-    if (m_occurences.count(url) == 0) {
-        // QtConcurrent::run([=] { KDirWatch::self()->addFile(url); });
-        m_fileWatcher->addFile(url);
+    const QString url = path->second;
+    m_binClipPaths.erase(path);
+    auto file = m_files.find(url);
+    if (file == m_files.end()) {
+        return;
+    }
+    file->second.binIds.erase(binId);
+    if (file->second.binIds.empty()) {
+        const QString dir = file->second.dir;
+        m_files.erase(file);
+        m_modifiedUrls.erase(url);
+        auto watchedDir = m_dirs.find(dir);
+        if (watchedDir != m_dirs.end()) {
+            watchedDir->second.files.erase(url);
+        }
+        releaseDir(dir);
     }
-    m_occurences[url].insert(binId);
-    m_binClipPaths[binId] = url;
 }
 
-void FileWatcher::removeFile(const QString &binId)
+void FileWatcher::releaseDir(const QString &path)
 {
-    if (m_binClipPaths.count(binId) == 0) {
+    auto dir = m_dirs.find(path);
+    if (dir == m_dirs.end() || !dir->second.files.empty()) {
         return;
     }
-    QString url = m_binClipPaths[binId];
-    m_occurences[url].erase(binId);
-    m_binClipPaths.erase(binId);
-    if (m_occurences[url].empty()) {
-        m_fileWatcher->removeFile(url);
-        m_occurences.erase(url);
+    if (dir->second.registered && !dir->second.polled) {
+        m_fileWatcher->removeDir(path);
+        m_registeredDirs--;
     }
+    m_pendingDirs.removeAll(path);
+    m_dirs.erase(dir);
 }
 
-void FileWatcher::slotUrlModified(const QString &path)
+void FileWatcher::slotDirChanged(const QString &path)
 {
-    if (m_modifiedUrls.insert(path).second) {
-        for (const QString &id : m_occurences[path]) {
-            Q_EMIT binClipWaiting(id);
+    // We watch directories, find which of their files changed
+    QString dirPath = path;
+    if (m_dirs.count(dirPath) == 0) {
+        dirPath = QFileInfo(path).absolutePath();
+    }
+    auto dir = m_dirs.find(dirPath);
+    if (dir == m_dirs.end() || dir->second.polled) {
+        return;
+    }
+    // A file being written sends many notifications, compare the files once they settle
+    m_changedDirs.insert(dirPath);
+    if (!m_dirChangeTimer.isActive() && !m_dirStatWatcher.isRunning()) {
+        m_dirChangeTimer.start();
+    }
+}
+
+void FileWatcher::slotCheckChangedDirs()
+{
+    if (m_dirStatWatcher.isRunning()) {
+        // The running check will restart the timer when done
+        return;
+    }
+    QStringList paths;
+    for (const QString &path : m_changedDirs) {
+        auto dir = m_dirs.find(path);
+        if (dir != m_dirs.end() && !dir->second.polled) {
+            for (const QString &file : dir->second.files) {
+                paths << file;
+            }
         }
     }
-    if (!m_modifiedTimer.isActive()) {
-        m_modifiedTimer.start();
+    m_changedDirs.clear();
+    if (paths.isEmpty()) {
+        return;
+    }
+    // Large directories or network storage can be slow to read, do it in a worker thread like the polling
+    m_dirStatWatcher.setFuture(QtConcurrent::run([paths]() { return statFiles(paths); }));
+}
+
+void FileWatcher::slotChangedDirsChecked()
+{
+    applyStates(m_dirStatWatcher.result());
+    if (!m_changedDirs.empty() && !m_dirChangeTimer.isActive()) {
+        m_dirChangeTimer.start();
+    }
+}
+
+void FileWatcher::applyStates(const StatList &states)
+{
+    for (const auto &item : states) {
+        auto file = m_files.find(item.first);
+        if (file == m_files.end() || !(file->second.state != item.second)) {
+            continue;
+        }
+        const FileState previous = file->second.state;
+        file->second.state = item.second;
+        // Copy the ids, listeners may remove the clip
+        const std::unordered_set<QString> ids = file->second.binIds;
+        if (!item.second.exists) {
+            for (const QString &id : ids) {
+                Q_EMIT binClipMissing(id);
+            }
+        } else if (!previous.exists) {
+            for (const QString &id : ids) {
+                Q_EMIT binClipModified(id);
+            }
+        } else {
+            slotUrlModified(item.first);
+        }
     }
 }
 
-void FileWatcher::slotUrlAdded(const QString &path)
+void FileWatcher::slotPollDirs()
 {
-    for (const QString &id : m_occurences[path]) {
-        Q_EMIT binClipModified(id);
+    if (m_pollWatcher.isRunning()) {
+        return;
     }
+    QStringList paths;
+    for (const auto &dir : m_dirs) {
+        if (dir.second.polled) {
+            for (const QString &file : dir.second.files) {
+                paths << file;
+            }
+        }
+    }
+    if (paths.isEmpty()) {
+        m_pollTimer.stop();
+        return;
+    }
+    m_pollWatcher.setFuture(QtConcurrent::run([paths]() { return statFiles(paths); }));
+}
+
+void FileWatcher::slotPollDone()
+{
+    applyStates(m_pollWatcher.result());
 }
 
-void FileWatcher::slotUrlMissing(const QString &path)
+void FileWatcher::slotUrlModified(const QString &path)
 {
-    for (const QString &id : m_occurences[path]) {
-        Q_EMIT binClipMissing(id);
+    if (m_modifiedUrls.insert(path).second) {
+        auto file = m_files.find(path);
+        if (file != m_files.end()) {
+            for (const QString &id : file->second.binIds) {
+                Q_EMIT binClipWaiting(id);
+            }
+        }
+    }
+    if (!m_modifiedTimer.isActive()) {
+        m_modifiedTimer.start();
     }
 }
 
@@ -105,11 +348,16 @@ void FileWatcher::slotProcessModifiedUrls()
 {
     auto checkList = m_modifiedUrls;
     for (const QString &path : checkList) {
-        if (m_fileWatcher->ctime(path).msecsTo(QDateTime::currentDateTime()) > 2000) {
-            for (const QString &id : m_occurences[path]) {
+        if (QFileInfo(path).lastModified().msecsTo(QDateTime::currentDateTime()) > 2000) {
+            m_modifiedUrls.erase(path);
+            auto file = m_files.find(path);
+            if (file == m_files.end()) {
+                continue;
+            }
+            const std::unordered_set<QString> ids = file->second.binIds;
+            for (const QString &id : ids) {
                 Q_EMIT binClipModified(id);
             }
-            m_modifiedUrls.erase(path);
         }
     }
     if (m_modifiedUrls.empty()) {
@@ -120,10 +368,20 @@ void FileWatcher::slotProcessModifiedUrls()
 void FileWatcher::clear()
 {
     m_fileWatcher->stopScan();
-    for (const auto &f : m_occurences) {
-        m_fileWatcher->removeFile(f.first);
+    for (const auto &dir : m_dirs) {
+        if (dir.second.registered && !dir.second.polled) {
+            m_fileWatcher->removeDir(dir.first);
+        }
     }
-    m_occurences.clear();
+    m_files.clear();
+    m_dirs.clear();
+    m_pendingDirs.clear();
+    m_pendingUrls.clear();
+    m_statBatch.clear();
+    m_registeredDirs = 0;
+    m_pollTimer.stop();
+    m_changedDirs.clear();
+    m_dirChangeTimer.stop();
     m_modifiedUrls.clear();
     m_binClipPaths.clear();
     m_fileWatcher->startScan();
@@ -131,5 +389,18 @@ void FileWatcher::clear()
 
 bool FileWatcher::contains(const QString &path) const
 {
-    return m_fileWatcher->contains(path);
+    if (m_files.count(path) > 0) {
+        return true;
+    }
+    for (const auto &pending : m_pendingUrls) {
+        if (pending.second == path) {
+            return true;
+        }
+    }
+    for (const auto &item : m_statBatch) {
+        if (item.second == path) {
+            return true;
+        }
+    }
+    return false;
 }
@@ -7,13 +7,18 @@
 
 #include "definitions.h"
 #include <KDirWatch>
+#include <QFutureWatcher>
 #include <QTimer>
+#include <vector>
 #include <unordered_map>
 #include <unordered_set>
 
 /** @class FileWatcher
     @brief This class is responsible for watching all files used in the project
     and triggers a reload notification when a file changes.
+    Directories containing the files are watched rather than each file, a change notification
+    triggers a comparison of the size and modification time of the watched files in the directory.
+    Directories exceeding the system watch budget, or containing a huge number of watched files, are polled.
  */
 class FileWatcher : public QObject
 {
@@ -41,16 +46,45 @@ Q_SIGNALS:
 
 private Q_SLOTS:
     void slotUrlModified(const QString &path);
-    void slotUrlMissing(const QString &path);
-    void slotUrlAdded(const QString &path);
+    void slotDirChanged(const QString &path);
+    void slotCheckChangedDirs();
+    void slotChangedDirsChecked();
     void slotProcessModifiedUrls();
     void slotProcessQueue();
+    void slotRegisterFiles();
+    void slotPollDirs();
+    void slotPollDone();
 
 private:
+    /** @brief Last known state of a watched file */
+    struct FileState
+    {
+        qint64 size{-1};
+        qint64 modified{0};
+        bool exists{false};
+        bool operator!=(const FileState &other) const { return size != other.size || modified != other.modified || exists != other.exists; }
+    };
+    using StatList = std::vector<std::pair<QString, FileState>>;
+    struct WatchedFile
+    {
+        QString dir;
+        FileState state;
+        /// The clips using this file
+        std::unordered_set<QString> binIds;
+    };
+    struct WatchedDir
+    {
+        std::unordered_set<QString> files;
+        /// True if this directory is checked periodically instead of being registered in KDirWatch
+        bool polled{false};
+        bool registered{false};
+    };
     /// This is a handle to the watcher singleton, not owned by this class.
     std::unique_ptr<KDirWatch> m_fileWatcher;
-    /// A list with urls as keys, and the corresponding clip ids as value
-    std::unordered_map<QString, std::unordered_set<QString>> m_occurences;
+    /// Watched files, keys are paths
+    std::unordered_map<QString, WatchedFile> m_files;
+    /// Watched directories, keys are paths
+    std::unordered_map<QString, WatchedDir> m_dirs;
     /// keys are binId, keys are stored paths
     std::unordered_map<QString, QString> m_binClipPaths;
 
@@ -59,9 +93,32 @@ private:
 
     /// When loading a project or adding many clips, adding many files to the watcher causes a freeze, so queue them
     std::unordered_map<QString, QString> m_pendingUrls;
+    /// The queued files currently being checked in a worker thread, as (binId, path)
+    std::vector<std::pair<QString, QString>> m_statBatch;
+    /// Directories waiting to be registered in KDirWatch
+    QStringList m_pendingDirs;
+    QFutureWatcher<StatList> m_statWatcher;
+    QFutureWatcher<StatList> m_pollWatcher;
+    /// Directories notified as changed since their files were last compared
+    std::unordered_set<QString> m_changedDirs;
+    QFutureWatcher<StatList> m_dirStatWatcher;
+    /// Maximum number of directories registered in KDirWatch
+    int m_watchBudget;
+    int m_registeredDirs{0};
 
     QTimer m_modifiedTimer;
     QTimer m_queueTimer;
-    /// Add a file to the list of watched items
-    void doAddFile(const QString &binId, const QString &url);
+    QTimer m_pollTimer;
+    /// Groups the notifications received while a directory is written to
+    QTimer m_dirChangeTimer;
+    /** @brief Read the state of @param paths, can be called from any thread */
+    static StatList statFiles(const QStringList &paths);
+    /** @brief Returns the number of directories we allow ourselves to register in KDirWatch */
+    static int watchBudget();
+    /** @brief Compare the watched files with their @param states and send the notifications for the changed ones */
+    void applyStates(const StatList &states);
+    /** @brief Stop watching the file of @param binId if no other clip uses it */
+    void detachFile(const QString &binId);
+    /** @brief Stop watching @param dir if it does not contain watched files anymore */
+    void releaseDir(const QString &dir);
 };
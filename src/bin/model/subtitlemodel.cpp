@@ -82,7 +82,7 @@ void SubtitleModel::setStyle(const QString &style)
         return true;
     };
     redo();
-    pCore->pushUndo(undo, redo, i18n("Edit subtitle style"));
+    pCore->pushUndo(undo, redo, i18n("Edit subtitle style"), (style.size() + oldStyle.size()) * qint64(sizeof(QChar)));
 }
 
 const QString SubtitleModel::getStyle() const
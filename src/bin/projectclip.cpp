@@ -18,12 +18,15 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "jobs/cachetask.h"
 #include "jobs/cliploadtask.h"
 #include "jobs/proxytask.h"
+#include "jobs/sequencerendertask.h"
 #include "kdenlivesettings.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "mltcontroller/clippropertiescontroller.h"
 #include "model/markerlistmodel.hpp"
 #include "model/markersortmodel.h"
+#include "monitor/monitor.h"
+#include "monitor/monitormanager.h"
 #include "profiles/profilemodel.hpp"
 #include "project/projectmanager.h"
 #include "projectfolder.h"
@@ -42,6 +45,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <KMessageBox>
 #include <QApplication>
 #include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
 #include <QDomElement>
 #include <QFile>
@@ -112,6 +116,9 @@ ProjectClip::ProjectClip(const QString &id, const QIcon &thumb, const std::share
                 m_masterProducer->parent().set("kdenlive:uuid", m_sequenceUuid.toString().toUtf8().constData());
             }
             m_sequenceThumbFile.setFileTemplate(QDir::temp().absoluteFilePath(QStringLiteral("thumbs-%1-XXXXXX.mlt").arg(m_binId)));
+            m_sequenceRenderTimer.setSingleShot(true);
+            m_sequenceRenderTimer.setInterval(5000);
+            connect(&m_sequenceRenderTimer, &QTimer::timeout, this, &ProjectClip::startSequenceRender);
         }
         m_thumbnail = thumb;
     }
@@ -321,6 +328,60 @@ void ProjectClip::updateAudioThumbnail(bool cachedThumb)
     }
 }
 
+const QString ProjectClip::audioPeaksFile(int stream)
+{
+    QMutexLocker lock(&m_peaksMutex);
+    if (m_peaksFiles.contains(stream)) {
+        return m_peaksFiles.value(stream);
+    }
+    const PeaksState state = m_peaksStates.value(stream, PeaksState::Unknown);
+    if (state == PeaksState::Requested || state == PeaksState::Failed) {
+        return QString();
+    }
+    const ObjectId owner(ObjectType::BinClip, m_binId.toInt(), QUuid());
+    if (pCore->taskManager.hasPendingJob(owner, AbstractTask::AUDIOTHUMBJOB)) {
+        // Wait for the levels, which create the peaks when the clip is decoded
+        return QString();
+    }
+    const QString peaksPath = getAudioPeaksPath(stream);
+    if (!peaksPath.isEmpty() && QFile::exists(peaksPath)) {
+        m_peaksFiles.insert(stream, peaksPath);
+        m_peaksStates.remove(stream);
+        return peaksPath;
+    }
+    if (peaksPath.isEmpty() || state == PeaksState::Generated) {
+        // The peaks task could not create the file, don't decode the clip again
+        m_peaksStates.insert(stream, PeaksState::Failed);
+        return QString();
+    }
+    m_peaksStates.insert(stream, PeaksState::Requested);
+    QMetaObject::invokeMethod(
+        this,
+        [this, owner, stream]() {
+            if (pCore->taskManager.hasPendingJob(owner, AbstractTask::AUDIOTHUMBJOB)) {
+                // Another audio task started meanwhile, check again once it is done
+                QMutexLocker lock(&m_peaksMutex);
+                m_peaksStates.remove(stream);
+                return;
+            }
+            AudioLevelsTask::startPeaks(owner, this);
+        },
+        Qt::QueuedConnection);
+    return QString();
+}
+
+void ProjectClip::audioPeaksReady()
+{
+    QMutexLocker lock(&m_peaksMutex);
+    for (auto it = m_peaksStates.begin(); it != m_peaksStates.end(); ++it) {
+        if (it.value() == PeaksState::Requested) {
+            it.value() = PeaksState::Generated;
+        }
+    }
+    lock.unlock();
+    updateTimelineClips({TimelineModel::ReloadAudioThumbRole});
+}
+
 bool ProjectClip::audioThumbCreated() const
 {
     return (m_audioThumbCreated);
@@ -430,6 +491,79 @@ void ProjectClip::resetSequenceThumbnails()
     // updateTimelineClips({TimelineModel::ClipThumbRole});
 }
 
+void ProjectClip::invalidateSequenceRender()
+{
+    if (m_clipType != ClipType::Timeline) {
+        return;
+    }
+    if (m_sequenceRenderPending) {
+        m_sequenceRenderPending = false;
+        pCore->taskManager.discardJobs(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), AbstractTask::SEQUENCERENDERJOB);
+        m_sequenceRenderTimer.start();
+    } else if (m_sequenceRenderTimer.isActive()) {
+        // Still editing, postpone the render
+        m_sequenceRenderTimer.start();
+    }
+    if (m_sequenceRenderFile.isEmpty()) {
+        return;
+    }
+    m_sequenceRenderFile.clear();
+    // Switch the timeline instances back to the sequence, the timeline emitting this change may still be processing it
+    for (auto &p : m_videoProducers) {
+        m_effectStack->removeService(p.second);
+    }
+    m_videoProducers.clear();
+    QMetaObject::invokeMethod(this, [this]() { replaceInTimeline(); }, Qt::QueuedConnection);
+}
+
+void ProjectClip::startSequenceRender()
+{
+    if (!KdenliveSettings::sequencerendercache() || !m_sequenceRenderFile.isEmpty() || !isIncludedInTimeline()) {
+        return;
+    }
+    if (pCore->currentTimelineId() == m_sequenceUuid) {
+        // The sequence is being edited
+        m_sequenceRenderTimer.start();
+        return;
+    }
+    m_sequenceRenderPending = true;
+    SequenceRenderTask::start(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), this);
+}
+
+void ProjectClip::updateSequenceRender(const QString &path)
+{
+    if (!m_sequenceRenderPending) {
+        // The sequence changed while rendering
+        return;
+    }
+    m_sequenceRenderPending = false;
+    m_sequenceRenderFile = path;
+    for (auto &p : m_videoProducers) {
+        m_effectStack->removeService(p.second);
+    }
+    m_videoProducers.clear();
+    replaceInTimeline();
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::sequenceRenderProducer()
+{
+    if (m_sequenceRenderFile.isEmpty() || !KdenliveSettings::sequencerendercache()) {
+        return nullptr;
+    }
+    std::shared_ptr<Mlt::Producer> prod(new Mlt::Producer(pCore->getProjectProfile(), "avformat", m_sequenceRenderFile.toUtf8().constData()));
+    if (!prod->is_valid()) {
+        // The cache folder was cleaned
+        m_sequenceRenderFile.clear();
+        return nullptr;
+    }
+    int length = m_masterProducer->parent().get_length();
+    prod->set("length", length);
+    prod->set("out", length - 1);
+    prod->set("mute_on_pause", 0);
+    prod->set("kdenlive:id", m_binId.toUtf8().constData());
+    return prod;
+}
+
 void ProjectClip::reloadProducer(bool refreshOnly, bool isProxy, bool forceAudioReload)
 {
     // we find if there are some loading job on that clip
@@ -589,6 +723,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
     qDebug() << "################### ProjectClip::setproducer #################";
     // Discard running tasks for this producer
     QMutexLocker locker(&m_producerMutex);
+    m_lastUse = QDateTime::currentMSecsSinceEpoch();
     FileStatus::ClipStatus currentStatus = m_clipStatus;
     bool skipProducer = false;
     if (pCore->currentDoc()->useExternalProxy() && producer->get("kdenlive:proxy") != QLatin1String("-")) {
@@ -669,7 +804,31 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
         // Generate video thumb
         ClipLoadTask::start(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), QDomElement(), true, -1, -1, this);
     }
-    if (KdenliveSettings::audiothumbnails() &&
+    bool generateProxy = false;
+    QList<std::shared_ptr<ProjectClip>> clipList;
+    if (!m_usesProxy && pCore->currentDoc()->useProxy() && pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateproxy")).toInt() == 1) {
+        // automatic proxy generation enabled
+        if (m_clipType == ClipType::Image && pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateimageproxy")).toInt() == 1) {
+            if (getProducerIntProperty(QStringLiteral("meta.media.width")) >= KdenliveSettings::proxyimageminsize() &&
+                getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
+                clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
+            }
+        } else if (pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateproxy")).toInt() == 1 &&
+                   (m_clipType == ClipType::AV || m_clipType == ClipType::Video) && getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
+            if (!skipProducer && getProducerIntProperty(QStringLiteral("meta.media.width")) >= KdenliveSettings::proxyminsize()) {
+                clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
+            }
+        } else if (m_clipType == ClipType::Playlist && pCore->getCurrentFrameDisplaySize().width() >= KdenliveSettings::proxyminsize() &&
+                   getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
+            clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
+        }
+        if (!clipList.isEmpty()) {
+            generateProxy = true;
+        }
+    }
+    // When ingesting, the proxy task also creates the audio levels
+    bool ingest = generateProxy && KdenliveSettings::ingestpipeline() && m_clipType == ClipType::AV;
+    if (KdenliveSettings::audiothumbnails() && !ingest &&
         (m_clipType == ClipType::AV || m_clipType == ClipType::Audio || (m_hasAudio && m_clipType != ClipType::Timeline))) {
         AudioLevelsTask::start(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), this, false);
     }
@@ -709,28 +868,6 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool gene
     }
     replaceInTimeline();
     updateTimelineClips({TimelineModel::IsProxyRole});
-    bool generateProxy = false;
-    QList<std::shared_ptr<ProjectClip>> clipList;
-    if (!m_usesProxy && pCore->currentDoc()->useProxy() && pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateproxy")).toInt() == 1) {
-        // automatic proxy generation enabled
-        if (m_clipType == ClipType::Image && pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateimageproxy")).toInt() == 1) {
-            if (getProducerIntProperty(QStringLiteral("meta.media.width")) >= KdenliveSettings::proxyimageminsize() &&
-                getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
-                clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
-            }
-        } else if (pCore->currentDoc()->getDocumentProperty(QStringLiteral("generateproxy")).toInt() == 1 &&
-                   (m_clipType == ClipType::AV || m_clipType == ClipType::Video) && getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
-            if (!skipProducer && getProducerIntProperty(QStringLiteral("meta.media.width")) >= KdenliveSettings::proxyminsize()) {
-                clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
-            }
-        } else if (m_clipType == ClipType::Playlist && pCore->getCurrentFrameDisplaySize().width() >= KdenliveSettings::proxyminsize() &&
-                   getProducerProperty(QStringLiteral("kdenlive:proxy")) == QLatin1String()) {
-            clipList << std::static_pointer_cast<ProjectClip>(shared_from_this());
-        }
-        if (!clipList.isEmpty()) {
-            generateProxy = true;
-        }
-    }
     if (!generateProxy && KdenliveSettings::hoverPreview() &&
         (m_clipType == ClipType::AV || m_clipType == ClipType::Video || m_clipType == ClipType::Playlist)) {
         QTimer::singleShot(1000, this, [this]() { CacheTask::start(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), 30, 0, 0, this); });
@@ -820,6 +957,7 @@ void ProjectClip::setThumbProducer(std::shared_ptr<Mlt::Producer> prod)
 
 std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
 {
+    m_lastUse = QDateTime::currentMSecsSinceEpoch();
     if (m_thumbsProducer) {
         return m_thumbsProducer;
     }
@@ -1062,7 +1200,13 @@ std::shared_ptr<Mlt::Producer> ProjectClip::getTimelineProducer(int trackId, int
             }
             if (m_videoProducers.count(trackId) == 0) {
                 if (m_clipType == ClipType::Timeline) {
-                    std::shared_ptr<Mlt::Producer> prod(m_masterProducer->cut(0, -1));
+                    std::shared_ptr<Mlt::Producer> prod = sequenceRenderProducer();
+                    if (prod == nullptr) {
+                        prod.reset(m_masterProducer->cut(0, -1));
+                        if (KdenliveSettings::sequencerendercache() && !m_sequenceRenderTimer.isActive()) {
+                            m_sequenceRenderTimer.start();
+                        }
+                    }
                     m_videoProducers[trackId] = prod;
                 } else {
                     m_videoProducers[trackId] = cloneProducer(true, true);
@@ -1391,10 +1535,65 @@ void ProjectClip::saveZone(QPoint zone, const QDir &dir)
     xmlConsumer.run();
 }
 
+// static
+std::shared_ptr<Mlt::Producer> ProjectClip::directClone(Mlt::Producer &producer, bool removeEffects)
+{
+    const QString service = QString::fromLatin1(producer.get("mlt_service"));
+    if (service != QLatin1String("avformat") && service != QLatin1String("avformat-novalidate")) {
+        return nullptr;
+    }
+    // Only the normalizers added by the loader are recreated with the clone
+    for (int i = 0; i < producer.filter_count(); ++i) {
+        std::unique_ptr<Mlt::Filter> filter(producer.filter(i));
+        if (filter->get_int("_loader") == 0 && !(removeEffects && filter->property_exists("kdenlive_id"))) {
+            return nullptr;
+        }
+    }
+    bool isChain = producer.type() == mlt_service_chain_type;
+    if (isChain) {
+        Mlt::Chain chain(producer);
+        for (int i = 0; i < chain.link_count(); ++i) {
+            std::unique_ptr<Mlt::Link> link(chain.link(i));
+            if (link->get_int("_loader") == 0) {
+                return nullptr;
+            }
+        }
+    }
+    // The novalidate producer does not open the file until a frame is requested, the probe results are copied from the original
+    const QByteArray resource = QByteArray("avformat-novalidate:") + producer.get("resource");
+    std::shared_ptr<Mlt::Producer> prod;
+    if (isChain) {
+        prod = std::make_shared<Mlt::Chain>(pCore->getProjectProfile(), nullptr, resource.constData());
+    } else {
+        prod = std::make_shared<Mlt::Producer>(pCore->getProjectProfile(), nullptr, resource.constData());
+    }
+    if (!prod->is_valid()) {
+        return nullptr;
+    }
+    for (int i = 0; i < producer.count(); ++i) {
+        const char *name = producer.get_name(i);
+        const char *value = producer.get(i);
+        if (value == nullptr || name[0] == '_' || strcmp(name, "mlt_type") == 0 || strcmp(name, "mlt_service") == 0 || strcmp(name, "resource") == 0 ||
+            strcmp(name, "ignore_points") == 0) {
+            continue;
+        }
+        prod->set(name, value);
+    }
+    prod->set("mute_on_pause", 0);
+    return prod;
+}
+
 std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(bool removeEffects, bool timelineProducer)
 {
     Q_UNUSED(timelineProducer);
     QMutexLocker lk(&m_producerMutex);
+    m_masterProducer->lock();
+    std::shared_ptr<Mlt::Producer> directProd = directClone(*m_masterProducer.get(), removeEffects);
+    m_masterProducer->unlock();
+    if (directProd) {
+        directProd->set("id", nullptr);
+        return directProd;
+    }
     Mlt::Consumer c(pCore->getProjectProfile(), "xml", "string");
     Mlt::Service s(m_masterProducer->get_service());
     m_masterProducer->lock();
@@ -1475,6 +1674,10 @@ std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(bool removeEffects, bo
 
 std::shared_ptr<Mlt::Producer> ProjectClip::cloneProducer(const std::shared_ptr<Mlt::Producer> &producer)
 {
+    std::shared_ptr<Mlt::Producer> directProd = directClone(*producer.get(), false);
+    if (directProd) {
+        return directProd;
+    }
     Mlt::Consumer c(pCore->getProjectProfile(), "xml", "string");
     Mlt::Service s(producer->get_service());
     int ignore = s.get_int("ignore_points");
@@ -1505,7 +1708,24 @@ std::shared_ptr<Mlt::Producer> ProjectClip::softClone(const char *list)
 {
     QString service = QString::fromLatin1(m_masterProducer->get("mlt_service"));
     QString resource = QString::fromUtf8(m_masterProducer->get("resource"));
+    bool novalidate = service.startsWith(QLatin1String("avformat"));
+    if (novalidate) {
+        // Don't probe the file again, we pass the properties found by the master producer
+        service = QStringLiteral("avformat-novalidate");
+    }
     std::shared_ptr<Mlt::Producer> clone(new Mlt::Producer(pCore->thumbProfile(), service.toUtf8().constData(), resource.toUtf8().constData()));
+    if (novalidate) {
+        const char *prefix = "meta.";
+        const size_t prefix_len = strlen(prefix);
+        for (int i = 0; i < m_masterProducer->count(); ++i) {
+            char *current = m_masterProducer->get_name(i);
+            if (strlen(current) >= prefix_len && strncmp(current, prefix, prefix_len) == 0) {
+                clone->set(current, m_masterProducer->get(i));
+            }
+        }
+        clone->pass_list(*m_masterProducer.get(), "length,out,seekable,creation_time");
+        clone->set("mute_on_pause", 0);
+    }
     Mlt::Filter scaler(pCore->thumbProfile(), "swscale");
     Mlt::Filter converter(pCore->getProjectProfile(), "avcolor_space");
     clone->attach(scaler);
@@ -2061,6 +2281,13 @@ void ProjectClip::discardAudioThumb()
         if (!audioThumbPath.isEmpty()) {
             QFile::remove(audioThumbPath);
         }
+        const QString peaksPath = getAudioPeaksPath(st);
+        if (!peaksPath.isEmpty()) {
+            QFile::remove(peaksPath);
+        }
+        QMutexLocker lock(&m_peaksMutex);
+        m_peaksFiles.remove(st);
+        m_peaksStates.remove(st);
         // Clear audio cache
         QString key = QString("%1:%2").arg(m_binId).arg(st);
         pCore->audioThumbCache.insert(key, QByteArray("-"));
@@ -2112,6 +2339,16 @@ const QString ProjectClip::getAudioThumbPath(int stream)
     return audioPath;
 }
 
+const QString ProjectClip::getAudioPeaksPath(int stream)
+{
+    const QString audioPath = getAudioThumbPath(stream);
+    if (audioPath.isEmpty()) {
+        return QString();
+    }
+    // Peaks are indexed by sample, they don't depend on the project frame rate
+    return audioPath.section(QLatin1Char('_'), 0, -3) + QStringLiteral("_audio.peaks");
+}
+
 QStringList ProjectClip::updatedAnalysisData(const QString &name, const QString &data, int offset)
 {
     if (data.isEmpty()) {
@@ -2459,6 +2696,12 @@ void ProjectClip::copyTimeWarpProducers(const QDir sequenceFolder, bool copy)
 
 void ProjectClip::reloadTimeline()
 {
+    if (m_sequenceRenderPending || !m_sequenceRenderFile.isEmpty()) {
+        // All instances are replaced below, they will use the sequence until its intermediate is rendered again
+        pCore->taskManager.discardJobs(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()), AbstractTask::SEQUENCERENDERJOB);
+        m_sequenceRenderPending = false;
+        m_sequenceRenderFile.clear();
+    }
     if (pCore->bin()) {
         pCore->bin()->reloadMonitorIfActive(m_binId);
     }
@@ -2507,6 +2750,77 @@ bool ProjectClip::isIncludedInTimeline()
     return m_registeredClips.size() > 0;
 }
 
+bool ProjectClip::releaseIdleProducers()
+{
+    // Keep producers that were requested recently, they are likely to be requested again
+    if (!statusReady() || isIncludedInTimeline() || !m_masterProducer || QDateTime::currentMSecsSinceEpoch() - m_lastUse < 60000) {
+        return false;
+    }
+    if (m_clipType == ClipType::Timeline) {
+        // A sequence with an open timeline uses its producers
+        if (pCore->currentDoc() == nullptr || pCore->currentDoc()->getTimelinesUuids().contains(m_sequenceUuid)) {
+            return false;
+        }
+    } else if (m_clipType != ClipType::AV && m_clipType != ClipType::Audio && m_clipType != ClipType::Video) {
+        return false;
+    }
+    if (pCore->monitorManager() && pCore->monitorManager()->clipMonitor()->activeClipId() == m_binId) {
+        return false;
+    }
+    if (pCore->taskManager.hasPendingJob(ObjectId(ObjectType::BinClip, m_binId.toInt(), QUuid()))) {
+        return false;
+    }
+    QMutexLocker lock(&m_thumbMutex);
+    if (m_thumbsProducer && m_thumbsProducer.use_count() > 1) {
+        // Used by a thumbnail request
+        return false;
+    }
+    m_thumbsProducer.reset();
+    closeDecoders(m_masterProducer);
+    return true;
+}
+
+// static
+void ProjectClip::closeDecoders(const std::shared_ptr<Mlt::Producer> &producer)
+{
+    if (!producer || !producer->is_valid()) {
+        return;
+    }
+    if (producer->is_cut()) {
+        closeDecoders(std::make_shared<Mlt::Producer>(producer->parent()));
+        return;
+    }
+    // Sequences: close the decoders of all the clips in their tracks
+    if (producer->type() == mlt_service_tractor_type) {
+        Mlt::Tractor tractor(*producer.get());
+        for (int i = 0; i < tractor.count(); ++i) {
+            closeDecoders(std::shared_ptr<Mlt::Producer>(tractor.track(i)));
+        }
+        return;
+    }
+    if (producer->type() == mlt_service_playlist_type) {
+        Mlt::Playlist playlist(*producer.get());
+        for (int i = 0; i < playlist.count(); ++i) {
+            std::shared_ptr<Mlt::Producer> clip(playlist.get_clip(i));
+            if (clip && !clip->is_blank()) {
+                closeDecoders(clip);
+            }
+        }
+        return;
+    }
+    if (!QString(producer->get("mlt_service")).startsWith(QLatin1String("avformat"))) {
+        return;
+    }
+    // The avformat producer keeps its decoders and image cache in the MLT service cache, purging it closes the file
+    if (producer->type() == mlt_service_chain_type) {
+        Mlt::Chain chain(*producer.get());
+        Mlt::Producer source = chain.get_source();
+        mlt_service_cache_purge(source.get_service());
+    } else {
+        mlt_service_cache_purge(producer->get_service());
+    }
+}
+
 void ProjectClip::replaceInTimeline()
 {
     int updatedDuration = m_resetTimelineOccurences ? getFramePlaytime() : -1;
@@ -18,6 +18,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QTemporaryFile>
 #include <QTimer>
 #include <QUuid>
+#include <atomic>
 #include <memory>
 
 class ClipPropertiesController;
@@ -187,6 +188,11 @@ public:
     void discardAudioThumb();
     /** @brief Get path for this clip's audio thumbnail */
     const QString getAudioThumbPath(int stream);
+    /** @brief Get path for the peaks file of this clip's audio @param stream, used to draw zoomed in waveforms */
+    const QString getAudioPeaksPath(int stream);
+    /** @brief Returns the peaks file of audio @param stream if it exists. Otherwise it is created in the background, once per stream, and an empty string
+        is returned. Thread safe, called when painting the waveforms */
+    const QString audioPeaksFile(int stream);
     /** @brief Returns true if this producer has audio and can be splitted on timeline*/
     bool isSplittable() const;
 
@@ -194,6 +200,13 @@ public:
         Note that this function does not account for children, use TreeItem::accumulate if you want to get that information as well.
     */
     bool isIncludedInTimeline() override;
+    /** @brief Release the thumbnail producer and the decoders of this clip if it is not used in a timeline, the clip monitor or a task.
+     *  For sequence clips, the decoders of their clips are released when the sequence is not open.
+     *  Only the clip metadata is kept, MLT reopens the file on the next frame request.
+     *  @returns true if something was released */
+    bool releaseIdleProducers();
+    /** @brief Close the decoders opened by an avformat @param producer, or by the clips of a sequence, they are reopened when a frame is requested */
+    static void closeDecoders(const std::shared_ptr<Mlt::Producer> &producer);
     /** @brief Returns a list of all timeline clip ids for this bin clip */
     QList<int> timelineInstances(QUuid activeUuid = QUuid()) const;
     QMap<QUuid, QList<int>> getAllTimelineInstances() const;
@@ -273,6 +286,8 @@ public:
     /** @brief Get the sequence's unique identifier, empty if not a sequence clip. */
     const QUuid &getSequenceUuid() const;
     void resetSequenceThumbnails();
+    /** @brief The nested sequence changed, switch its timeline instances back to the sequence and schedule a new render of the intermediate */
+    void invalidateSequenceRender();
     /** @brief Returns the clip name (usually file name) */
     QString clipName();
     /** @brief Save an xml playlist of current clip with in/out points as zone.x()/y() */
@@ -303,6 +318,8 @@ public Q_SLOTS:
     /** @brief Store the audio thumbnails once computed. Note that the parameter is a value and not a reference, fill free to use it as a sink (use std::move to
      * avoid copy). */
     void updateAudioThumbnail(bool cachedThumb);
+    /** @brief The peaks task finished, check its files and repaint the waveforms */
+    void audioPeaksReady();
     /** @brief Delete the proxy file */
     void deleteProxy(bool reloadClip = true);
     /** @brief A clip job progressed, update display */
@@ -314,6 +331,8 @@ public Q_SLOTS:
 
     /** @brief A proxy clip is available or disabled, update path and reload */
     void updateProxyProducer(const QString &path);
+    /** @brief The rendered intermediate of this sequence clip is available in @param path, use it in timeline */
+    void updateSequenceRender(const QString &path);
 
     /** @brief Request updating some clip droles */
     void updateTimelineClips(const QVector<int> &roles);
@@ -346,11 +365,20 @@ private:
     QMutex m_thumbMutex;
     const QString geometryWithOffset(const QString &data, int offset);
     QMap <QString, QByteArray> m_audioLevels;
+    /** @brief The existing peaks file of each audio stream */
+    QMap<int, QString> m_peaksFiles;
+    /** @brief Progress of the missing peaks files, so that they are only checked and created once */
+    enum class PeaksState { Unknown, Requested, Generated, Failed };
+    QMap<int, PeaksState> m_peaksStates;
+    QMutex m_peaksMutex;
     /** @brief If true, all timeline occurrences of this clip will be replaced from a fresh producer on reload. */
     bool m_resetTimelineOccurences;
 
     /** @brief This is a helper function that creates the disabled producer. This is a clone of the original one, with audio and video disabled */
     void createDisabledMasterProducer();
+    /** @brief Clone an avformat @param producer by copying its properties, sharing its probe results instead of opening the file again
+     *  @returns nullptr if the producer has effects, links or a service that can only be cloned through its xml description */
+    static std::shared_ptr<Mlt::Producer> directClone(Mlt::Producer &producer, bool removeEffects);
 
     std::map<int, std::weak_ptr<TimelineModel>> m_registeredClips;
     uint m_audioCount;
@@ -362,11 +390,23 @@ private:
     std::unordered_map<int, std::shared_ptr<Mlt::Producer>> m_videoProducers;
     std::unordered_map<int, std::shared_ptr<Mlt::Producer>> m_timewarpProducers;
     std::shared_ptr<Mlt::Producer> m_disabledProducer;
+    /** @brief Time (msecs since epoch) when the producers of this clip were last requested, used to find idle clips */
+    std::atomic<qint64> m_lastUse{0};
     // A temporary uuid used to reset thumbnails on producer change
     QUuid m_uuid;
     // The sequence unique identifier
     QUuid m_sequenceUuid;
     QTemporaryFile m_sequenceThumbFile;
+    /** @brief The rendered intermediate used by the video timeline producers of this sequence clip, empty if none is valid */
+    QString m_sequenceRenderFile;
+    /** @brief True while a render of the intermediate was requested and not invalidated since */
+    bool m_sequenceRenderPending{false};
+    /** @brief Delay the render of the intermediate until the sequence is no longer being edited */
+    QTimer m_sequenceRenderTimer;
+    /** @brief Start the render of the intermediate if the sequence is used in a timeline and not being edited */
+    void startSequenceRender();
+    /** @brief Returns a producer playing the rendered intermediate, nullptr if none is valid */
+    std::shared_ptr<Mlt::Producer> sequenceRenderProducer();
     /** @brief Update the clip description from the properties. */
     void updateDescription();
 
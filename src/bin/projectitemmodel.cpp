@@ -23,6 +23,10 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectclip.h"
 #include "projectfolder.h"
 #include "projectsubclip.h"
+#include "timeline2/model/timelineitemmodel.hpp"
+#include "timeline2/view/previewmanager.h"
+#include "utils/decoderpool.h"
+#include "utils/sysinfo.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
 
@@ -57,6 +61,9 @@ ProjectItemModel::ProjectItemModel(QObject *parent)
     connect(m_fileWatcher.get(), &FileWatcher::binClipModified, this, &ProjectItemModel::reloadClip);
     connect(m_fileWatcher.get(), &FileWatcher::binClipWaiting, this, &ProjectItemModel::setClipWaiting);
     connect(m_fileWatcher.get(), &FileWatcher::binClipMissing, this, &ProjectItemModel::setClipInvalid);
+    m_idleTimer.setInterval(30000);
+    connect(&m_idleTimer, &QTimer::timeout, this, &ProjectItemModel::releaseIdleProducers);
+    m_idleTimer.start();
 }
 
 std::shared_ptr<ProjectItemModel> ProjectItemModel::construct(QObject *parent)
@@ -503,6 +510,13 @@ double ProjectItemModel::getAudioMaxLevel(const QString &binId, int stream)
     return 0;
 }
 
+QString ProjectItemModel::getAudioPeaksPathByBinID(const QString &binId, int stream)
+{
+    READ_LOCK();
+    std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
+    return clip ? clip->audioPeaksFile(stream) : QString();
+}
+
 bool ProjectItemModel::hasClip(const QString &binId)
 {
     READ_LOCK();
@@ -1043,6 +1057,32 @@ std::vector<QString> ProjectItemModel::getAllClipIds() const
     return result;
 }
 
+void ProjectItemModel::releaseIdleProducers()
+{
+    if (closing) {
+        return;
+    }
+    SysMemInfo meminfo = SysMemInfo::getMemoryInfo();
+    bool lowMemory = meminfo.isSuccessful() && meminfo.availableMemory() <= qMin(1024, meminfo.totalMemory() / 5);
+    // Idle clips also release their files when the process gets close to its open file limit
+    if (!lowMemory && !DecoderPool::underPressure()) {
+        return;
+    }
+    int released = 0;
+    const std::vector<QString> ids = getAllClipIds();
+    for (const QString &id : ids) {
+        std::shared_ptr<ProjectClip> clip = getClipByBinID(id);
+        if (clip && clip->releaseIdleProducers()) {
+            released++;
+        }
+    }
+    if (released > 0) {
+        const DecoderPool::Occupancy usage = DecoderPool::occupancy();
+        qCDebug(KDENLIVE_LOG) << "Resource pressure:" << meminfo.availableMemory() << "MB free," << usage.openFiles << "/" << usage.fileLimit
+                              << "open files, released producers of" << released << "idle clips";
+    }
+}
+
 void ProjectItemModel::updateCacheThumbnail(std::unordered_map<QString, std::vector<int>> &thumbData)
 {
     READ_LOCK();
@@ -1443,6 +1483,19 @@ const QString ProjectItemModel::sceneList(const QString &root, const QString &fu
     }
     m_projectTractor->insert_track(*activeTractor->cut(0, duration), 0);
 
+    // Preview chunks rendered in memory cannot be reloaded, keep them out of the saved sequences
+    QMap<QUuid, QMap<int, std::shared_ptr<Mlt::Producer>>> ramChunks;
+    KdenliveDoc *doc = pCore->currentDoc();
+    if (doc) {
+        const QList<QUuid> uuids = doc->getTimelinesUuids();
+        for (const QUuid &uuid : uuids) {
+            std::shared_ptr<TimelineItemModel> timeline = doc->getTimeline(uuid);
+            if (timeline && timeline->hasTimelinePreview()) {
+                ramChunks.insert(uuid, timeline->previewManager()->takeRamChunks());
+            }
+        }
+    }
+
     Mlt::Service s(m_projectTractor->get_service());
     std::unique_ptr<Mlt::Filter> filter = nullptr;
     if (!filterData.isEmpty()) {
@@ -1456,6 +1509,14 @@ const QString ProjectItemModel::sceneList(const QString &root, const QString &fu
     if (filter) {
         s.detach(*filter.get());
     }
+    QMapIterator<QUuid, QMap<int, std::shared_ptr<Mlt::Producer>>> i(ramChunks);
+    while (i.hasNext()) {
+        i.next();
+        std::shared_ptr<TimelineItemModel> timeline = doc->getTimeline(i.key());
+        if (timeline && timeline->hasTimelinePreview()) {
+            timeline->previewManager()->restoreRamChunks(i.value());
+        }
+    }
     playlist = fullPath.isEmpty() ? QString::fromUtf8(xmlConsumer.get("kdenlive_playlist")) : fullPath;
     return playlist;
 }
@@ -18,6 +18,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QIcon>
 #include <QReadWriteLock>
 #include <QSize>
+#include <QTimer>
 #include <QUuid>
 
 class BinPlaylist;
@@ -59,6 +60,8 @@ public:
     /** @brief Returns audio levels for a clip from its id */
     const QVector <uint8_t>getAudioLevelsByBinID(const QString &binId, int stream);
     double getAudioMaxLevel(const QString &binId, int stream);
+    /** @brief Returns the path of the audio peaks file of a clip from its id, empty while it is not available */
+    QString getAudioPeaksPathByBinID(const QString &binId, int stream);
 
     /** @brief Returns a list of clips using the given url */
     QStringList getClipByUrl(const QFileInfo &url) const;
@@ -241,6 +244,8 @@ public:
     void setSequencesFolder(int id);
     /** @brief Remove clip references for a timeline. */
     void removeReferencedClips(const QUuid &uuid);
+    /** @brief When the system is low on memory or open files, release the producers of the clips that are not used anywhere */
+    void releaseIdleProducers();
 
 protected:
     bool closing;
@@ -290,6 +295,8 @@ private:
     QUuid m_uuid;
     /** @brief The id of the folder where new sequences will be created, -1 if none */
     int m_sequenceFolderId;
+    /** @brief Periodically checks memory and open files pressure to release idle clip producers */
+    QTimer m_idleTimer;
 
 Q_SIGNALS:
     /** @brief thumbs of the given clip were modified, request update of the monitor if need be */
@@ -8,6 +8,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "projectsortproxymodel.h"
 #include "abstractprojectitem.h"
 
+#include <QDateTime>
 #include <QItemSelectionModel>
 
 ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
@@ -21,82 +22,198 @@ ProjectSortProxyModel::ProjectSortProxyModel(QObject *parent)
     setDynamicSortFilter(true);
 }
 
+void ProjectSortProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    for (const auto &connection : qAsConst(m_sourceConnections)) {
+        disconnect(connection);
+    }
+    m_sourceConnections.clear();
+    m_searchIndex.clear();
+    m_acceptedItself.clear();
+    m_acceptedTree.clear();
+    m_textSortKeys.clear();
+    m_numberSortKeys.clear();
+    if (model) {
+        // Connected before the base class so that our index is up to date when it filters again
+        m_sourceConnections << connect(model, &QAbstractItemModel::dataChanged, this,
+                                       [this](const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &) {
+                                           if (!topLeft.isValid()) {
+                                               return;
+                                           }
+                                           for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+                                               invalidateItem(sourceModel()->index(row, 0, topLeft.parent()));
+                                           }
+                                       });
+        m_sourceConnections << connect(model, &QAbstractItemModel::rowsInserted, this, [this](const QModelIndex &parent, int, int) {
+            // New items may change the result of their ancestors
+            invalidateItem(parent);
+        });
+        m_sourceConnections << connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this, [this](const QModelIndex &parent, int first, int last) {
+            for (int row = first; row <= last; ++row) {
+                invalidateItem(sourceModel()->index(row, 0, parent), true);
+            }
+        });
+        m_sourceConnections << connect(model, &QAbstractItemModel::rowsRemoved, this, [this](const QModelIndex &parent, int, int) { invalidateItem(parent); });
+        m_sourceConnections << connect(model, &QAbstractItemModel::rowsMoved, this, [this](const QModelIndex &parent, int, int, const QModelIndex &destination, int) {
+            invalidateItem(parent);
+            invalidateItem(destination);
+        });
+        m_sourceConnections << connect(model, &QAbstractItemModel::modelAboutToBeReset, this, [this]() {
+            m_searchIndex.clear();
+            m_acceptedItself.clear();
+            m_acceptedTree.clear();
+            m_textSortKeys.clear();
+            m_numberSortKeys.clear();
+        });
+    }
+    QSortFilterProxyModel::setSourceModel(model);
+}
+
+const ProjectSortProxyModel::SearchEntry &ProjectSortProxyModel::searchEntry(const QModelIndex &sourceIndex) const
+{
+    auto cached = m_searchIndex.find(sourceIndex.internalId());
+    if (cached != m_searchIndex.end()) {
+        return cached->second;
+    }
+    const QAbstractItemModel *model = sourceModel();
+    const int row = sourceIndex.row();
+    const QModelIndex parent = sourceIndex.parent();
+    SearchEntry entry;
+    // Columns 0 to 2 contain the name, date and description
+    QStringList text;
+    for (int i = 0; i < 3; i++) {
+        text << model->data(model->index(row, i, parent)).toString();
+    }
+    entry.text = text.join(QLatin1Char('\n')).toCaseFolded();
+    // Column 3 contains the item type (video, image, title, etc)
+    entry.clipType = model->data(model->index(row, 3, parent)).toInt();
+    // Column 4 contains the item tag data
+    entry.tags = model->data(model->index(row, 4, parent)).toString().toCaseFolded();
+    // Column 7 contains the rating
+    entry.rating = model->data(model->index(row, 7, parent)).toInt();
+    // Column 8 contains the usage
+    entry.usage = model->data(model->index(row, 8, parent)).toInt();
+    entry.itemType = model->data(sourceIndex, AbstractProjectItem::ItemTypeRole).toInt();
+    return m_searchIndex.emplace(sourceIndex.internalId(), entry).first->second;
+}
+
+void ProjectSortProxyModel::invalidateItem(const QModelIndex &sourceIndex, bool recursive)
+{
+    if (!sourceIndex.isValid()) {
+        return;
+    }
+    const quintptr id = sourceIndex.internalId();
+    m_searchIndex.erase(id);
+    m_acceptedItself.erase(id);
+    const quint64 keyId = sortKeyId(sourceIndex.siblingAtColumn(0));
+    for (int column = 0; column < sourceModel()->columnCount(sourceIndex.parent()); ++column) {
+        m_textSortKeys.erase(keyId + quint64(column));
+        m_numberSortKeys.erase(keyId + quint64(column));
+    }
+    if (recursive) {
+        const int children = sourceModel()->rowCount(sourceIndex);
+        for (int i = 0; i < children; ++i) {
+            invalidateItem(sourceModel()->index(i, 0, sourceIndex), true);
+        }
+    }
+    // The result of the ancestors depends on this item
+    for (QModelIndex ix = sourceIndex; ix.isValid(); ix = ix.parent()) {
+        m_acceptedTree.erase(ix.internalId());
+    }
+}
+
+void ProjectSortProxyModel::invalidateFilterCache(bool narrowed)
+{
+    m_acceptedTree.clear();
+    if (!narrowed) {
+        m_acceptedItself.clear();
+        return;
+    }
+    // Items rejected by the previous filter stay rejected, only the accepted ones must be checked again
+    for (auto it = m_acceptedItself.begin(); it != m_acceptedItself.end();) {
+        if (it->second) {
+            it = m_acceptedItself.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
 // Responsible for item sorting!
 bool ProjectSortProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
-    if (filterAcceptsRowItself(sourceRow, sourceParent)) {
-        return true;
+    const QModelIndex item = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!item.isValid()) {
+        return false;
+    }
+    // Results are cached, so that each item is only evaluated once when the view filters all levels
+    auto cached = m_acceptedTree.find(item.internalId());
+    if (cached != m_acceptedTree.end()) {
+        return cached->second;
     }
     // accept if any of the children is accepted on it's own merits
-    return hasAcceptedChildren(sourceRow, sourceParent);
+    bool accepted = filterAcceptsRowItself(sourceRow, sourceParent) || hasAcceptedChildren(sourceRow, sourceParent);
+    m_acceptedTree[item.internalId()] = accepted;
+    return accepted;
 }
 
 bool ProjectSortProxyModel::filterAcceptsRowItself(int sourceRow, const QModelIndex &sourceParent) const
 {
-    if (m_usageFilter != UsageFilter::All) {
-        // Column 8 contains the usage
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 8, sourceParent);
-        int usageCount = sourceModel()->data(indexTag).toInt();
-        if ((usageCount > 0 && m_usageFilter == UsageFilter::Unused) || (usageCount == 0 && m_usageFilter == UsageFilter::Used)) {
-            return false;
-        }
+    const QModelIndex item = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (!item.isValid()) {
+        return false;
     }
-    bool result = false;
-    if (!m_searchRating.isEmpty()) {
-        // Column 7 contains the rating
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 7, sourceParent);
-        if (!m_searchRating.contains(sourceModel()->data(indexTag).toInt())) {
-            return false;
-        }
-        result = true;
+    auto cached = m_acceptedItself.find(item.internalId());
+    if (cached != m_acceptedItself.end()) {
+        return cached->second;
     }
-    if (!m_searchType.isEmpty()) {
-        // Column 3 contains the item type (video, image, title, etc)
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 3, sourceParent);
-        if (!m_searchType.contains(sourceModel()->data(indexTag).toInt())) {
-            return false;
+    const SearchEntry &entry = searchEntry(item);
+    auto accept = [&]() {
+        if (m_usageFilter != UsageFilter::All) {
+            if ((entry.usage > 0 && m_usageFilter == UsageFilter::Unused) || (entry.usage == 0 && m_usageFilter == UsageFilter::Used)) {
+                return false;
+            }
+        }
+        bool result = false;
+        if (!m_searchRating.isEmpty()) {
+            if (!m_searchRating.contains(entry.rating)) {
+                return false;
+            }
+            result = true;
+        }
+        if (!m_searchType.isEmpty()) {
+            if (!m_searchType.contains(entry.clipType)) {
+                return false;
+            }
+            result = true;
         }
-        result = true;
-    }
-    if (!m_searchTag.isEmpty()) {
-        // Column 4 contains the item tag data
-        QModelIndex indexTag = sourceModel()->index(sourceRow, 4, sourceParent);
-        auto tagData = sourceModel()->data(indexTag);
-        bool found = false;
-        for (const QString &tag : m_searchTag) {
-            if (tag == QLatin1Char('#')) {
-                // a single # means we are looking for clips without tags
-                if (tagData.toString().isEmpty()) {
+        if (!m_searchTag.isEmpty()) {
+            bool found = false;
+            for (const QString &tag : m_searchTag) {
+                if (tag == QLatin1Char('#')) {
                     // a single # means we are looking for clips without tags
+                    if (entry.tags.isEmpty()) {
+                        found = true;
+                        break;
+                    }
+                } else if (entry.tags.contains(tag)) {
                     found = true;
                     break;
                 }
-            } else if (tagData.toString().contains(tag, Qt::CaseInsensitive)) {
-                found = true;
-                break;
             }
-        }
-        if (!found) {
-            return false;
-        }
-        result = true;
-    }
-
-    if (result && m_searchString.isEmpty()) {
-        return true;
-    }
-    for (int i = 0; i < 3; i++) {
-        QModelIndex index0 = sourceModel()->index(sourceRow, i, sourceParent);
-        if (!index0.isValid()) {
-            return false;
-        }
-        auto data = sourceModel()->data(index0);
-        if (data.toString().contains(m_searchString, Qt::CaseInsensitive)) {
+            if (!found) {
+                return false;
+            }
             result = true;
-            break;
         }
-    }
-    return result;
+        if (result && m_searchString.isEmpty()) {
+            return true;
+        }
+        return result || entry.text.contains(m_searchString);
+    };
+    const bool accepted = accept();
+    m_acceptedItself[item.internalId()] = accepted;
+    return accepted;
 }
 
 bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex &source_parent) const
@@ -113,41 +230,67 @@ bool ProjectSortProxyModel::hasAcceptedChildren(int sourceRow, const QModelIndex
     }
 
     for (int i = 0; i < childCount; ++i) {
-        if (filterAcceptsRowItself(i, item)) {
-            return true;
-        }
-        // recursive call -> NOTICE that this is depth-first searching, you're probably better off with breadth first search...
-        if (hasAcceptedChildren(i, item)) {
+        // Cached, so the children results are reused when the view filters them
+        if (filterAcceptsRow(i, item)) {
             return true;
         }
     }
     return false;
 }
 
-bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+// static
+quint64 ProjectSortProxyModel::sortKeyId(const QModelIndex &sourceIndex)
 {
-    // Check item type (folder or clip) as defined in projectitemmodel
-    int leftType = sourceModel()->data(left, AbstractProjectItem::ItemTypeRole).toInt();
-    int rightType = sourceModel()->data(right, AbstractProjectItem::ItemTypeRole).toInt();
-    if (leftType == rightType) {
-        // Let the normal alphabetical sort happen
-        const QVariant leftData = sourceModel()->data(left, Qt::DisplayRole);
-        const QVariant rightData = sourceModel()->data(right, Qt::DisplayRole);
+    return (quint64(sourceIndex.internalId()) << 8) + quint64(sourceIndex.column());
+}
+
+void ProjectSortProxyModel::cacheSortKey(const QModelIndex &sourceIndex) const
+{
+    const quint64 keyId = sortKeyId(sourceIndex);
+    if (m_textSortKeys.count(keyId) > 0 || m_numberSortKeys.count(keyId) > 0) {
+        return;
+    }
+    const QVariant data = sourceModel()->data(sourceIndex, Qt::DisplayRole);
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        if (leftData.type() == QVariant::DateTime) {
+    if (data.type() == QVariant::DateTime) {
 #else
-        if (leftData.typeId() == QMetaType::QDateTime) {
+    if (data.typeId() == QMetaType::QDateTime) {
 #endif
-            return leftData.toDateTime() < rightData.toDateTime();
-        }
+        m_numberSortKeys.emplace(keyId, data.toDateTime().toMSecsSinceEpoch());
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        if (leftData.type() == QVariant::Int) {
+    } else if (data.type() == QVariant::Int) {
 #else
-        if (leftData.typeId() == QMetaType::Int) {
+    } else if (data.typeId() == QMetaType::Int) {
 #endif
-            return leftData.toInt() < rightData.toInt();
+        m_numberSortKeys.emplace(keyId, data.toInt());
+    } else {
+        m_textSortKeys.emplace(keyId, m_collator.sortKey(data.toString()));
+    }
+}
+
+bool ProjectSortProxyModel::lessThan(const QModelIndex &left, const QModelIndex &right) const
+{
+    // Check item type (folder or clip) as defined in projectitemmodel
+    int leftType = searchEntry(left.siblingAtColumn(0)).itemType;
+    int rightType = searchEntry(right.siblingAtColumn(0)).itemType;
+    if (leftType == rightType) {
+        // Let the normal alphabetical sort happen, on precomputed keys
+        cacheSortKey(left);
+        cacheSortKey(right);
+        const quint64 leftKey = sortKeyId(left);
+        const quint64 rightKey = sortKeyId(right);
+        auto leftNumber = m_numberSortKeys.find(leftKey);
+        auto rightNumber = m_numberSortKeys.find(rightKey);
+        if (leftNumber != m_numberSortKeys.end() && rightNumber != m_numberSortKeys.end()) {
+            return leftNumber->second < rightNumber->second;
+        }
+        auto leftText = m_textSortKeys.find(leftKey);
+        auto rightText = m_textSortKeys.find(rightKey);
+        if (leftText != m_textSortKeys.end() && rightText != m_textSortKeys.end()) {
+            return leftText->second.compare(rightText->second) < 0;
         }
-        return m_collator.compare(leftData.toString(), rightData.toString()) < 0;
+        // Mixed data types
+        return m_collator.compare(sourceModel()->data(left).toString(), sourceModel()->data(right).toString()) < 0;
     }
     if (sortOrder() == Qt::AscendingOrder) {
         return leftType < rightType;
@@ -162,7 +305,10 @@ QItemSelectionModel *ProjectSortProxyModel::selectionModel()
 
 void ProjectSortProxyModel::slotSetSearchString(const QString &str)
 {
-    m_searchString = str;
+    const QString searchString = str.toCaseFolded();
+    // When typing, the new string extends the previous one so items that did not match still don't match
+    invalidateFilterCache(!m_searchString.isEmpty() && searchString.contains(m_searchString));
+    m_searchString = searchString;
     invalidateFilter();
 }
 
@@ -170,8 +316,12 @@ void ProjectSortProxyModel::slotSetFilters(const QStringList &tagFilters, const
 {
     m_searchType = typeFilters;
     m_searchRating = rateFilters;
-    m_searchTag = tagFilters;
+    m_searchTag.clear();
+    for (const QString &tag : tagFilters) {
+        m_searchTag << tag.toCaseFolded();
+    }
     m_usageFilter = unusedFilter;
+    invalidateFilterCache(false);
     invalidateFilter();
 }
 
@@ -181,6 +331,7 @@ void ProjectSortProxyModel::slotClearSearchFilters()
     m_searchRating.clear();
     m_searchType.clear();
     m_usageFilter = UsageFilter::All;
+    invalidateFilterCache(false);
     invalidateFilter();
 }
 
@@ -8,7 +8,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #pragma once
 
 #include <QCollator>
+#include <QCollatorSortKey>
 #include <QSortFilterProxyModel>
+#include <unordered_map>
 
 class QItemSelectionModel;
 
@@ -25,6 +27,8 @@ public:
 
     explicit ProjectSortProxyModel(QObject *parent = nullptr);
     QItemSelectionModel *selectionModel();
+    /** @brief Reimplemented to keep the search index in sync with the source model */
+    void setSourceModel(QAbstractItemModel *sourceModel) override;
 
 public Q_SLOTS:
     /** @brief Set search string that will filter the view */
@@ -52,6 +56,37 @@ protected:
     bool hasAcceptedChildren(int source_row, const QModelIndex &source_parent) const;
 
 private:
+    /** @brief Filter data of a bin item, read once from the source model */
+    struct SearchEntry
+    {
+        /** @brief Case folded name, date and description */
+        QString text;
+        /** @brief Case folded tags */
+        QString tags;
+        int itemType;
+        int clipType;
+        int rating;
+        int usage;
+    };
+    /** @brief Returns the search entry of the item at @param sourceIndex, built on first use */
+    const SearchEntry &searchEntry(const QModelIndex &sourceIndex) const;
+    /** @brief Compute the sort key of @param sourceIndex if it is not cached yet */
+    void cacheSortKey(const QModelIndex &sourceIndex) const;
+    /** @brief Drop the cached data of the item at @param sourceIndex and the filter result of its ancestors */
+    void invalidateItem(const QModelIndex &sourceIndex, bool recursive = false);
+    /** @brief Clear cached filter results after a filter change
+     *  @param narrowed true if the new filter can only reject more items than the previous one */
+    void invalidateFilterCache(bool narrowed);
+    static quint64 sortKeyId(const QModelIndex &sourceIndex);
+
+    mutable std::unordered_map<quintptr, SearchEntry> m_searchIndex;
+    /** @brief Result of filterAcceptsRowItself for the current filters */
+    mutable std::unordered_map<quintptr, bool> m_acceptedItself;
+    /** @brief Result of filterAcceptsRow for the current filters, true if the item or one of its descendants is accepted */
+    mutable std::unordered_map<quintptr, bool> m_acceptedTree;
+    mutable std::unordered_map<quint64, QCollatorSortKey> m_textSortKeys;
+    mutable std::unordered_map<quint64, qint64> m_numberSortKeys;
+    QList<QMetaObject::Connection> m_sourceConnections;
     QItemSelectionModel *m_selection;
     QString m_searchString;
     QStringList m_searchTag;
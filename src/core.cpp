@@ -656,6 +656,12 @@ void Core::refreshProjectMonitorOnce()
     m_monitorManager->refreshProjectMonitor();
 }
 
+void Core::invalidateProjectMonitorCache()
+{
+    if (!m_guiConstructed) return;
+    m_monitorManager->projectMonitor()->invalidateFrameCache();
+}
+
 void Core::refreshProjectRange(QPair<int, int> range)
 {
     if (!m_guiConstructed || currentDoc()->loading || currentDoc()->closing) return;
@@ -853,6 +859,8 @@ int Core::getItemTrack(const ObjectId &id)
 void Core::refreshProjectItem(const ObjectId &id)
 {
     if (!m_guiConstructed || (!id.uuid.isNull() && !m_mainWindow->getTimeline(id.uuid))) return;
+    // Cached frames may use the item even if it is not under the cursor
+    invalidateProjectMonitorCache();
     switch (id.type) {
     case ObjectType::TimelineClip:
     case ObjectType::TimelineMix:
@@ -923,9 +931,11 @@ void Core::profileChanged()
     GenTime::setFps(getCurrentFps());
 }
 
-void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text)
+void Core::pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 memoryCost)
 {
-    undoStack()->push(new FunctionalUndoCommand(undo, redo, text));
+    auto *command = new FunctionalUndoCommand(undo, redo, text);
+    command->setMemoryCost(memoryCost);
+    undoStack()->push(command);
 }
 
 void Core::pushUndo(QUndoCommand *command)
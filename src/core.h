@@ -166,6 +166,8 @@ public:
     QSize getCurrentFrameDisplaySize() const;
     /** @brief Request project monitor refresh, and restore previously active monitor */
     void refreshProjectMonitorOnce();
+    /** @brief Drop the frames cached or prefetched by the project monitor */
+    void invalidateProjectMonitorCache();
     /** @brief Request project monitor refresh if current position is inside range*/
     void refreshProjectRange(QPair<int, int> range);
     /** @brief Request project monitor refresh if referenced item is under cursor */
@@ -180,8 +182,9 @@ public:
     void profileChanged();
 
     /** @brief Create and push and undo object based on the corresponding functions
-        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead*/
-    void pushUndo(const Fun &undo, const Fun &redo, const QString &text);
+        Note that if you class permits and requires it, you should use the macro PUSH_UNDO instead
+        @param memoryCost the memory captured by the functions, in bytes, counted in the undo memory budget */
+    void pushUndo(const Fun &undo, const Fun &redo, const QString &text, qint64 memoryCost = 0);
     void pushUndo(QUndoCommand *command);
     /** @brief display a user info/warning message in statusbar */
     void displayMessage(const QString &message, MessageType type, int timeout = -1);
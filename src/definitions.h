@@ -210,7 +210,8 @@ enum CacheType {
     CacheAudio = 4,
     CacheThumbs = 5,
     CacheSequence = 6,
-    CacheTmpWorkFiles = 7
+    CacheTmpWorkFiles = 7,
+    CacheProbe = 8
 };
 
 enum TrimMode { NormalTrim, RippleTrim, RollingTrim, SlipTrim, SlideTrim };
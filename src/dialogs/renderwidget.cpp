@@ -64,6 +64,7 @@
 #include <QTemporaryFile>
 #include <QThread>
 #include <QTreeWidgetItem>
+#include <QXmlStreamReader>
 #include <QtGlobal>
 
 #include "purpose_version.h"
@@ -90,7 +91,8 @@ enum {
     LastTimeRole,
     LastFrameRole,
     OpenBrowserRole,
-    PlayAfterRole
+    PlayAfterRole,
+    ThreadsRole
 };
 
 // Running job status
@@ -241,6 +243,11 @@ RenderWidget::RenderWidget(bool enableProxy, QWidget *parent)
     m_view.processing_threads->setValue(KdenliveSettings::processingthreads());
     connect(m_view.processing_threads, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &KdenliveSettings::setProcessingthreads);
     connect(m_view.processing_threads, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &RenderWidget::refreshParams);
+    m_view.render_segments->setMaximum(QThread::idealThreadCount());
+    m_view.render_segments->setValue(KdenliveSettings::rendersegments());
+    connect(m_view.render_segments, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &KdenliveSettings::setRendersegments);
+    m_view.smart_render->setChecked(KdenliveSettings::smartrender());
+    connect(m_view.smart_render, &QCheckBox::toggled, this, &KdenliveSettings::setSmartrender);
     if (!KdenliveSettings::parallelrender()) {
         m_view.processing_warning->hide();
     }
@@ -641,6 +648,10 @@ void RenderWidget::slotPrepareExport(bool delayedRendering)
     request->setEmbedSubtitles(m_view.embed_subtitles->isEnabled() && m_view.embed_subtitles->isChecked());
     request->setTwoPass(m_view.checkTwoPass->isChecked());
     request->setAudioFilePerTrack(m_view.stemAudioExport->isChecked() && m_view.stemAudioExport->isEnabled());
+    if (m_view.processing_box->isChecked() && m_view.processing_box->isEnabled() && !m_view.checkTwoPass->isChecked()) {
+        request->setSegmentCount(m_view.render_segments->value());
+    }
+    request->setSmartRender(m_view.smart_render->isChecked() && !m_view.checkTwoPass->isChecked());
 
     bool guideMultiExport = m_view.guide_multi_box->isChecked();
     int guideCategory = m_view.guideCategoryChooser->currentCategory();
@@ -740,22 +751,35 @@ void RenderWidget::checkRenderStatus()
         return;
     }
 
-    // Make sure no other rendering is running
-    if (runningJobsCount() > 0) {
-        return;
+    // Several jobs can render at the same time as long as their threads fit on this machine
+    const int threadBudget = qMax(1, QThread::idealThreadCount());
+    int usedThreads = 0;
+    QStringList busyOutputs;
+    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            usedThreads += jobThreads(item);
+            busyOutputs << item->text(1);
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
 
-    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
 
     bool waitingJob = false;
 
-    // Find first waiting job
+    // Start waiting jobs in queue order, a job never overtakes the ones above it
     while (item != nullptr) {
         if (item->status() == WAITINGJOB) {
+            waitingJob = true;
+            const int threads = jobThreads(item);
+            // Jobs writing the same file (two pass encoding) must run one after another
+            if (busyOutputs.contains(item->text(1)) || !RenderRequest::canStartJob(usedThreads, threads, threadBudget)) {
+                break;
+            }
             QDateTime t = QDateTime::currentDateTime();
             item->setData(1, StartTimeRole, t);
             item->setData(1, LastTimeRole, t);
-            waitingJob = true;
             startRendering(item);
             // Check for 2 pass encoding
             QStringList jobData = item->data(1, ParametersRole).toStringList();
@@ -773,12 +797,15 @@ void RenderWidget::checkRenderStatus()
                     above = m_view.running_jobs->itemAbove(above);
                 }
             }
-            item->setStatus(STARTINGJOB);
-            break;
+            if (item->status() != FAILEDJOB) {
+                item->setStatus(STARTINGJOB);
+                usedThreads += threads;
+                busyOutputs << item->text(1);
+            }
         }
         item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
     }
-    if (!waitingJob && m_view.shutdown->isChecked()) {
+    if (!waitingJob && usedThreads == 0 && m_view.shutdown->isChecked()) {
         Q_EMIT shutdown();
     }
 }
@@ -794,6 +821,48 @@ void RenderWidget::startRendering(RenderJobItem *item)
     }
 }
 
+int RenderWidget::jobThreads(RenderJobItem *item) const
+{
+    QVariant threads = item->data(1, ThreadsRole);
+    if (threads.isValid()) {
+        return threads.toInt();
+    }
+    // Read the thread counts from the consumer of the job playlist, as configured when the job was created
+    int processingThreads = 1;
+    int encodingThreads = 0;
+    const QStringList args = item->data(1, ParametersRole).toStringList();
+    QFile file(args.size() > 2 ? args.at(2) : QString());
+    if (file.open(QIODevice::ReadOnly)) {
+        QXmlStreamReader reader(&file);
+        while (!reader.atEnd()) {
+            if (reader.readNextStartElement() && reader.name() == QLatin1String("consumer")) {
+                processingThreads = reader.attributes().value(QLatin1String("real_time")).toInt();
+                encodingThreads = reader.attributes().value(QLatin1String("threads")).toInt();
+                break;
+            }
+        }
+        file.close();
+    }
+    int count = RenderRequest::jobThreadCost(processingThreads, encodingThreads);
+    item->setData(1, ThreadsRole, count);
+    return count;
+}
+
+int RenderWidget::overallProgress() const
+{
+    int count = 0;
+    int progress = 0;
+    auto *item = static_cast<RenderJobItem *>(m_view.running_jobs->topLevelItem(0));
+    while (item != nullptr) {
+        if (item->status() == RUNNINGJOB || item->status() == STARTINGJOB) {
+            progress += item->data(1, ProgressRole).toInt();
+            count++;
+        }
+        item = static_cast<RenderJobItem *>(m_view.running_jobs->itemBelow(item));
+    }
+    return count == 0 ? 100 : progress / count;
+}
+
 int RenderWidget::waitingJobsCount() const
 {
     int count = 0;
@@ -126,6 +126,8 @@ public:
     void updateDocumentPath();
     int waitingJobsCount() const;
     int runningJobsCount() const;
+    /** @brief Average progress of the running jobs, 100 if no job is running */
+    int overallProgress() const;
     QString getFreeScriptName(const QUrl &projectName = QUrl(), const QString &prefix = QString());
     bool startWaitingRenderJobs();
     /** @brief Show / hide proxy settings. */
@@ -227,6 +229,8 @@ private:
     /** @brief Check if a job needs to be started. */
     void checkRenderStatus();
     void startRendering(RenderJobItem *item);
+    /** @brief Number of threads used by the job, read from its playlist consumer */
+    int jobThreads(RenderJobItem *item) const;
     /** @brief Create a rendering profile from MLT preset. */
     QTreeWidgetItem *loadFromMltPreset(const QString &groupName, const QString &path, QString profileName, bool codecInName = false);
     RenderJobItem *createRenderJob(const QString &playlist, const QString &outputFile, const QString &subtitleFile = QString());
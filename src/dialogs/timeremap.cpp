@@ -2088,7 +2088,7 @@ void TimeRemap::updateKeyframesWithUndo(const QMap<int, int> &updatedKeyframes,
         }
     }
     UPDATE_UNDO_REDO_NOLOCK(redo, undo, local_undo, local_redo);
-    pCore->pushUndo(local_undo, local_redo, i18n("Edit Timeremap keyframes"));
+    pCore->pushUndo(local_undo, local_redo, i18n("Edit Timeremap keyframes"), (updatedKeyframes.size() + previousKeyframes.size()) * qint64(2 * sizeof(int)));
 }
 
 void TimeRemap::switchRemapParam()
@@ -50,27 +50,21 @@ QPair<bool, QString> DocumentValidator::validate(const double currentVersion)
         return QPair<bool, QString>(false, QString());
     }
     QDomElement kdenliveDoc = mlt.firstChildElement(QStringLiteral("kdenlivedoc"));
-    QString rootDir = mlt.attribute(QStringLiteral("root"));
-    if (rootDir == QLatin1String("$CURRENTPATH")) {
-        // The document was extracted from a Kdenlive archived project, fix root directory
-        QString playlist = m_doc.toString();
-        playlist.replace(QLatin1String("$CURRENTPATH"), m_url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile());
-        m_doc.setContent(playlist);
-        mlt = m_doc.firstChildElement(QStringLiteral("mlt"));
-        kdenliveDoc = mlt.firstChildElement(QStringLiteral("kdenlivedoc"));
-    } else if (rootDir.isEmpty()) {
+    // The root of archived projects was already replaced when reading the file
+    if (mlt.attribute(QStringLiteral("root")).isEmpty()) {
         mlt.setAttribute(QStringLiteral("root"), m_url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile());
     }
 
     QLocale documentLocale = QLocale::c(); // Document locale for conversion. Previous MLT / Kdenlive versions used C locale by default
     QDomElement main_playlist;
-    QDomNodeList playlists = m_doc.elementsByTagName(QStringLiteral("playlist"));
-    for (int i = 0; i < playlists.count(); i++) {
-        if (playlists.at(i).toElement().attribute(QStringLiteral("id")) == QLatin1String("main bin") ||
-            playlists.at(i).toElement().attribute(QStringLiteral("id")) == QLatin1String("main_bin")) {
-            main_playlist = playlists.at(i).toElement();
+    // The bin playlist is a direct child of the root element, no need to search the whole document
+    QDomElement playlist = mlt.firstChildElement(QStringLiteral("playlist"));
+    while (!playlist.isNull()) {
+        if (playlist.attribute(QStringLiteral("id")) == QLatin1String("main bin") || playlist.attribute(QStringLiteral("id")) == QLatin1String("main_bin")) {
+            main_playlist = playlist;
             break;
         }
+        playlist = playlist.nextSiblingElement(QStringLiteral("playlist"));
     }
 
     if (mlt.hasAttribute(QStringLiteral("LC_NUMERIC"))) { // Backwards compatibility
@@ -139,18 +133,12 @@ QPair<bool, QString> DocumentValidator::validate(const double currentVersion)
     }
     qDebug() << "FOUND MLT PROJECT VERSION: " << mltMajorVersion << " / " << mltServiceVersion << " / " << mltPatchVersion;
     if (mltMajorVersion <= 7 && mltServiceVersion <= 15) {
-        // MLT <= 7.15.0 used the mute_on_pause property that is now deprecated and breaks audio playback so remove it
-        QDomNodeList producers = m_doc.elementsByTagName(QStringLiteral("producer"));
-        QDomNodeList chains = m_doc.elementsByTagName(QStringLiteral("chain"));
-        int max = producers.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement t = producers.at(i).toElement();
-            Xml::removeXmlProperty(t, QStringLiteral("mute_on_pause"));
-        }
-        max = chains.count();
-        for (int i = 0; i < max; ++i) {
-            QDomElement t = chains.at(i).toElement();
-            Xml::removeXmlProperty(t, QStringLiteral("mute_on_pause"));
+        // MLT <= 7.15.0 used the mute_on_pause property that is now deprecated and breaks audio playback so remove it.
+        // Producers and chains are children of the root element, one walk over them is enough
+        for (QDomElement t = mlt.firstChildElement(); !t.isNull(); t = t.nextSiblingElement()) {
+            if (t.tagName() == QLatin1String("producer") || t.tagName() == QLatin1String("chain")) {
+                Xml::removeXmlProperty(t, QStringLiteral("mute_on_pause"));
+            }
         }
     }
 
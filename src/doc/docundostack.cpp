@@ -4,12 +4,50 @@
 */
 
 #include "docundostack.hpp"
+#include "kdenlivesettings.h"
+#include "undohelper.hpp"
+#include <QDebug>
 #include <QUndoCommand>
 #include <QUndoGroup>
 
+/// Commands holding less memory are not worth a journal entry and its compression
+static const qint64 minSpillCost = 512;
+
+static qint64 costOf(const QUndoCommand *command)
+{
+    qint64 cost = 0;
+    if (auto *accounted = dynamic_cast<const AccountedUndoCommand *>(command)) {
+        cost = accounted->memoryCost();
+    } else {
+        cost = qint64(sizeof(QUndoCommand)) + command->text().size() * qint64(sizeof(QChar));
+    }
+    for (int i = 0; i < command->childCount(); ++i) {
+        cost += costOf(command->child(i));
+    }
+    return cost;
+}
+
+static qint64 spillCommand(const QUndoCommand *command, const std::shared_ptr<UndoJournal> &journal)
+{
+    qint64 released = 0;
+    auto *accounted = dynamic_cast<AccountedUndoCommand *>(const_cast<QUndoCommand *>(command));
+    if (accounted && !accounted->isSpilled() && accounted->memoryCost() >= minSpillCost) {
+        released = accounted->spill(journal);
+    }
+    for (int i = 0; i < command->childCount(); ++i) {
+        released += spillCommand(command->child(i), journal);
+    }
+    return released;
+}
+
 DocUndoStack::DocUndoStack(QUndoGroup *parent)
     : QUndoStack(parent)
+    , m_memoryBudget(qint64(KdenliveSettings::undomemorybudget()) * 1024 * 1024)
+    , m_memoryUsage(0)
+    , m_lastIndex(0)
+    , m_pushing(false)
 {
+    connect(this, &QUndoStack::indexChanged, this, &DocUndoStack::slotIndexChanged);
 }
 
 // TODO: custom undostack everywhere do that
@@ -18,5 +56,103 @@ void DocUndoStack::push(QUndoCommand *cmd)
     if (index() < count()) {
         Q_EMIT invalidate(index());
     }
+    if (m_costs.size() != count()) {
+        resetCosts();
+    }
+    const int previous = index();
+    m_pushing = true;
     QUndoStack::push(cmd);
+    m_pushing = false;
+    // The commands above the previous index were deleted, and the pushed one may have been merged with the previous top
+    const int first = qMax(0, qMin(previous, count()) - 1);
+    while (m_costs.size() > first) {
+        m_memoryUsage -= m_costs.takeLast();
+    }
+    for (int i = first; i < count(); ++i) {
+        const qint64 cost = costOf(command(i));
+        m_costs.append(cost);
+        m_memoryUsage += cost;
+    }
+    m_lastIndex = index();
+    enforceBudget();
+}
+
+qint64 DocUndoStack::commandCost(int index) const
+{
+    const QUndoCommand *cmd = command(index);
+    return cmd ? costOf(cmd) : 0;
+}
+
+qint64 DocUndoStack::memoryUsage() const
+{
+    return m_memoryUsage;
+}
+
+void DocUndoStack::updateCost(int index)
+{
+    const qint64 cost = costOf(command(index));
+    m_memoryUsage += cost - m_costs.at(index);
+    m_costs[index] = cost;
+}
+
+void DocUndoStack::resetCosts()
+{
+    m_costs.clear();
+    m_memoryUsage = 0;
+    for (int i = 0; i < count(); ++i) {
+        const qint64 cost = costOf(command(i));
+        m_costs.append(cost);
+        m_memoryUsage += cost;
+    }
+    m_lastIndex = index();
+}
+
+void DocUndoStack::slotIndexChanged(int index)
+{
+    if (m_pushing) {
+        return;
+    }
+    if (m_costs.size() != count()) {
+        resetCosts();
+        return;
+    }
+    // The commands between the previous and new index were undone or redone
+    for (int i = qMin(index, m_lastIndex); i < qMax(index, m_lastIndex); ++i) {
+        updateCost(i);
+    }
+    m_lastIndex = index;
+}
+
+void DocUndoStack::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+    enforceBudget();
+}
+
+void DocUndoStack::enforceBudget()
+{
+    if (m_journal && m_journal.use_count() == 1) {
+        // All commands stored in the journal were deleted, start a new file
+        m_journal.reset();
+    }
+    if (m_memoryBudget <= 0 || m_memoryUsage <= m_memoryBudget) {
+        return;
+    }
+    const qint64 usage = m_memoryUsage;
+    if (!m_journal) {
+        m_journal = std::make_shared<UndoJournal>();
+    }
+    // Release more than needed so that we don't write to the journal on each push
+    const qint64 target = m_memoryBudget * 3 / 4;
+    // Never spill the last command, it can still be merged with the next one
+    for (int i = 0; i < count() - 1 && m_memoryUsage > target; ++i) {
+        if (spillCommand(command(i), m_journal) > 0) {
+            updateCost(i);
+        }
+    }
+    const qint64 released = usage - m_memoryUsage;
+    if (released > 0) {
+        qDebug() << "Undo stack over budget:" << usage / 1024 << "kB for" << count() << "commands, moved" << released / 1024 << "kB to journal, now"
+                 << m_journal->size() / 1024 << "kB";
+    }
 }
@@ -6,9 +6,12 @@
 #pragma once
 
 #include <QUndoCommand>
+#include <QVector>
+#include <memory>
 
 class QUndoGroup;
 class QUndoCommand;
+class UndoJournal;
 
 class DocUndoStack : public QUndoStack
 {
@@ -16,6 +19,33 @@ class DocUndoStack : public QUndoStack
 public:
     explicit DocUndoStack(QUndoGroup *parent = Q_NULLPTR);
     void push(QUndoCommand *cmd);
+    /** @brief Returns the estimated memory held by the command at @param index and its children, in bytes */
+    qint64 commandCost(int index) const;
+    /** @brief Returns the estimated memory held by all the commands of the stack, in bytes */
+    qint64 memoryUsage() const;
+    /** @brief Set the memory budget of the stack to @param bytes, 0 to disable it.
+     *  When over budget, the state of the oldest commands is moved to a compressed journal on disk */
+    void setMemoryBudget(qint64 bytes);
+
+private:
+    qint64 m_memoryBudget;
+    qint64 m_memoryUsage;
+    /** @brief The cost of each command of the stack, kept up to date on push, undo, redo and spill */
+    QVector<qint64> m_costs;
+    int m_lastIndex;
+    bool m_pushing;
+    std::shared_ptr<UndoJournal> m_journal;
+    /** @brief Spill the oldest commands to the journal if the stack exceeds its memory budget */
+    void enforceBudget();
+    /** @brief Recompute the cost of the command at @param index and update the running total */
+    void updateCost(int index);
+    /** @brief Recompute the costs of all the commands, used when the stack changed behind our back (clear) */
+    void resetCosts();
+
+private Q_SLOTS:
+    /** @brief Undone and redone commands reload their spilled state, update their cost */
+    void slotIndexChanged(int index);
+
 Q_SIGNALS:
     void invalidate(int ix);
 };
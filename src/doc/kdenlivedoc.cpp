@@ -166,6 +166,14 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         return result;
     }
 
+    // Read the file once, all checks and the DOM parsing work on this buffer
+    QByteArray data = file.readAll();
+    file.close();
+    if (data.contains("root=\"$CURRENTPATH\"")) {
+        // The document was extracted from a Kdenlive archived project, fix root directory before parsing
+        data.replace("$CURRENTPATH", url.adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile().toUtf8());
+    }
+
     QDomDocument domDoc {};
     int line;
     int col;
@@ -178,13 +186,13 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         QDomImplementation::setInvalidDataPolicy(QDomImplementation::DropInvalidChars);
         result.setModified(true);
     }
-    bool success = domDoc.setContent(&file, false, &domErrorMessage, &line, &col);
+    bool success = domDoc.setContent(data, false, &domErrorMessage, &line, &col);
 
     if (!success) {
         if (recoverCorruption) {
             // Try to recover broken file produced by Kdenlive 0.9.4
             int correction = 0;
-            QString playlist = QString::fromUtf8(file.readAll());
+            QString playlist = QString::fromUtf8(data);
             while (!success && correction < 2) {
                 int errorPos = 0;
                 line--;
@@ -216,7 +224,6 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
             return result;
         }
     }
-    file.close();
 
 
     qCDebug(KDENLIVE_LOG) << "// validating project file";
@@ -240,9 +247,10 @@ DocOpenResult KdenliveDoc::Open(const QUrl &url, const QString &projectFolder, Q
         result.setModified(true);
     }
 
-    if (!KdenliveSettings::gpu_accel()) {
+    if (!KdenliveSettings::gpu_accel() && data.contains("movit.")) {
         success = validator.checkMovit();
     }
+    data.clear();
     if (!success) {
         result.setError(i18n("GPU acceleration is turned off in Kdenlive settings, but is required for this project's Movit filters."));
         return result;
@@ -433,7 +441,8 @@ const QByteArray KdenliveDoc::getAndClearProjectXml()
 {
     // Profile has already been set, dont overwrite it
     m_document.documentElement().removeChild(m_document.documentElement().firstChildElement(QLatin1String("profile")));
-    const QByteArray result = m_document.toString().toUtf8();
+    // Serialize directly to utf-8 without indentation, MLT parses this buffer once
+    const QByteArray result = m_document.toByteArray(0);
     // We don't need the xml data anymore, throw away
     m_document.clear();
     return result;
@@ -2058,6 +2067,10 @@ const QDir KdenliveDoc::getCacheDir(CacheType type, bool *ok, const QUuid uuid)
         basePath = kdenliveCacheDir;
         basePath.append(QStringLiteral("/proxy"));
         break;
+    case CacheProbe:
+        basePath = kdenliveCacheDir;
+        basePath.append(QStringLiteral("/probe"));
+        break;
     case CacheAudio:
         basePath.append(QStringLiteral("/audiothumbs"));
         break;
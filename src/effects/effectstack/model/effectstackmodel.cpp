@@ -218,7 +218,8 @@ void EffectStackModel::removeEffect(const std::shared_ptr<EffectItemModel> &effe
         update();
         PUSH_LAMBDA(update, redo);
         PUSH_LAMBDA(update2, undo);
-        PUSH_UNDO(undo, redo, i18n("Delete effect %1", effectName));
+        // The deleted effect is kept alive by the undo function
+        PUSH_ACCOUNTED_UNDO(undo, redo, i18n("Delete effect %1", effectName), AssetParameterModel::memoryCost(effect->getAllParameters()));
     } else {
         qDebug() << "..........FAILED EFFECT DELETION";
     }
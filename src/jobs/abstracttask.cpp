@@ -55,6 +55,9 @@ AbstractTask::AbstractTask(const ObjectId &owner, JOBTYPE type, QObject *object)
     case AbstractTask::PROXYJOB:
         m_priority = 8;
         break;
+    case AbstractTask::SEQUENCERENDERJOB:
+        m_priority = 3;
+        break;
     case AbstractTask::FILTERCLIPJOB:
     case AbstractTask::STABILIZEJOB:
     case AbstractTask::ANALYSECLIPJOB:
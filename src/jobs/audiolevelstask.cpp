@@ -13,27 +13,217 @@
 
 #include <KLocalizedString>
 #include <KMessageWidget>
+#include <QDataStream>
 #include <QElapsedTimer>
 #include <QFile>
 #include <QImage>
 #include <QList>
 #include <QMutex>
 #include <QRgb>
+#include <QSaveFile>
+#include <QSemaphore>
 #include <QString>
+#include <QThread>
 #include <QThreadPool>
 #include <QTime>
 #include <QVariantList>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
 
 static QList<AudioLevelsTask *> tasksList;
 static QMutex tasksListMutex;
 
+/// Minimum duration of the file segments decoded in parallel, in seconds
+static const int minSegmentDuration = 60;
+/// Number of audio samples summarized by each value of the peaks files
+static const int samplesPerPeak = 256;
+static const quint32 peaksMagic = 0x4b44504b;
+static const quint32 peaksVersion = 1;
+/// Magic, version, samples per peak, channels, frequency and peak count
+static const qint64 peaksHeaderSize = 5 * sizeof(quint32) + sizeof(quint64);
+
 static void deleteQVariantList(QVector<uint8_t> *list)
 {
     delete list;
 }
 
+namespace {
+/** @brief The levels of an audio stream, written concurrently by the segment workers */
+struct StreamLevels
+{
+    int stream;
+    int channels;
+    QString cachePath;
+    std::unique_ptr<std::atomic<uint8_t>[]> levels;
+    QString peaksPath;
+    qint64 peakCount;
+    /** @brief Linear peak of each block of samples, blocks at segment boundaries are written by two workers */
+    std::unique_ptr<std::atomic<uint16_t>[]> peaks;
+    /** @brief The levels attached to the producer, only the newly processed frames are copied in it */
+    QVector<uint8_t> published;
+};
+
+/** @brief A range of frames of a stream, decoded by its own producer */
+struct LevelsSegment
+{
+    StreamLevels *target;
+    int in;
+    int out;
+    /** @brief Next frame to process, published by the worker */
+    std::atomic<int> position;
+    /** @brief Frames before this one are already copied in the published levels */
+    int collected;
+};
+
+/** @brief Same scale as the MLT audiolevel filter, so that the waveforms look the same as before */
+double iecScale(double dB)
+{
+    if (dB < -70.0) {
+        return 0.0;
+    }
+    if (dB < -60.0) {
+        return (dB + 70.0) * 0.0025;
+    }
+    if (dB < -50.0) {
+        return (dB + 60.0) * 0.005 + 0.025;
+    }
+    if (dB < -40.0) {
+        return (dB + 50.0) * 0.0075 + 0.075;
+    }
+    if (dB < -30.0) {
+        return (dB + 40.0) * 0.015 + 0.15;
+    }
+    if (dB < -20.0) {
+        return (dB + 30.0) * 0.02 + 0.3;
+    }
+    if (dB < -0.001 || dB > 0.001) {
+        return (dB + 20.0) * 0.025 + 0.5;
+    }
+    return 1.0;
+}
+
+uint8_t levelFromPeak(int peak)
+{
+    const double level = peak / 32768.0;
+    const double dB = level > 0.0 ? 20 * log10(level) : -1000.0;
+    return uint8_t(256 * qMin(iecScale(dB) * 0.9, 1.0));
+}
+
+/** @brief Decode the frames of @param segment and write the peak level of each frame, channel and block of samples, returns false if the file cannot be opened */
+bool processSegment(mlt_profile profile, const QByteArray &service, const QByteArray &resource, int frequency, LevelsSegment *segment,
+                    const std::atomic<bool> *canceled)
+{
+    Mlt::Producer audioProducer(profile, service.constData(), resource.constData());
+    if (!audioProducer.is_valid()) {
+        return false;
+    }
+    audioProducer.set("video_index", "-1");
+    audioProducer.set("audio_index", segment->target->stream);
+    Mlt::Filter chans(profile, "audiochannels");
+    Mlt::Filter converter(profile, "audioconvert");
+    audioProducer.attach(chans);
+    audioProducer.attach(converter);
+    if (segment->in > 0) {
+        audioProducer.seek(segment->in);
+    }
+    const double framesPerSecond = audioProducer.get_fps();
+    const int channels = segment->target->channels;
+    std::atomic<uint8_t> *levels = segment->target->levels.get();
+    std::atomic<uint16_t> *peaks = segment->target->peaks.get();
+    const qint64 peakCount = segment->target->peakCount;
+    auto storePeak = [peaks, peakCount, channels](qint64 block, int channel, int value) {
+        if (block >= peakCount) {
+            return;
+        }
+        std::atomic<uint16_t> &peak = peaks[block * channels + channel];
+        uint16_t current = peak.load(std::memory_order_relaxed);
+        while (current < value && !peak.compare_exchange_weak(current, uint16_t(value), std::memory_order_relaxed)) {
+        }
+    };
+    for (int z = segment->in; z < segment->out && !canceled->load(std::memory_order_relaxed); ++z) {
+        std::unique_ptr<Mlt::Frame> mltFrame(audioProducer.get_frame());
+        bool valid = false;
+        if (mltFrame && mltFrame->is_valid() && mltFrame->get_int("test_audio") == 0) {
+            mlt_audio_format audioFormat = mlt_audio_s16;
+            int frameFrequency = frequency;
+            int frameChannels = channels;
+            int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
+            auto *pcm = static_cast<int16_t *>(mltFrame->get_audio(audioFormat, frameFrequency, frameChannels, samples));
+            if (pcm != nullptr && audioFormat == mlt_audio_s16 && frameChannels == channels) {
+                // Peak of each channel and block of samples, read directly from the interleaved samples
+                const qint64 firstSample = mlt_audio_calculate_samples_to_position(float(framesPerSecond), frequency, z);
+                for (int channel = 0; channel < channels; ++channel) {
+                    int peak = 0;
+                    for (int i = 0; i < samples;) {
+                        const qint64 block = (firstSample + i) / samplesPerPeak;
+                        const int blockEnd = int(qMin(qint64(samples), (block + 1) * samplesPerPeak - firstSample));
+                        int blockPeak = 0;
+                        for (; i < blockEnd; ++i) {
+                            blockPeak = qMax(blockPeak, qAbs(int(pcm[i * channels + channel])));
+                        }
+                        storePeak(block, channel, blockPeak);
+                        peak = qMax(peak, blockPeak);
+                    }
+                    levels[qint64(z) * channels + channel].store(levelFromPeak(peak), std::memory_order_relaxed);
+                }
+                valid = true;
+            }
+        }
+        if (!valid && z > segment->in) {
+            for (int channel = 0; channel < channels; ++channel) {
+                levels[qint64(z) * channels + channel].store(levels[qint64(z - 1) * channels + channel].load(std::memory_order_relaxed),
+                                                             std::memory_order_relaxed);
+            }
+        }
+        segment->position.store(z + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+/** @brief Copy the levels of the frames processed since the last call to the published levels of the segment stream */
+void collectLevels(LevelsSegment *segment)
+{
+    StreamLevels *stream = segment->target;
+    const int position = segment->position.load(std::memory_order_acquire);
+    if (position <= segment->collected) {
+        return;
+    }
+    // Detaches from the levels attached to the producer, if still in use
+    uint8_t *data = stream->published.data();
+    for (qint64 i = qint64(segment->collected) * stream->channels; i < qint64(position) * stream->channels; ++i) {
+        data[i] = stream->levels[i].load(std::memory_order_relaxed);
+    }
+    segment->collected = position;
+}
+
+/** @brief Attach the levels published so far to @param producer, only a shared copy is made while it is locked */
+void publishLevels(const std::shared_ptr<Mlt::Producer> &producer, const StreamLevels &stream)
+{
+    auto *levelsCopy = new QVector<uint8_t>(stream.published);
+    const QString key = QString("_kdenlive:audio%1").arg(stream.stream);
+    producer->lock();
+    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
+    producer->unlock();
+}
+
+/** @brief Save the peaks of @param stream, on the same scale as the levels of each frame */
+bool writeStreamPeaks(const StreamLevels &stream, int frequency)
+{
+    QVector<uint8_t> data(int(stream.peakCount * stream.channels));
+    for (int i = 0; i < data.size(); ++i) {
+        data[i] = levelFromPeak(stream.peaks[i].load(std::memory_order_relaxed));
+    }
+    return AudioLevelsTask::writePeaks(stream.peaksPath, stream.channels, frequency, data);
+}
+} // namespace
+
 AudioLevelsTask::AudioLevelsTask(const ObjectId &owner, QObject *object)
     : AbstractTask(owner, AbstractTask::AUDIOTHUMBJOB, object)
+    , m_peaksOnly(false)
 {
     m_description = i18n("Audio thumbs");
 }
@@ -51,9 +241,28 @@ void AudioLevelsTask::start(const ObjectId &owner, QObject *object, bool force)
     pCore->taskManager.startTask(owner.itemId, task);
 }
 
+void AudioLevelsTask::startPeaks(const ObjectId &owner, QObject *object)
+{
+    if (pCore->taskManager.hasPendingJob(owner, AbstractTask::AUDIOTHUMBJOB)) {
+        return;
+    }
+    AudioLevelsTask *task = new AudioLevelsTask(owner, object);
+    task->m_peaksOnly = true;
+    task->m_description = i18n("Audio peaks");
+    pCore->taskManager.startTask(owner.itemId, task);
+}
+
 void AudioLevelsTask::run()
 {
     AbstractTaskDone whenFinished(m_owner.itemId, this);
+    generateLevels();
+    if (m_peaksOnly) {
+        QMetaObject::invokeMethod(m_object, "audioPeaksReady");
+    }
+}
+
+void AudioLevelsTask::generateLevels()
+{
     if (m_isCanceled || pCore->taskManager.isBlocked()) {
         return;
     }
@@ -65,7 +274,7 @@ void AudioLevelsTask::run()
         // Clip was deleted
         return;
     }
-    if (binClip->audioChannels() == 0 || binClip->audioThumbCreated()) {
+    if (binClip->audioChannels() == 0 || (binClip->audioThumbCreated() && !m_peaksOnly)) {
         // nothing to do
         return;
     }
@@ -94,6 +303,7 @@ void AudioLevelsTask::run()
     QMap<int, int> audioChannels = binClip->audioInfo()->streamChannels();
     QMapIterator<int, QString> st(streams);
     bool audioCreated = false;
+    std::vector<std::unique_ptr<StreamLevels>> pending;
     while (st.hasNext() && !m_isCanceled) {
         st.next();
         int stream = st.key();
@@ -102,8 +312,13 @@ void AudioLevelsTask::run()
         }
         // Generate one thumb per stream
         QString cachePath = binClip->getAudioThumbPath(stream);
+        const QString peaksPath = binClip->getAudioPeaksPath(stream);
         QVector<uint8_t> mltLevels;
-        if (!m_isForce && QFile::exists(cachePath)) {
+        if (m_peaksOnly) {
+            if (peaksPath.isEmpty() || QFile::exists(peaksPath)) {
+                continue;
+            }
+        } else if (!m_isForce && QFile::exists(cachePath)) {
             // Audio thumb already exists
             QImage image(cachePath);
             if (!m_isCanceled && !image.isNull()) {
@@ -122,125 +337,229 @@ void AudioLevelsTask::run()
                     QString key = QString("_kdenlive:audio%1").arg(stream);
                     producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
                     producer->unlock();
+                    // Missing peaks are only created when a zoomed in waveform needs them
                     continue;
                 }
             }
         }
+        auto levels = std::make_unique<StreamLevels>();
+        levels->stream = stream;
+        levels->channels = channels;
+        levels->cachePath = cachePath;
+        levels->levels.reset(new std::atomic<uint8_t>[size_t(lengthInFrames) * size_t(channels)]());
+        levels->peaksPath = peaksPath;
+        const qint64 totalSamples = mlt_audio_calculate_samples_to_position(float(producer->get_fps()), frequency, lengthInFrames);
+        levels->peakCount = (totalSamples + samplesPerPeak - 1) / samplesPerPeak;
+        levels->peaks.reset(new std::atomic<uint16_t>[size_t(levels->peakCount) * size_t(channels)]());
+        levels->published.fill(0, lengthInFrames * channels);
+        pending.push_back(std::move(levels));
+    }
+    if (!pending.empty() && !m_isCanceled) {
         QString service = producer->get("mlt_service");
         if (service == QLatin1String("avformat-novalidate")) {
             service = QStringLiteral("avformat");
         } else if (service.startsWith(QLatin1String("xml"))) {
             service = QStringLiteral("xml-nogl");
         }
-        const QString res = qstrdup(producer->get("resource"));
-        Mlt::Producer *aProd = new Mlt::Producer(producer->get_profile(), service.toUtf8().constData(), res.toUtf8().constData());
-        if (!aProd->is_valid()) {
-            QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection, Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", res)),
-                                      Q_ARG(int, int(KMessageWidget::Warning)));
-            delete aProd;
-            return;
+        const QByteArray serviceName = service.toUtf8();
+        const QByteArray resource(producer->get("resource"));
+        // Decode all streams in parallel, long files are also split in segments that each use their own producer
+        const int minSegmentFrames = qMax(1, int(minSegmentDuration * producer->get_fps()));
+        const QVector<QPair<int, int>> ranges = segmentRanges(lengthInFrames, minSegmentFrames, levelsPool()->maxThreadCount() / int(pending.size()));
+        std::vector<std::unique_ptr<LevelsSegment>> segments;
+        for (const auto &levels : pending) {
+            for (const auto &range : ranges) {
+                auto segment = std::make_unique<LevelsSegment>();
+                segment->target = levels.get();
+                segment->in = range.first;
+                segment->out = range.second;
+                segment->position = segment->in;
+                segment->collected = segment->in;
+                segments.push_back(std::move(segment));
+            }
         }
-        aProd->set("video_index", "-1");
-        aProd->set("audio_index", stream);
-        Mlt::Filter chans(producer->get_profile(), "audiochannels");
-        Mlt::Filter converter(producer->get_profile(), "audioconvert");
-        Mlt::Filter levels(producer->get_profile(), "audiolevel");
-        aProd->attach(chans);
-        aProd->attach(converter);
-        aProd->attach(levels);
-        std::unique_ptr<Mlt::Producer> audioProducer;
-        audioProducer.reset(aProd);
-
-        double framesPerSecond = audioProducer->get_fps();
-        mlt_audio_format audioFormat = mlt_audio_s16;
-        QStringList keys;
-        keys.reserve(channels);
-        for (int i = 0; i < channels; i++) {
-            keys << "meta.media.audio_level." + QString::number(i);
+        std::atomic<bool> canceled{false};
+        // The pool is shared with the other tasks, count our finished segments instead of waiting for it
+        QSemaphore finished;
+        mlt_profile profile = producer->get_profile();
+        QVector<QFuture<bool>> results;
+        for (const auto &segment : segments) {
+            LevelsSegment *seg = segment.get();
+            results << QtConcurrent::run(levelsPool(), [profile, serviceName, resource, frequency, seg, &canceled, &finished]() {
+                bool result = processSegment(profile, serviceName, resource, frequency, seg, &canceled);
+                finished.release();
+                return result;
+            });
         }
-        uint maxLevel = 1;
+        const qint64 totalFrames = qint64(lengthInFrames) * qint64(pending.size());
         QElapsedTimer updateTime;
         updateTime.start();
-        for (int z = 0; z < lengthInFrames && !m_isCanceled; ++z) {
-            int val = int(100.0 * z / lengthInFrames);
+        while (!finished.tryAcquire(int(segments.size()), 200)) {
+            if (m_isCanceled) {
+                canceled = true;
+                continue;
+            }
+            qint64 done = 0;
+            for (const auto &segment : segments) {
+                done += segment->position.load(std::memory_order_acquire) - segment->in;
+            }
+            int val = int(100 * done / totalFrames);
             if (m_progress != val) {
                 m_progress = val;
                 QMetaObject::invokeMethod(m_object, "updateJobProgress");
             }
-            QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
-            if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-                int samples = mlt_audio_calculate_frame_samples(float(framesPerSecond), frequency, z);
-                mltFrame->get_audio(audioFormat, frequency, channels, samples);
-                for (int channel = 0; channel < channels; ++channel) {
-                    uint lev = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                    mltLevels << lev;
-                    // double lev = mltFrame->get_double(keys.at(channel).toUtf8().constData());
-                    // mltLevels << lev;
-                    maxLevel = qMax(lev, maxLevel);
-                }
-            } else if (!mltLevels.isEmpty()) {
-                for (int channel = 0; channel < channels; channel++) {
-                    mltLevels << mltLevels.last();
-                }
-            }
             // Incrementally update the audio levels every 3 seconds.
-            if (updateTime.elapsed() > 3000 && !m_isCanceled) {
+            if (!m_peaksOnly && updateTime.elapsed() > 3000) {
                 updateTime.restart();
-                QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-                producer->lock();
-                QString key = QString("_kdenlive:audio%1").arg(stream);
-                producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-                producer->unlock();
+                for (const auto &segment : segments) {
+                    collectLevels(segment.get());
+                }
+                for (const auto &levels : pending) {
+                    publishLevels(producer, *levels.get());
+                }
                 QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
             }
         }
-
-        /*// Normalize
-        for (double &v : mltLevels) {
-            m_audioLevels << uchar(255 * v / maxLevel);
-        }*/
+        for (const auto &result : qAsConst(results)) {
+            if (!result.result()) {
+                QMetaObject::invokeMethod(pCore.get(), "displayBinMessage", Qt::QueuedConnection,
+                                          Q_ARG(QString, i18n("Audio thumbs: cannot open file %1", QString::fromUtf8(resource))),
+                                          Q_ARG(int, int(KMessageWidget::Warning)));
+                return;
+            }
+        }
         if (m_isCanceled) {
-            mltLevels.clear();
             m_progress = 100;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
-        }
-        if (mltLevels.size() > 0) {
-            QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(mltLevels);
-            producer->lock();
-            QString key = QString("_kdenlive:audio%1").arg(stream);
-            QString key2 = QString("kdenlive:audio_max%1").arg(stream);
-            producer->set(key2.toUtf8().constData(), int(maxLevel));
-            producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
-            producer->unlock();
-            // qDebug()<<"=== FINISHED PRODUCING AUDIO FOR: "<<key<<", SIZE: "<<levelsCopy->size();
+        } else {
+            for (const auto &segment : segments) {
+                collectLevels(segment.get());
+            }
+            for (const auto &levels : pending) {
+                if (!levels->peaksPath.isEmpty() && !writeStreamPeaks(*levels.get(), frequency)) {
+                    qWarning() << "Cannot write audio peaks: " << levels->peaksPath;
+                }
+                const QVector<uint8_t> &mltLevels = levels->published;
+                if (m_peaksOnly || mltLevels.isEmpty()) {
+                    continue;
+                }
+                uint maxLevel = qMax(uint(1), uint(*std::max_element(mltLevels.constBegin(), mltLevels.constEnd())));
+                storeLevels(producer, levels->stream, levels->channels, mltLevels, maxLevel, levels->cachePath);
+                audioCreated = true;
+            }
             m_progress = 100;
             QMetaObject::invokeMethod(m_object, "updateJobProgress");
-            // Put into an image for caching.
-            int count = mltLevels.size();
-            QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
-            int n = image.width() * image.height();
-            for (int i = 0; i < n; i++) {
-                QRgb p;
-                if ((4 * i + 3) < count) {
-                    p = qRgba(mltLevels.at(4 * i), mltLevels.at(4 * i + 1), mltLevels.at(4 * i + 2), mltLevels.at(4 * i + 3));
-                } else {
-                    int last = mltLevels.last();
-                    int r = (4 * i + 0) < count ? mltLevels.at(4 * i + 0) : last;
-                    int g = (4 * i + 1) < count ? mltLevels.at(4 * i + 1) : last;
-                    int b = (4 * i + 2) < count ? mltLevels.at(4 * i + 2) : last;
-                    int a = last;
-                    p = qRgba(r, g, b, a);
-                }
-                image.setPixel(i / channels, i % channels, p);
+            if (audioCreated) {
+                QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
             }
-            image.save(cachePath);
-            audioCreated = true;
-            QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
         }
     }
-    if (!audioCreated && !m_isCanceled) {
+    if (!audioCreated && !m_isCanceled && !m_peaksOnly) {
         // Audio was cached, ensure the bin thumbnail is loaded
         QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, true));
     }
     QMetaObject::invokeMethod(m_object, "updateJobProgress");
 }
+
+void AudioLevelsTask::storeLevels(const std::shared_ptr<Mlt::Producer> &producer, int stream, int channels, const QVector<uint8_t> &levels, uint maxLevel,
+                                  const QString &cachePath)
+{
+    QVector<uint8_t> *levelsCopy = new QVector<uint8_t>(levels);
+    producer->lock();
+    QString key = QString("_kdenlive:audio%1").arg(stream);
+    QString key2 = QString("kdenlive:audio_max%1").arg(stream);
+    producer->set(key2.toUtf8().constData(), int(maxLevel));
+    producer->set(key.toUtf8().constData(), levelsCopy, 0, (mlt_destructor)deleteQVariantList);
+    producer->unlock();
+    // Put into an image for caching.
+    int count = levels.size();
+    QImage image((count + 3) / 4 / channels, channels, QImage::Format_ARGB32);
+    int n = image.width() * image.height();
+    for (int i = 0; i < n; i++) {
+        QRgb p;
+        if ((4 * i + 3) < count) {
+            p = qRgba(levels.at(4 * i), levels.at(4 * i + 1), levels.at(4 * i + 2), levels.at(4 * i + 3));
+        } else {
+            int last = levels.last();
+            int r = (4 * i + 0) < count ? levels.at(4 * i + 0) : last;
+            int g = (4 * i + 1) < count ? levels.at(4 * i + 1) : last;
+            int b = (4 * i + 2) < count ? levels.at(4 * i + 2) : last;
+            int a = last;
+            p = qRgba(r, g, b, a);
+        }
+        image.setPixel(i / channels, i % channels, p);
+    }
+    image.save(cachePath);
+}
+
+// static
+bool AudioLevelsTask::readPeaks(const QString &path, qint64 first, int count, PeaksHeader &header, QVector<uint8_t> &peaks)
+{
+    peaks.clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic, version, samples, channels, frequency;
+    quint64 total;
+    in >> magic >> version >> samples >> channels >> frequency >> total;
+    if (in.status() != QDataStream::Ok || magic != peaksMagic || version != peaksVersion || samples == 0 || channels == 0 || frequency == 0) {
+        return false;
+    }
+    header.samplesPerPeak = int(samples);
+    header.channels = int(channels);
+    header.frequency = int(frequency);
+    header.count = qint64(total);
+    if (first < 0 || first >= header.count || count <= 0) {
+        return true;
+    }
+    const qint64 available = qMin(qint64(count), header.count - first);
+    if (!file.seek(peaksHeaderSize + first * header.channels)) {
+        return false;
+    }
+    const QByteArray data = file.read(available * header.channels);
+    peaks.resize(data.size());
+    memcpy(peaks.data(), data.constData(), size_t(data.size()));
+    return true;
+}
+
+// static
+bool AudioLevelsTask::writePeaks(const QString &path, int channels, int frequency, const QVector<uint8_t> &peaks)
+{
+    if (channels <= 0) {
+        return false;
+    }
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out << peaksMagic << peaksVersion << quint32(samplesPerPeak) << quint32(channels) << quint32(frequency) << quint64(peaks.size() / channels);
+    out.writeRawData(reinterpret_cast<const char *>(peaks.constData()), peaks.size());
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+// static
+QThreadPool *AudioLevelsTask::levelsPool()
+{
+    static QThreadPool pool;
+    static const bool initialized = []() {
+        pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+        return true;
+    }();
+    Q_UNUSED(initialized)
+    return &pool;
+}
+
+// static
+QVector<QPair<int, int>> AudioLevelsTask::segmentRanges(int lengthInFrames, int minSegmentFrames, int maxSegments)
+{
+    const int count = qBound(1, maxSegments, qMax(1, lengthInFrames / qMax(1, minSegmentFrames)));
+    QVector<QPair<int, int>> ranges;
+    ranges.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        ranges.append({int(qint64(lengthInFrames) * i / count), int(qint64(lengthInFrames) * (i + 1) / count)});
+    }
+    return ranges;
+}
@@ -12,14 +12,52 @@
 
 #include <QRunnable>
 #include <QObject>
+#include <QPair>
+#include <QVector>
+#include <memory>
+
+class QThreadPool;
+
+namespace Mlt {
+class Producer;
+}
 
 class AudioLevelsTask : public AbstractTask
 {
 public:
+    /** @brief Description of a peaks file, which stores the peak level of each block of samples for zoomed in waveforms */
+    struct PeaksHeader
+    {
+        int samplesPerPeak = 0;
+        int channels = 0;
+        int frequency = 0;
+        /** @brief Number of peaks of each channel */
+        qint64 count = 0;
+    };
     AudioLevelsTask(const ObjectId &owner, QObject* object);
     static void start(const ObjectId &owner, QObject* object, bool force = false);
+    /** @brief Decode the audio streams of the clip that have cached levels but no peaks file, to draw a zoomed in waveform.
+        The audioPeaksReady slot of @param object is invoked once done, whether the peaks could be written or not */
+    static void startPeaks(const ObjectId &owner, QObject* object);
+    /** @brief Attach the @param levels of audio @param stream to @param producer and save them as an image in @param cachePath */
+    static void storeLevels(const std::shared_ptr<Mlt::Producer> &producer, int stream, int channels, const QVector<uint8_t> &levels, uint maxLevel,
+                            const QString &cachePath);
+    /** @brief Read the header of the peaks file @param path and the levels of @param count peaks starting at @param first, interleaved by channel.
+        Only the requested range is read from the file. Returns false if the file does not exist or is invalid */
+    static bool readPeaks(const QString &path, qint64 first, int count, PeaksHeader &header, QVector<uint8_t> &peaks);
+    /** @brief Save the @param peaks levels of @param channels interleaved channels to @param path, the file is only replaced once complete */
+    static bool writePeaks(const QString &path, int channels, int frequency, const QVector<uint8_t> &peaks);
+    /** @brief The threads decoding audio levels, shared by all the tasks so that parallel tasks don't multiply the decoders */
+    static QThreadPool *levelsPool();
+    /** @brief Split @param lengthInFrames frames in at most @param maxSegments ranges [in, out) of at least @param minSegmentFrames frames,
+        each decoded by its own producer */
+    static QVector<QPair<int, int>> segmentRanges(int lengthInFrames, int minSegmentFrames, int maxSegments);
 
 protected:
     void run() override;
 
+private:
+    /** @brief Only create the missing peaks files, the levels are already attached to the producer */
+    bool m_peaksOnly;
+    void generateLevels();
 };
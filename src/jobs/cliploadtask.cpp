@@ -14,6 +14,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/mediaprobecache.h"
 #include "utils/thumbnailcache.hpp"
 
 #include "xml/xml.hpp"
@@ -306,6 +307,7 @@ void ClipLoadTask::run()
         service.clear();
     }
     std::shared_ptr<Mlt::Producer> producer;
+    QMap<QString, QString> probeProperties;
     switch (type) {
     case ClipType::Color:
         producer = loadResource(resource, QStringLiteral("color:"));
@@ -430,7 +432,18 @@ void ClipLoadTask::run()
         break;
     }
     default:
-        if (!service.isEmpty()) {
+        if (!m_isForce && (service.isEmpty() || service.startsWith(QLatin1String("avformat")))) {
+            probeProperties = MediaProbeCache::properties(resource, pCore->getCurrentFps());
+        }
+        if (!probeProperties.isEmpty()) {
+            // This file was already probed, the real opening is deferred until a frame is requested
+            producer = loadResource(resource, QStringLiteral("avformat-novalidate:"));
+            for (auto i = probeProperties.cbegin(); i != probeProperties.cend(); ++i) {
+                producer->set(i.key().toUtf8().constData(), i.value().toUtf8().constData());
+            }
+            producer->set("out", producer->get_length() - 1);
+            producer->set("mute_on_pause", 0);
+        } else if (!service.isEmpty()) {
             service.append(QChar(':'));
             if (service == QLatin1String("avformat-novalidate:")) {
                 service = QStringLiteral("avformat:");
@@ -601,75 +614,78 @@ void ClipLoadTask::run()
                 vindex = -1;
             }
         }
-        QSize frameSize = pCore->getCurrentFrameSize();
-        int w = frameSize.width();
-        int h = frameSize.height();
-        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
-        frame->get_image(format, w, h);
-        // Check audio / video
-        hasAudio = frame->get_int("test_audio") == 0;
-        hasVideo = vindex > -1 && frame->get_int("test_image") == 0;
-        frame.reset();
-        if (hasAudio) {
-            if (hasVideo) {
-                producer->set("kdenlive:clip_type", 0);
-            } else {
-                producer->set("kdenlive:clip_type", 1);
-            }
-        } else if (hasVideo) {
-            producer->set("kdenlive:clip_type", 2);
-        }
-        // Check if file is seekable
-        seekable = producer->get_int("seekable");
         if (vindex <= -1) {
             checkProfile = false;
         }
-        if (!seekable) {
-            if (checkProfile) {
-                pCore->bin()->shouldCheckProfile = false;
-            }
-            ClipType::ProducerType cType = type;
-            if (cType == ClipType::Unknown) {
-                // Check if it is an audio or video only clip
-                if (!hasVideo) {
-                    cType = ClipType::Audio;
-                } else if (!hasAudio) {
-                    cType = ClipType::Video;
+        // Stream info and clip type of files found in the probe cache are known, only files without issues are stored there
+        if (probeProperties.isEmpty()) {
+            QSize frameSize = pCore->getCurrentFrameSize();
+            int w = frameSize.width();
+            int h = frameSize.height();
+            std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+            frame->get_image(format, w, h);
+            // Check audio / video
+            hasAudio = frame->get_int("test_audio") == 0;
+            hasVideo = vindex > -1 && frame->get_int("test_image") == 0;
+            frame.reset();
+            if (hasAudio) {
+                if (hasVideo) {
+                    producer->set("kdenlive:clip_type", 0);
                 } else {
-                    cType = ClipType::AV;
+                    producer->set("kdenlive:clip_type", 1);
                 }
+            } else if (hasVideo) {
+                producer->set("kdenlive:clip_type", 2);
             }
-            QMetaObject::invokeMethod(pCore->bin(), "requestTranscoding", Qt::QueuedConnection, Q_ARG(QString, resource),
-                                      Q_ARG(QString, QString::number(m_owner.itemId)), Q_ARG(int, cType), Q_ARG(bool, checkProfile), Q_ARG(QString, QString()),
-                                      Q_ARG(QString, i18n("File <b>%1</b> is not seekable.", QFileInfo(resource).fileName())));
-        }
-
-        // Check for variable frame rate
-        isVariableFrameRate = producer->get_int("meta.media.variable_frame_rate");
-        if (isVariableFrameRate && seekable) {
-            if (checkProfile) {
-                pCore->bin()->shouldCheckProfile = false;
-            }
-            QString adjustedFpsString;
-            if (fps > 0) {
-                int integerFps = qRound(fps);
-                adjustedFpsString = QString("-%1fps").arg(integerFps);
+            // Check if file is seekable
+            seekable = producer->get_int("seekable");
+            if (!seekable) {
+                if (checkProfile) {
+                    pCore->bin()->shouldCheckProfile = false;
+                }
+                ClipType::ProducerType cType = type;
+                if (cType == ClipType::Unknown) {
+                    // Check if it is an audio or video only clip
+                    if (!hasVideo) {
+                        cType = ClipType::Audio;
+                    } else if (!hasAudio) {
+                        cType = ClipType::Video;
+                    } else {
+                        cType = ClipType::AV;
+                    }
+                }
+                QMetaObject::invokeMethod(pCore->bin(), "requestTranscoding", Qt::QueuedConnection, Q_ARG(QString, resource),
+                                          Q_ARG(QString, QString::number(m_owner.itemId)), Q_ARG(int, cType), Q_ARG(bool, checkProfile), Q_ARG(QString, QString()),
+                                          Q_ARG(QString, i18n("File <b>%1</b> is not seekable.", QFileInfo(resource).fileName())));
             }
-            ClipType::ProducerType cType = type;
-            if (cType == ClipType::Unknown) {
-                // Check if it is an audio or video only clip
-                if (!hasVideo) {
-                    cType = ClipType::Audio;
-                } else if (!hasAudio) {
-                    cType = ClipType::Video;
-                } else {
-                    cType = ClipType::AV;
+
+            // Check for variable frame rate
+            isVariableFrameRate = producer->get_int("meta.media.variable_frame_rate");
+            if (isVariableFrameRate && seekable) {
+                if (checkProfile) {
+                    pCore->bin()->shouldCheckProfile = false;
                 }
+                QString adjustedFpsString;
+                if (fps > 0) {
+                    int integerFps = qRound(fps);
+                    adjustedFpsString = QString("-%1fps").arg(integerFps);
+                }
+                ClipType::ProducerType cType = type;
+                if (cType == ClipType::Unknown) {
+                    // Check if it is an audio or video only clip
+                    if (!hasVideo) {
+                        cType = ClipType::Audio;
+                    } else if (!hasAudio) {
+                        cType = ClipType::Video;
+                    } else {
+                        cType = ClipType::AV;
+                    }
+                }
+                QMetaObject::invokeMethod(pCore->bin(), "requestTranscoding", Qt::QueuedConnection, Q_ARG(QString, resource),
+                                          Q_ARG(QString, QString::number(m_owner.itemId)), Q_ARG(int, cType), Q_ARG(bool, checkProfile),
+                                          Q_ARG(QString, adjustedFpsString),
+                                          Q_ARG(QString, i18n("File <b>%1</b> has a variable frame rate.", QFileInfo(resource).fileName())));
             }
-            QMetaObject::invokeMethod(pCore->bin(), "requestTranscoding", Qt::QueuedConnection, Q_ARG(QString, resource),
-                                      Q_ARG(QString, QString::number(m_owner.itemId)), Q_ARG(int, cType), Q_ARG(bool, checkProfile),
-                                      Q_ARG(QString, adjustedFpsString),
-                                      Q_ARG(QString, i18n("File <b>%1</b> has a variable frame rate.", QFileInfo(resource).fileName())));
         }
 
         if (fps <= 0 && !m_isCanceled.loadAcquire()) {
@@ -679,6 +695,9 @@ void ClipLoadTask::run()
                 fps = producer->get_double("source_fps");
             }
         }
+        if (probeProperties.isEmpty() && seekable && !isVariableFrameRate && !m_isCanceled.loadAcquire()) {
+            MediaProbeCache::store(resource, producer.get(), pCore->getCurrentFps());
+        }
     }
     if (fps <= 0 && type == ClipType::Unknown) {
         // something wrong, maybe audio file with embedded image
@@ -689,6 +708,8 @@ void ClipLoadTask::run()
     if (!m_isCanceled.loadAcquire()) {
         auto binClip = pCore->projectItemModel()->getClipByBinID(QString::number(m_owner.itemId));
         if (binClip) {
+            // Only keep the clip metadata until it is used
+            ProjectClip::closeDecoders(producer);
             QMetaObject::invokeMethod(binClip.get(), "setProducer", Qt::QueuedConnection, Q_ARG(std::shared_ptr<Mlt::Producer>, std::move(producer)),
                                       Q_ARG(bool, true));
             if (checkProfile && !isVariableFrameRate && seekable) {
@@ -5,18 +5,28 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 */
 
 #include "proxytask.h"
+#include "audio/audioStreamInfo.h"
 #include "bin/bin.h"
 #include "bin/projectclip.h"
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "jobs/audiolevelstask.h"
 #include "kdenlive_debug.h"
 #include "kdenlivesettings.h"
 #include "macros.hpp"
+#include "utils/thumbnailcache.hpp"
 
+#include <QCoreApplication>
+#include <QDir>
+#include <QLocalServer>
+#include <QLocalSocket>
 #include <QProcess>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 #include <QThread>
+#include <QtMath>
+#include <set>
 
 #include <KLocalizedString>
 
@@ -60,6 +70,7 @@ void ProxyTask::run()
         m_progress = 100;
         QMetaObject::invokeMethod(m_object, "updateJobProgress");
         QMetaObject::invokeMethod(binClip.get(), "updateProxyProducer", Qt::QueuedConnection, Q_ARG(QString, dest));
+        startMissingAudioLevels(binClip);
         return;
     }
 
@@ -340,14 +351,30 @@ void ProxyTask::run()
         parameters << QStringLiteral("-ignore_unknown");
         parameters << dest;
         qDebug() << "/// FULL PROXY PARAMS:\n" << parameters << "\n------";
-        m_jobProcess.reset(new QProcess);
-        // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
-        QObject::connect(m_jobProcess.get(), &QProcess::readyReadStandardError, this, &ProxyTask::processLogInfo);
-        QObject::connect(this, &ProxyTask::jobCanceled, m_jobProcess.get(), &QProcess::kill, Qt::DirectConnection);
-        m_jobProcess->start(KdenliveSettings::ffmpegpath(), parameters, QIODevice::ReadOnly);
-        AbstractTask::setPreferredPriority(m_jobProcess->processId());
-        m_jobProcess->waitForFinished(-1);
-        result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        if (KdenliveSettings::ingestpipeline()) {
+            result = ingest(binClip, parameters, source, dest);
+            if (!result && !m_isCanceled) {
+                m_progress = 0;
+            }
+        }
+        const QList<double> splitTimes = result || m_isCanceled ? QList<double>() : segmentSplitTimes(binClip, source, proxyParams);
+        if (!splitTimes.isEmpty()) {
+            result = encodeSegments(parameters, source, dest, splitTimes, binClip->duration().seconds(), binClip->audioStreamsCount() > 0);
+            if (!result && !m_isCanceled) {
+                qCDebug(KDENLIVE_LOG) << "Segmented proxy encoding failed, encoding in one pass";
+                m_progress = 0;
+            }
+        }
+        if (!result && !m_isCanceled) {
+            m_jobProcess.reset(new QProcess);
+            // m_jobProcess->setProcessChannelMode(QProcess::MergedChannels);
+            QObject::connect(m_jobProcess.get(), &QProcess::readyReadStandardError, this, &ProxyTask::processLogInfo);
+            QObject::connect(this, &ProxyTask::jobCanceled, m_jobProcess.get(), &QProcess::kill, Qt::DirectConnection);
+            m_jobProcess->start(KdenliveSettings::ffmpegpath(), parameters, QIODevice::ReadOnly);
+            AbstractTask::setPreferredPriority(m_jobProcess->processId());
+            m_jobProcess->waitForFinished(-1);
+            result = m_jobProcess->exitStatus() == QProcess::NormalExit;
+        }
     }
     // remove temporary playlist if it exists
     m_progress = 100;
@@ -374,7 +401,498 @@ void ProxyTask::run()
         }
     }
     QMetaObject::invokeMethod(m_object, "updateJobProgress");
-    return;
+    startMissingAudioLevels(binClip);
+}
+
+void ProxyTask::startMissingAudioLevels(const std::shared_ptr<ProjectClip> &binClip)
+{
+    // The clip skipped its audio levels task when the ingest was supposed to create them
+    if (!KdenliveSettings::ingestpipeline() || !KdenliveSettings::audiothumbnails() || binClip->clipType() != ClipType::AV || pCore->taskManager.isBlocked()) {
+        return;
+    }
+    const int stream = binClip->audioInfo() ? binClip->audioInfo()->audio_index() : -1;
+    if (stream < 0 || QFile::exists(binClip->getAudioThumbPath(stream))) {
+        return;
+    }
+    const ObjectId owner(ObjectType::BinClip, m_owner.itemId, QUuid());
+    QObject *object = m_object;
+    QMetaObject::invokeMethod(
+        m_object, [owner, object]() { AudioLevelsTask::start(owner, object, false); }, Qt::QueuedConnection);
+}
+
+QStringList ProxyTask::ingestArguments(const QStringList &parameters, QSize size, int frameRateNum, int frameRateDen, const QString &source, bool hasAudio,
+                                       const QString &audioInput, int frequency, int channels)
+{
+    const int inputIndex = parameters.indexOf(QStringLiteral("-i"));
+    QStringList args = parameters.mid(0, inputIndex);
+    args.removeAll(QStringLiteral("-noautorotate"));
+    args.removeAll(QStringLiteral("-stats"));
+    args << QStringLiteral("-f") << QStringLiteral("rawvideo") << QStringLiteral("-pix_fmt") << QStringLiteral("yuyv422") << QStringLiteral("-video_size")
+         << QStringLiteral("%1x%2").arg(size.width()).arg(size.height()) << QStringLiteral("-framerate")
+         << QStringLiteral("%1/%2").arg(frameRateNum).arg(frameRateDen) << QStringLiteral("-i") << QStringLiteral("pipe:0");
+    if (hasAudio) {
+        if (audioInput.isEmpty()) {
+            args << QStringLiteral("-i") << source;
+        } else {
+            args << QStringLiteral("-f") << QStringLiteral("s16le") << QStringLiteral("-ar") << QString::number(frequency) << QStringLiteral("-ac")
+                 << QString::number(channels) << QStringLiteral("-i") << audioInput;
+        }
+    }
+    QStringList output = parameters.mid(inputIndex + 2);
+    const int mapIndex = output.lastIndexOf(QStringLiteral("-map"));
+    output[mapIndex + 1] = QStringLiteral("0:v");
+    if (hasAudio) {
+        output.insert(mapIndex + 2, QStringLiteral("-map"));
+        output.insert(mapIndex + 3, QStringLiteral("1:a"));
+    }
+    args << output;
+    return args;
+}
+
+bool ProxyTask::ingest(const std::shared_ptr<ProjectClip> &binClip, const QStringList &parameters, const QString &source, const QString &dest)
+{
+    const int inputIndex = parameters.indexOf(QStringLiteral("-i"));
+    if (inputIndex < 0 || inputIndex + 1 >= parameters.count() || parameters.at(inputIndex + 1) != source || !parameters.contains(QStringLiteral("-map"))) {
+        // Hardware decoding parameters
+        return false;
+    }
+    // Frames are decoded at the project frame rate, so thumbnails and audio levels match the bin clip frames
+    Mlt::Profile &profile = pCore->getProjectProfile();
+    const int length = binClip->getFramePlaytime();
+    if (qAbs(binClip->getOriginalFps() - profile.fps()) > 0.001 || binClip->getProducerProperty(QStringLiteral("meta.media.progressive")) == QLatin1String("0") ||
+        length <= 0) {
+        return false;
+    }
+    double displayRatio = KdenliveDoc::getDisplayRatio(source);
+    int width = pCore->currentDoc()->getDocumentProperty(QStringLiteral("proxyresize")).toInt();
+    if (displayRatio < 1e-6 || width <= 0) {
+        return false;
+    }
+    width += width % 2;
+    int height = qRound(width / displayRatio);
+    height += height % 2;
+
+    std::unique_ptr<Mlt::Producer> producer(new Mlt::Producer(profile, "avformat", source.toUtf8().constData()));
+    if (!producer->is_valid()) {
+        return false;
+    }
+    if (parameters.contains(QStringLiteral("-noautorotate"))) {
+        producer->set("autorotate", 0);
+    }
+    // Converters used to deliver frames at the proxy size, then in rgba for thumbnails
+    for (const QVector<const char *> &services : {QVector<const char *>{"avcolor_space", "imageconvert"}, QVector<const char *>{"swscale", "rescale"}}) {
+        for (const char *service : services) {
+            Mlt::Filter filter(profile, service);
+            if (filter.is_valid()) {
+                producer->attach(filter);
+                break;
+            }
+        }
+    }
+    const int stream = binClip->audioInfo() ? binClip->audioInfo()->audio_index() : -1;
+    const bool computeLevels = KdenliveSettings::audiothumbnails() && stream >= 0 && !QFile::exists(binClip->getAudioThumbPath(stream));
+    const bool hasAudio = binClip->audioStreamsCount() > 0;
+    // A single audio stream is decoded with the video and written to FFmpeg through a local socket, so the source is only read once
+    std::unique_ptr<QLocalServer> audioServer;
+#ifndef Q_OS_WIN
+    if (stream >= 0 && binClip->audioStreamsCount() == 1) {
+        audioServer.reset(new QLocalServer);
+        audioServer->setSocketOptions(QLocalServer::UserAccessOption);
+        const QString socketPath =
+            QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-ingest-%1-%2").arg(QCoreApplication::applicationPid()).arg(m_owner.itemId));
+        QLocalServer::removeServer(socketPath);
+        if (!audioServer->listen(socketPath)) {
+            audioServer.reset();
+        }
+    }
+#endif
+    int frequency = 48000;
+    int channels = 2;
+    QStringList levelKeys;
+    if (computeLevels || audioServer) {
+        frequency = binClip->audioInfo()->samplingRate() > 0 ? binClip->audioInfo()->samplingRate() : 48000;
+        channels = binClip->audioInfo()->channelsForStream(stream);
+        if (channels <= 0) {
+            channels = binClip->audioInfo()->channels() > 0 ? binClip->audioInfo()->channels() : 2;
+        }
+        producer->set("audio_index", stream);
+        Mlt::Filter chans(profile, "audiochannels");
+        Mlt::Filter converter(profile, "audioconvert");
+        producer->attach(chans);
+        producer->attach(converter);
+        if (computeLevels) {
+            Mlt::Filter levels(profile, "audiolevel");
+            producer->attach(levels);
+            for (int i = 0; i < channels; i++) {
+                levelKeys << "meta.media.audio_level." + QString::number(i);
+            }
+        }
+    } else {
+        producer->set("audio_index", -1);
+    }
+
+    // Same thumbnails as the CacheTask
+    const QString clipId = QString::number(m_owner.itemId);
+    std::set<int> thumbPositions;
+    const int thumbStep = qCeil(qMax(profile.fps(), double(length) / 30));
+    for (int pos = 0; pos < length; pos += thumbStep) {
+        thumbPositions.insert(pos);
+    }
+    const int thumbHeight = pCore->thumbProfile().height();
+    int thumbWidth = qRound(thumbHeight * displayRatio);
+    thumbWidth += thumbWidth % 2;
+
+    // Raw frames come through stdin. With several audio streams, FFmpeg reads the source again for the audio, at the pace of our decoding so from the disk cache
+    const QStringList args =
+        ingestArguments(parameters, QSize(width, height), profile.frame_rate_num(), profile.frame_rate_den(), source, hasAudio,
+                        audioServer ? QStringLiteral("unix://%1").arg(audioServer->fullServerName()) : QString(), frequency, channels);
+    QProcess encoder;
+    encoder.start(KdenliveSettings::ffmpegpath(), args);
+    if (!encoder.waitForStarted()) {
+        return false;
+    }
+    AbstractTask::setPreferredPriority(encoder.processId());
+
+    QVector<uint8_t> levels;
+    uint maxLevel = 1;
+    const qint64 frameBytes = qint64(width) * height * 2;
+    // FFmpeg only connects to the audio socket once it probed the video input, keep the audio until then
+    QLocalSocket *audioSocket = nullptr;
+    QByteArray pendingAudio;
+    auto writeAudio = [&]() {
+        if (audioSocket == nullptr && audioServer->waitForNewConnection(0)) {
+            audioSocket = audioServer->nextPendingConnection();
+        }
+        if (audioSocket != nullptr) {
+            if (!pendingAudio.isEmpty()) {
+                audioSocket->write(pendingAudio);
+                pendingAudio.clear();
+            }
+            audioSocket->flush();
+        }
+    };
+    bool failed = false;
+    for (int pos = 0; pos < length && !m_isCanceled && !failed; ++pos) {
+        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+        if (!frame || !frame->is_valid()) {
+            failed = true;
+            break;
+        }
+        if (audioServer) {
+            int samples = mlt_audio_calculate_frame_samples(float(profile.fps()), frequency, pos);
+            const int sampleBytes = samples * channels * int(sizeof(int16_t));
+            if (frame->get_int("test_audio") == 0) {
+                mlt_audio_format audioFormat = mlt_audio_s16;
+                int frameFrequency = frequency;
+                int frameChannels = channels;
+                const auto *data = static_cast<const char *>(frame->get_audio(audioFormat, frameFrequency, frameChannels, samples));
+                if (data != nullptr && audioFormat == mlt_audio_s16 && frameChannels == channels) {
+                    pendingAudio.append(data, samples * channels * int(sizeof(int16_t)));
+                } else {
+                    pendingAudio.append(sampleBytes, '\0');
+                }
+            } else {
+                // Keep the audio in sync with the video
+                pendingAudio.append(sampleBytes, '\0');
+            }
+            writeAudio();
+            if (computeLevels && frame->get_int("test_audio") == 0) {
+                for (int channel = 0; channel < channels; ++channel) {
+                    uint lev = 256 * qMin(frame->get_double(levelKeys.at(channel).toUtf8().constData()) * 0.9, 1.0);
+                    levels << lev;
+                    maxLevel = qMax(lev, maxLevel);
+                }
+            } else if (computeLevels && !levels.isEmpty()) {
+                for (int channel = 0; channel < channels; channel++) {
+                    levels << levels.last();
+                }
+            }
+        } else if (computeLevels) {
+            if (frame->get_int("test_audio") == 0) {
+                mlt_audio_format audioFormat = mlt_audio_s16;
+                int samples = mlt_audio_calculate_frame_samples(float(profile.fps()), frequency, pos);
+                frame->get_audio(audioFormat, frequency, channels, samples);
+                for (int channel = 0; channel < channels; ++channel) {
+                    uint lev = 256 * qMin(frame->get_double(levelKeys.at(channel).toUtf8().constData()) * 0.9, 1.0);
+                    levels << lev;
+                    maxLevel = qMax(lev, maxLevel);
+                }
+            } else if (!levels.isEmpty()) {
+                for (int channel = 0; channel < channels; channel++) {
+                    levels << levels.last();
+                }
+            }
+        }
+        frame->set("consumer.rescale", "bilinear");
+        mlt_image_format format = mlt_image_yuv422;
+        int w = width;
+        int h = height;
+        const uint8_t *image = frame->get_image(format, w, h);
+        if (image == nullptr || format != mlt_image_yuv422 || w != width || h != height) {
+            failed = true;
+            break;
+        }
+        encoder.write(reinterpret_cast<const char *>(image), frameBytes);
+        if (thumbPositions.count(pos) > 0 && !ThumbnailCache::get()->hasThumbnail(clipId, pos)) {
+            format = mlt_image_rgba;
+            const uint8_t *rgba = frame->get_image(format, w, h);
+            if (rgba != nullptr && format == mlt_image_rgba) {
+                QImage thumb = QImage(rgba, w, h, QImage::Format_RGBA8888).scaled(thumbWidth, thumbHeight, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+                ThumbnailCache::get()->storeThumbnail(clipId, pos, thumb, true);
+            }
+        }
+        // Don't let the decoder run away from the encoder
+        while (encoder.bytesToWrite() > 4 * frameBytes) {
+            if (audioServer) {
+                // FFmpeg may be waiting for audio before reading more frames
+                writeAudio();
+            }
+            if (!encoder.waitForBytesWritten(audioServer ? 50 : 1000) && encoder.state() != QProcess::Running) {
+                failed = true;
+                break;
+            }
+        }
+        m_logDetails.append(QString::fromUtf8(encoder.readAllStandardError()));
+        int progress = 100 * pos / length;
+        if (progress > m_progress) {
+            m_progress = progress;
+            QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        }
+    }
+    if (audioServer && !failed && !m_isCanceled) {
+        // Send the remaining audio, then close the socket so FFmpeg sees the end of the stream. Short clips may need the end of the video
+        // before FFmpeg opens the audio input
+        encoder.closeWriteChannel();
+        while (!failed && (!pendingAudio.isEmpty() || audioSocket == nullptr || audioSocket->bytesToWrite() > 0)) {
+            writeAudio();
+            encoder.waitForBytesWritten(50);
+            if (audioSocket != nullptr && audioSocket->bytesToWrite() > 0) {
+                audioSocket->waitForBytesWritten(50);
+            }
+            failed = encoder.state() != QProcess::Running || (audioSocket != nullptr && audioSocket->state() != QLocalSocket::ConnectedState);
+        }
+        if (audioSocket != nullptr) {
+            audioSocket->disconnectFromServer();
+        }
+    }
+    if (failed || m_isCanceled) {
+        encoder.kill();
+        encoder.waitForFinished();
+        return false;
+    }
+    encoder.closeWriteChannel();
+    encoder.waitForFinished(-1);
+    m_logDetails.append(QString::fromUtf8(encoder.readAllStandardError()));
+    if (encoder.exitStatus() != QProcess::NormalExit || encoder.exitCode() != 0) {
+        return false;
+    }
+    if (computeLevels && !levels.isEmpty()) {
+        AudioLevelsTask::storeLevels(binClip->originalProducer(), stream, channels, levels, maxLevel, binClip->getAudioThumbPath(stream));
+        QMetaObject::invokeMethod(m_object, "updateAudioThumbnail", Q_ARG(bool, false));
+    }
+    return true;
+}
+
+QList<double> ProxyTask::segmentSplitTimes(const std::shared_ptr<ProjectClip> &binClip, const QString &source, const QString &proxyParams)
+{
+    QList<double> splitTimes;
+    // Don't bother splitting clips shorter than 10 minutes
+    const double duration = binClip->duration().seconds();
+    const int segments = qMin(8, QThread::idealThreadCount() / 4);
+    if (duration < 600 || segments < 2 || !QFileInfo(KdenliveSettings::ffprobepath()).isFile()) {
+        return splitTimes;
+    }
+    // Hardware encoders only accept a few concurrent sessions
+    static const QStringList hardwareCodecs = {QStringLiteral("nvenc"), QStringLiteral("nvcodec"), QStringLiteral("vaapi"), QStringLiteral("qsv"),
+                                               QStringLiteral("videotoolbox"), QStringLiteral("amf")};
+    for (const QString &codec : hardwareCodecs) {
+        if (proxyParams.contains(codec)) {
+            return splitTimes;
+        }
+    }
+    if (proxyParams.contains(QLatin1String("-i "))) {
+        return splitTimes;
+    }
+    // Joined segments put the video first, only split if that preserves the stream order
+    int videoStreams = 0;
+    const int streams = binClip->getProducerIntProperty(QStringLiteral("meta.media.nb_streams"));
+    for (int ix = 0; ix < streams; ix++) {
+        if (binClip->getProducerProperty(QStringLiteral("meta.media.%1.stream.type").arg(ix)) == QLatin1String("video")) {
+            videoStreams++;
+        }
+    }
+    if (videoStreams != 1 || binClip->getProducerProperty(QStringLiteral("meta.media.0.stream.type")) != QLatin1String("video")) {
+        return splitTimes;
+    }
+    double previous = 0.;
+    for (int ix = 1; ix < segments; ix++) {
+        double time = nextKeyframe(source, duration * ix / segments);
+        if (m_isCanceled) {
+            return {};
+        }
+        if (time > previous + 60 && time < duration - 60) {
+            splitTimes << time;
+            previous = time;
+        }
+    }
+    return splitTimes;
+}
+
+double ProxyTask::nextKeyframe(const QString &source, double time)
+{
+    QProcess probe;
+    probe.start(KdenliveSettings::ffprobepath(),
+                {QStringLiteral("-v"), QStringLiteral("error"), QStringLiteral("-select_streams"), QStringLiteral("v:0"), QStringLiteral("-read_intervals"),
+                 QStringLiteral("%1%+30").arg(time, 0, 'f', 3), QStringLiteral("-show_entries"), QStringLiteral("packet=pts_time,flags"),
+                 QStringLiteral("-of"), QStringLiteral("csv=p=0"), source});
+    if (!probe.waitForFinished(30000) || probe.exitStatus() != QProcess::NormalExit) {
+        probe.kill();
+        return -1;
+    }
+    const QStringList packets = QString::fromUtf8(probe.readAllStandardOutput()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
+    for (const QString &packet : packets) {
+        bool ok = false;
+        double pts = packet.section(QLatin1Char(','), 0, 0).toDouble(&ok);
+        if (ok && pts >= time && packet.section(QLatin1Char(','), 1, 1).startsWith(QLatin1Char('K'))) {
+            return pts;
+        }
+    }
+    return -1;
+}
+
+bool ProxyTask::encodeSegments(QStringList parameters, const QString &source, const QString &dest, const QList<double> &splitTimes, double duration,
+                               bool hasAudio)
+{
+    const QFileInfo destInfo(dest);
+    QTemporaryDir folder(destInfo.absoluteDir().absoluteFilePath(QStringLiteral(".proxy-segments-XXXXXX")));
+    const int inputIndex = parameters.indexOf(QStringLiteral("-i"));
+    const int mapIndex = parameters.lastIndexOf(QStringLiteral("-map"));
+    if (!folder.isValid() || inputIndex < 0 || mapIndex < 0) {
+        return false;
+    }
+    // Drop destination
+    parameters.removeLast();
+    QStringList videoParameters = parameters;
+    videoParameters[mapIndex + 1] = QStringLiteral("0:v");
+    videoParameters << QStringLiteral("-an");
+
+    std::vector<std::unique_ptr<QProcess>> processes;
+    QStringList segmentFiles;
+    QList<double> starts = splitTimes;
+    starts.prepend(0.);
+    for (int ix = 0; ix < starts.count(); ix++) {
+        QStringList args = videoParameters;
+        // Seek options apply to the input, so they must precede it
+        QStringList seek = {QStringLiteral("-ss"), QString::number(starts.at(ix), 'f', 6)};
+        if (ix + 1 < starts.count()) {
+            seek << QStringLiteral("-t") << QString::number(starts.at(ix + 1) - starts.at(ix), 'f', 6);
+        }
+        for (int j = seek.count() - 1; j >= 0; j--) {
+            args.insert(inputIndex, seek.at(j));
+        }
+        segmentFiles << folder.filePath(QStringLiteral("segment-%1.%2").arg(ix).arg(destInfo.suffix()));
+        args << segmentFiles.last();
+        processes.push_back(std::make_unique<QProcess>());
+        processes.back()->setArguments(args);
+    }
+    QString audioFile;
+    if (hasAudio) {
+        // Encode the audio in one pass so that no gap can be heard at segment boundaries
+        QStringList args = {QStringLiteral("-hide_banner"), QStringLiteral("-y"),  QStringLiteral("-v"),  QStringLiteral("error"), QStringLiteral("-i"),
+                            source,                         QStringLiteral("-vn"), QStringLiteral("-sn"), QStringLiteral("-dn"),   QStringLiteral("-map"),
+                            QStringLiteral("0:a")};
+        static const QStringList audioOptions = {QStringLiteral("-acodec"), QStringLiteral("-c:a"), QStringLiteral("-codec:a"), QStringLiteral("-ab"),
+                                                 QStringLiteral("-b:a"),    QStringLiteral("-ar"),  QStringLiteral("-ac"),      QStringLiteral("-aq"),
+                                                 QStringLiteral("-q:a")};
+        for (int ix = inputIndex + 2; ix + 1 < parameters.count(); ix++) {
+            if (audioOptions.contains(parameters.at(ix))) {
+                args << parameters.at(ix) << parameters.at(ix + 1);
+            }
+        }
+        audioFile = folder.filePath(QStringLiteral("audio.%1").arg(destInfo.suffix()));
+        args << audioFile;
+        processes.push_back(std::make_unique<QProcess>());
+        processes.back()->setArguments(args);
+    }
+    for (auto &process : processes) {
+        process->setReadChannel(QProcess::StandardError);
+        process->setProgram(KdenliveSettings::ffmpegpath());
+        process->start(QIODevice::ReadOnly);
+        AbstractTask::setPreferredPriority(process->processId());
+    }
+    // Follow the encoded time of each video segment
+    QVector<double> encodedTimes(starts.count(), 0.);
+    bool running = true;
+    while (running) {
+        running = false;
+        for (size_t ix = 0; ix < processes.size(); ix++) {
+            QProcess *process = processes.at(ix).get();
+            if (process->state() == QProcess::NotRunning) {
+                continue;
+            }
+            process->waitForReadyRead(100);
+            const QString buffer = QString::fromUtf8(process->readAllStandardError());
+            if (buffer.contains(QLatin1String("time=")) && int(ix) < encodedTimes.count()) {
+                const QStringList numbers = buffer.section(QStringLiteral("time="), -1).simplified().section(QLatin1Char(' '), 0, 0).split(QLatin1Char(':'));
+                if (numbers.size() == 3) {
+                    encodedTimes[int(ix)] = numbers.at(0).toInt() * 3600 + numbers.at(1).toInt() * 60 + numbers.at(2).toDouble();
+                }
+            } else if (!buffer.isEmpty()) {
+                m_logDetails.append(buffer);
+            }
+            running = running || process->state() != QProcess::NotRunning;
+        }
+        if (m_isCanceled) {
+            for (auto &process : processes) {
+                process->kill();
+                process->waitForFinished();
+            }
+            return false;
+        }
+        double encoded = 0.;
+        for (double time : qAsConst(encodedTimes)) {
+            encoded += time;
+        }
+        // Keep the last percents for the joining step
+        int progress = qMin(95, int(95 * encoded / duration));
+        if (progress > m_progress) {
+            m_progress = progress;
+            QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        }
+    }
+    for (auto &process : processes) {
+        if (process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0) {
+            return false;
+        }
+    }
+
+    // Join the segments without re-encoding
+    QFile list(folder.filePath(QStringLiteral("segments.txt")));
+    if (!list.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return false;
+    }
+    QTextStream out(&list);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+    out.setCodec("UTF-8");
+#endif
+    for (QString segment : qAsConst(segmentFiles)) {
+        segment.replace(QLatin1Char('\''), QLatin1String("'\\''"));
+        out << "file '" << segment << "'\n";
+    }
+    list.close();
+    QStringList args = {QStringLiteral("-hide_banner"), QStringLiteral("-y"),   QStringLiteral("-v"),    QStringLiteral("error"),
+                        QStringLiteral("-f"),           QStringLiteral("concat"), QStringLiteral("-safe"), QStringLiteral("0"),
+                        QStringLiteral("-i"),           list.fileName()};
+    if (!audioFile.isEmpty()) {
+        args << QStringLiteral("-i") << audioFile << QStringLiteral("-map") << QStringLiteral("0:v") << QStringLiteral("-map") << QStringLiteral("1:a");
+    }
+    args << QStringLiteral("-c") << QStringLiteral("copy") << dest;
+    QProcess join;
+    QObject::connect(this, &ProxyTask::jobCanceled, &join, &QProcess::kill, Qt::DirectConnection);
+    join.start(KdenliveSettings::ffmpegpath(), args, QIODevice::ReadOnly);
+    join.waitForFinished(-1);
+    m_logDetails.append(QString::fromUtf8(join.readAllStandardError()));
+    return join.exitStatus() == QProcess::NormalExit && join.exitCode() == 0;
 }
 
 void ProxyTask::processLogInfo()
@@ -8,6 +8,9 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 
 #include "abstracttask.h"
 
+#include <QSize>
+
+class ProjectClip;
 class QProcess;
 
 class ProxyTask : public AbstractTask
@@ -23,6 +26,24 @@ private Q_SLOTS:
     void processLogInfo();
 
 private:
+    /** @brief Decode the clip once, feeding the frames to FFmpeg to encode the proxy while creating its thumbnails and audio levels.
+     *  @param parameters the FFmpeg arguments to encode the proxy from the source file
+     *  @returns false if the clip cannot be ingested this way or the encoding failed */
+    bool ingest(const std::shared_ptr<ProjectClip> &binClip, const QStringList &parameters, const QString &source, const QString &dest);
+    /** @brief Build the FFmpeg arguments encoding the raw frames piped by ingest() instead of decoding @param source
+     *  @param audioInput the local socket the decoded audio is written to, if empty FFmpeg reads the audio from the source */
+    static QStringList ingestArguments(const QStringList &parameters, QSize size, int frameRateNum, int frameRateDen, const QString &source, bool hasAudio,
+                                       const QString &audioInput = QString(), int frequency = 0, int channels = 0);
+    /** @brief Queue the audio levels task if the clip levels were expected from the ingest but it didn't create them */
+    void startMissingAudioLevels(const std::shared_ptr<ProjectClip> &binClip);
+    /** @brief Returns the source times where a long clip should be split to encode its proxy in parallel, on video keyframes.
+     *  Empty if the clip should be encoded in one pass */
+    QList<double> segmentSplitTimes(const std::shared_ptr<ProjectClip> &binClip, const QString &source, const QString &proxyParams);
+    /** @brief Returns the first video keyframe time after @param time, or -1 if none was found nearby */
+    static double nextKeyframe(const QString &source, double time);
+    /** @brief Encode the video segments starting at @param splitTimes concurrently and the audio in one pass, then join them into @param dest
+     *  @param parameters the FFmpeg arguments to encode the proxy in one pass */
+    bool encodeSegments(QStringList parameters, const QString &source, const QString &dest, const QList<double> &splitTimes, double duration, bool hasAudio);
     int m_jobDuration;
     bool m_isFfmpegJob;
     std::unique_ptr<QProcess> m_jobProcess;
@@ -0,0 +1,176 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "sequencerendertask.h"
+#include "bin/projectclip.h"
+#include "bin/projectitemmodel.h"
+#include "core.h"
+#include "doc/kdenlivedoc.h"
+#include "kdenlive_debug.h"
+#include "kdenlivesettings.h"
+
+#include <KLocalizedString>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRegularExpression>
+#include <QTemporaryFile>
+#include <QThread>
+
+SequenceRenderTask::SequenceRenderTask(const ObjectId &owner, QObject *object)
+    : AbstractTask(owner, AbstractTask::SEQUENCERENDERJOB, object)
+    , m_jobProcess(nullptr)
+{
+    m_description = i18n("Rendering sequence");
+}
+
+void SequenceRenderTask::start(const ObjectId &owner, QObject *object)
+{
+    if (pCore->taskManager.hasPendingJob(owner, AbstractTask::SEQUENCERENDERJOB)) {
+        return;
+    }
+    SequenceRenderTask *task = new SequenceRenderTask(owner, object);
+    pCore->taskManager.startTask(owner.itemId, task);
+}
+
+// static
+QString SequenceRenderTask::sequenceHash(const QString &xml)
+{
+    // Kdenlive properties (sequence position, zoom, clip names, ...) do not change the rendered frames
+    static const QRegularExpression kdenliveProperty(QStringLiteral("<property name=\"kdenlive:[^\"]*\"(?:/>|>[^<]*</property>)"));
+    static const QRegularExpression resourceProperty(QStringLiteral("<property name=\"(?:resource|warp_resource)\">([^<]+)</property>"));
+    QString content = xml;
+    content.remove(kdenliveProperty);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(content.toUtf8());
+    // The xml only has the file names, a file replaced or edited in place must not reuse the old render
+    QStringList stamps;
+    QRegularExpressionMatchIterator i = resourceProperty.globalMatch(xml);
+    while (i.hasNext()) {
+        QString resource = i.next().captured(1);
+        resource.replace(QLatin1String("&quot;"), QLatin1String("\"")).replace(QLatin1String("&apos;"), QLatin1String("'"));
+        resource.replace(QLatin1String("&lt;"), QLatin1String("<")).replace(QLatin1String("&gt;"), QLatin1String(">"));
+        resource.replace(QLatin1String("&amp;"), QLatin1String("&"));
+        QFileInfo info(resource);
+        if (!info.isFile() && resource.indexOf(QLatin1Char(':')) > 1) {
+            // Service prefix, like qimage: or avformat-novalidate:
+            info.setFile(resource.section(QLatin1Char(':'), 1));
+        }
+        if (info.isFile()) {
+            stamps << QStringLiteral("%1|%2|%3").arg(info.absoluteFilePath()).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+        }
+    }
+    stamps.sort();
+    stamps.removeDuplicates();
+    hash.addData(stamps.join(QLatin1Char('\n')).toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+// static
+QStringList SequenceRenderTask::consumerArguments(const QString &dest, int out, int threads)
+{
+    // Lossless intra frame video: the final render reuses it, and seeking stays as fast as in the uncompressed timeline
+    return {QStringLiteral("-consumer"),
+            QStringLiteral("avformat:%1").arg(dest),
+            QStringLiteral("out=%1").arg(out),
+            QStringLiteral("f=matroska"),
+            QStringLiteral("vcodec=ffv1"),
+            QStringLiteral("level=3"),
+            QStringLiteral("g=1"),
+            QStringLiteral("slices=%1").arg(threads > 1 ? 16 : 4),
+            QStringLiteral("pix_fmt=yuv422p"),
+            QStringLiteral("an=1"),
+            QStringLiteral("threads=%1").arg(threads),
+            QStringLiteral("terminate_on_pause=1"),
+            QStringLiteral("progress=1")};
+}
+
+void SequenceRenderTask::run()
+{
+    AbstractTaskDone whenFinished(m_owner.itemId, this);
+    if (m_isCanceled || pCore->taskManager.isBlocked()) {
+        return;
+    }
+    QMutexLocker lock(&m_runMutex);
+    m_running = true;
+    auto binClip = pCore->projectItemModel()->getClipByBinID(QString::number(m_owner.itemId));
+    if (binClip == nullptr || binClip->clipType() != ClipType::Timeline) {
+        return;
+    }
+    bool ok;
+    QDir cacheFolder = pCore->currentDoc()->getCacheDir(CacheSequence, &ok);
+    if (!ok) {
+        qWarning() << "Cannot write to cache folder: " << cacheFolder.absolutePath();
+        return;
+    }
+    QTemporaryFile playlist(QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-sequence-XXXXXX.mlt")));
+    if (!playlist.open()) {
+        return;
+    }
+    playlist.close();
+    binClip->cloneProducerToFile(playlist.fileName());
+    if (!playlist.open()) {
+        return;
+    }
+    const QString xml = QString::fromUtf8(playlist.readAll());
+    playlist.close();
+    // The intermediate would also be used by the final render, don't bake proxy quality into it
+    static const QRegularExpression proxyProperty(QStringLiteral("<property name=\"kdenlive:proxy\">(?!-<)[^<]+</property>"));
+    if (xml.isEmpty() || xml.contains(proxyProperty)) {
+        return;
+    }
+    const QString dest = cacheFolder.absoluteFilePath(sequenceHash(xml) + QStringLiteral(".mkv"));
+    QFileInfo fInfo(dest);
+    if (fInfo.exists() && fInfo.size() > 0) {
+        // Sequence already rendered with the same content
+        m_progress = 100;
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+        QMetaObject::invokeMethod(binClip.get(), "updateSequenceRender", Qt::QueuedConnection, Q_ARG(QString, dest));
+        return;
+    }
+    // Render to a temporary name so that an interrupted render is never used
+    const QString partial = dest + QStringLiteral(".part");
+    int threadCount = QThread::idealThreadCount();
+    if (threadCount > 2) {
+        threadCount = qMin(threadCount - 1, 4);
+    } else {
+        threadCount = 1;
+    }
+    QStringList mltParameters = consumerArguments(partial, binClip->frameDuration() - 1, threadCount);
+    mltParameters.prepend(playlist.fileName());
+    m_jobProcess.reset(new QProcess);
+    QObject::connect(this, &SequenceRenderTask::jobCanceled, m_jobProcess.get(), &QProcess::kill, Qt::DirectConnection);
+    QObject::connect(m_jobProcess.get(), &QProcess::readyReadStandardError, this, &SequenceRenderTask::processLogInfo);
+    m_jobProcess->start(KdenliveSettings::meltpath(), mltParameters);
+    AbstractTask::setPreferredPriority(m_jobProcess->processId());
+    m_jobProcess->waitForFinished(-1);
+    bool result = m_jobProcess->exitStatus() == QProcess::NormalExit && m_jobProcess->exitCode() == 0;
+    m_jobProcess.reset();
+    m_progress = 100;
+    QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    if (m_isCanceled || !result || QFileInfo(partial).size() == 0 || !QFile::rename(partial, dest)) {
+        if (!m_isCanceled) {
+            qWarning() << "Sequence render failed: " << m_logDetails;
+        }
+        QFile::remove(partial);
+        return;
+    }
+    QMetaObject::invokeMethod(binClip.get(), "updateSequenceRender", Qt::QueuedConnection, Q_ARG(QString, dest));
+}
+
+void SequenceRenderTask::processLogInfo()
+{
+    const QString buffer = QString::fromUtf8(m_jobProcess->readAllStandardError());
+    m_logDetails.append(buffer);
+    if (buffer.contains(QLatin1String("percentage:"))) {
+        m_progress = buffer.section(QStringLiteral("percentage:"), 1).simplified().section(QLatin1Char(' '), 0, 0).toInt();
+        QMetaObject::invokeMethod(m_object, "updateJobProgress");
+    }
+}
@@ -0,0 +1,42 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "abstracttask.h"
+
+#include <memory>
+
+class QProcess;
+
+/** @class SequenceRenderTask
+    @brief Render the video of a sequence clip to an intermediate file in the project cache.
+    The file is named after a hash of the sequence content and of the media files it uses, so that
+    an unchanged sequence (or one restored by undo) reuses the file rendered previously.
+    The intermediate is lossless since it is also used by the final render.
+ */
+class SequenceRenderTask : public AbstractTask
+{
+public:
+    SequenceRenderTask(const ObjectId &owner, QObject *object);
+    static void start(const ObjectId &owner, QObject *object);
+    /** @brief Returns the cache key of a sequence from its MLT xml, ignoring the Kdenlive properties that have no effect on rendering.
+     *  The size and modification time of the media files are included, so that a replaced file renders again */
+    static QString sequenceHash(const QString &xml);
+    /** @brief Returns the MLT consumer arguments rendering the intermediate to @param dest */
+    static QStringList consumerArguments(const QString &dest, int out, int threads);
+
+protected:
+    void run() override;
+
+private Q_SLOTS:
+    void processLogInfo();
+
+private:
+    std::unique_ptr<QProcess> m_jobProcess;
+    QString m_logDetails;
+};
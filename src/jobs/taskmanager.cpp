@@ -217,7 +217,7 @@ void TaskManager::startTask(int ownerId, AbstractTask *task)
     } else {
         m_taskList[ownerId].emplace_back(task);
     }
-    if (task->m_type == AbstractTask::TRANSCODEJOB || task->m_type == AbstractTask::PROXYJOB) {
+    if (task->m_type == AbstractTask::TRANSCODEJOB || task->m_type == AbstractTask::PROXYJOB || task->m_type == AbstractTask::SEQUENCERENDERJOB) {
         // We only want a limited concurrent jobs for those as for example GPU usually only accept 2 concurrent encoding jobs
         m_transcodePool.start(task, task->m_priority);
     } else {
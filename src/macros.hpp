@@ -55,6 +55,31 @@ reading a Read-protected property. In that case, we try to write lock it first (
         Q_ASSERT(false);                                                                                                                                       \
     }
 
+/** @brief Same as PUSH_UNDO, with the memory captured by the lambdas, in bytes, counted in the undo memory budget
+ */
+#define PUSH_ACCOUNTED_UNDO(undo, redo, text, memoryCost)                                                                                                      \
+    if (auto ptr = m_undoStack.lock()) {                                                                                                                       \
+        auto *command = new FunctionalUndoCommand(undo, redo, text);                                                                                           \
+        command->setMemoryCost(memoryCost);                                                                                                                    \
+        ptr->push(command);                                                                                                                                    \
+    } else {                                                                                                                                                   \
+        qDebug() << "ERROR : unable to access undo stack";                                                                                                     \
+        Q_ASSERT(false);                                                                                                                                       \
+    }
+
+/** @brief Same as PUSH_UNDO, but the command is merged with the previous one if it operated on the same item with the same text shortly before.
+ * This is used for operations repeated in quick succession, like moving a clip with the keyboard
+ */
+#define PUSH_MERGEABLE_UNDO(undo, redo, text, itemId)                                                                                                          \
+    if (auto ptr = m_undoStack.lock()) {                                                                                                                       \
+        auto *command = new FunctionalUndoCommand(undo, redo, text);                                                                                           \
+        command->setMergeKey(itemId);                                                                                                                          \
+        ptr->push(command);                                                                                                                                    \
+    } else {                                                                                                                                                   \
+        qDebug() << "ERROR : unable to access undo stack";                                                                                                     \
+        Q_ASSERT(false);                                                                                                                                       \
+    }
+
 /** @brief This macro takes as parameter one atomic operation and its reverse, and update
  * the undo and redo functional stacks/queue accordingly
  * This should be used in the rare case where we don't need a lock mutex. In general, prefer the other version
@@ -17,6 +17,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "kcoreaddons_version.h"
 #include "kxmlgui_version.h"
 #include "mainwindow.h"
+#include "utils/decoderpool.h"
 
 #include <KAboutData>
 #include <KConfigGroup>
@@ -85,6 +86,8 @@ int main(int argc, char *argv[])
     QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts, true);
 
     QApplication app(argc, argv);
+    // Before MLT or any thread opens files
+    DecoderPool::raiseFileLimit();
 
     // Try to detect package type
     QString packageType;
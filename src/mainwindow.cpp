@@ -2325,18 +2325,22 @@ void MainWindow::slotCheckRenderStatus()
 
 void MainWindow::setRenderingProgress(const QString &url, int progress, int frame)
 {
-    Q_EMIT setRenderProgress(progress);
     if (m_renderWidget) {
         m_renderWidget->setRenderProgress(url, progress, frame);
+        // Several jobs may be running, show their average progress
+        progress = m_renderWidget->overallProgress();
     }
+    Q_EMIT setRenderProgress(progress);
 }
 
 void MainWindow::setRenderingFinished(const QString &url, int status, const QString &error)
 {
-    Q_EMIT setRenderProgress(100);
+    int progress = 100;
     if (m_renderWidget) {
         m_renderWidget->setRenderStatus(url, status, error);
+        progress = m_renderWidget->overallProgress();
     }
+    Q_EMIT setRenderProgress(progress);
 }
 
 void MainWindow::addProjectClip(const QString &url, const QString &folder)
@@ -4804,6 +4808,16 @@ TimelineWidget *MainWindow::openTimeline(const QUuid &uuid, const QString &tabNa
     return timeline;
 }
 
+void MainWindow::addPendingTimeline(const QUuid &uuid, const QString &tabName)
+{
+    m_timelineTabs->addPendingTimeline(uuid, tabName);
+}
+
+void MainWindow::unloadTimeline(const QUuid &uuid)
+{
+    m_timelineTabs->unloadTimeline(uuid);
+}
+
 bool MainWindow::raiseTimeline(const QUuid &uuid)
 {
     return m_timelineTabs->raiseTimeline(uuid);
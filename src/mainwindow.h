@@ -183,6 +183,10 @@ public:
     /** @brief Check if the maximum cached data size is not exceeded. */
     void checkMaxCacheSize();
     TimelineWidget *openTimeline(const QUuid &uuid, const QString &tabName, std::shared_ptr<TimelineItemModel> timelineModel);
+    /** @brief Add a tab for a sequence that is only built when the tab is activated */
+    void addPendingTimeline(const QUuid &uuid, const QString &tabName);
+    /** @brief Release the timeline of an inactive sequence, keeping its tab */
+    void unloadTimeline(const QUuid &uuid);
     /** @brief Bring a timeline tab in front. Returns false if no tab exists for this timeline. */
     bool raiseTimeline(const QUuid &uuid);
     void connectTimeline();
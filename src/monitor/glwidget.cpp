@@ -13,6 +13,7 @@
 */
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QFontDatabase>
 #include <QOpenGLContext>
 #include <QOpenGLFunctions_3_2_Core>
@@ -37,9 +38,12 @@
 
 #include "bin/model/markersortmodel.h"
 #include "core.h"
+#include "doc/kdenlivedoc.h"
 #include "glwidget.h"
+#include "monitorframecache.h"
 #include "monitorproxy.h"
 #include "profiles/profilemodel.hpp"
+#include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/qml/timelineitems.h"
 #include "timeline2/view/qmltypes/thumbnailprovider.h"
 #include <lib/localeHandling.h>
@@ -107,6 +111,8 @@ GLWidget::GLWidget(int id, QWidget *parent)
     , m_isLoopMode(false)
     , m_loopIn(0)
     , m_offset(QPoint(0, 0))
+    , m_shuttleSpeed(0.)
+    , m_shuttlePosition(0)
     , m_fbo(nullptr)
     , m_shareContext(nullptr)
     , m_openGLSync(false)
@@ -157,6 +163,15 @@ GLWidget::GLWidget(int id, QWidget *parent)
     m_blackClip->set("kdenlive:id", "black");
     m_blackClip->set("out", 3);
     connect(&m_refreshTimer, &QTimer::timeout, this, &GLWidget::refresh);
+    m_frameCache = new MonitorFrameCache(this);
+    m_frameCache->setBudget(KdenliveSettings::monitorFrameCache());
+    m_prefetchTimer.setSingleShot(true);
+    m_prefetchTimer.setInterval(200);
+    connect(&m_prefetchTimer, &QTimer::timeout, this, &GLWidget::startPrefetch);
+    m_shuttleTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_shuttleTimer, &QTimer::timeout, this, &GLWidget::shuttleStep);
+    m_governorTimer.setInterval(500);
+    connect(&m_governorTimer, &QTimer::timeout, this, &GLWidget::updatePlaybackGovernor);
     m_producer = m_blackClip;
     rootContext()->setContextProperty("markersModel", nullptr);
     if (!initGPUAccel()) {
@@ -726,13 +741,26 @@ bool GLWidget::isReady() const
 
 void GLWidget::requestSeek(int position, bool noAudioScrub)
 {
+    const bool scrubAudio = KdenliveSettings::audio_scrub() && !noAudioScrub;
+    m_shuttlePosition = position;
     m_producer->seek(position);
+    if (frameCacheEnabled()) {
+        // A single seek does not need the prefetch producer, only start it when the user scrubs
+        if (m_prefetchTimer.isActive() || (m_lastSeek.isValid() && m_lastSeek.elapsed() < 500)) {
+            m_prefetchTimer.start();
+        }
+        m_lastSeek.start();
+        // Audio scrubbing needs the consumer, so only use cached frames when it is off
+        if (!scrubAudio && qFuzzyIsNull(m_producer->get_speed()) && showCachedFrame(position)) {
+            return;
+        }
+    }
     if (!qFuzzyIsNull(m_producer->get_speed())) {
         m_consumer->purge();
     }
     restartConsumer();
     m_consumer->set("refresh", 1);
-    if (KdenliveSettings::audio_scrub() && !noAudioScrub) {
+    if (scrubAudio) {
         m_consumer->set("scrub_audio", 1);
     } else {
         m_consumer->set("scrub_audio", 0);
@@ -741,12 +769,129 @@ void GLWidget::requestSeek(int position, bool noAudioScrub)
 
 void GLWidget::requestRefresh()
 {
+    invalidateFrameCache();
     if (m_producer && qFuzzyIsNull(m_producer->get_speed())) {
         m_consumer->set("scrub_audio", 0);
         m_refreshTimer.start();
     }
 }
 
+void GLWidget::invalidateFrameCache()
+{
+    m_frameCache->setBudget(KdenliveSettings::monitorFrameCache());
+    m_frameCache->invalidate();
+}
+
+bool GLWidget::frameCacheEnabled() const
+{
+    // GPU pipelines pass textures instead of images, which cannot be cached
+    return m_glslManager == nullptr && m_frameCache->isEnabled();
+}
+
+bool GLWidget::showCachedFrame(int position)
+{
+    if (m_frameRenderer == nullptr || !frameCacheEnabled()) {
+        return false;
+    }
+    SharedFrame cached;
+    if (!m_frameCache->lookup(position, cached) || !m_frameRenderer->semaphore()->tryAcquire()) {
+        return false;
+    }
+    Mlt::Frame frame = cached.clone(false, true);
+    frame.set("kdenlive:cached", 1);
+    QMetaObject::invokeMethod(m_frameRenderer, "showFrame", Qt::QueuedConnection, Q_ARG(Mlt::Frame, frame));
+    return true;
+}
+
+void GLWidget::startPrefetch()
+{
+    if (!m_producer || !m_consumer || !frameCacheEnabled()) {
+        return;
+    }
+    if (!m_frameCache->hasSource()) {
+        // The prefetch thread renders from its own copy of the producer, serialized here so it never races with edits
+        QByteArray xml;
+        if (m_id == Kdenlive::ProjectMonitor) {
+            std::shared_ptr<TimelineItemModel> timeline = pCore->currentDoc() ? pCore->currentDoc()->getTimeline(pCore->currentTimelineId()) : nullptr;
+            if (!timeline) {
+                return;
+            }
+            // Same path as saving, it leaves out the preview chunks rendered in memory
+            xml = timeline->sceneList(pCore->currentDoc()->documentRoot()).toUtf8();
+        } else {
+            xml = MonitorFrameCache::serialize(*m_producer.get());
+        }
+        QSize frameSize(m_consumer->get_int("width"), m_consumer->get_int("height"));
+        if (frameSize.isEmpty()) {
+            frameSize = m_profileSize;
+        }
+        const int duration = m_maxProducerPosition > 0 ? m_maxProducerPosition : m_producer->get_playtime();
+        m_frameCache->setSource(xml, frameSize, duration - 1, pCore->getCurrentFps());
+    }
+    if (m_shuttleTimer.isActive()) {
+        m_frameCache->prefetch(m_shuttlePosition, m_shuttleSpeed);
+    } else if (qFuzzyIsNull(m_producer->get_speed())) {
+        m_frameCache->prefetch(m_proxy->getPosition(), 0.);
+    }
+}
+
+bool GLWidget::canShuttleFromCache(double speed) const
+{
+    if (qFuzzyIsNull(speed) || qFuzzyCompare(speed, 1.0) || m_maxProducerPosition <= 0 || !frameCacheEnabled()) {
+        return false;
+    }
+    // Audio is only scrubbed by the consumer, so keep it in charge when audio is expected
+    return !KdenliveSettings::audio_scrub() || speed < -6. || speed > 6.;
+}
+
+void GLWidget::startCachedShuttle(double speed)
+{
+    if (!qFuzzyIsNull(m_producer->get_speed())) {
+        // Switching from consumer playback
+        m_producer->set_speed(0);
+        m_consumer->purge();
+    }
+    if (!m_shuttleTimer.isActive()) {
+        m_shuttlePosition = m_proxy->getPosition();
+    }
+    m_shuttleSpeed = speed;
+    m_proxy->setSpeed(speed);
+    m_consumer->set("scrub_audio", 0);
+    // Move by whole frames, the timer interval gives the exact speed
+    const int step = MonitorFrameCache::shuttleStep(speed);
+    m_shuttleTimer.start(qMax(1, qRound(1000. * step / (pCore->getCurrentFps() * qAbs(speed)))));
+    m_prefetchTimer.stop();
+    startPrefetch();
+}
+
+void GLWidget::stopCachedShuttle()
+{
+    m_shuttleTimer.stop();
+    m_shuttleSpeed = 0.;
+}
+
+void GLWidget::shuttleStep()
+{
+    const int step = MonitorFrameCache::shuttleStep(m_shuttleSpeed);
+    const int lastPosition = qMax(0, m_maxProducerPosition - 1);
+    m_shuttlePosition = qBound(0, m_shuttlePosition + (m_shuttleSpeed < 0 ? -step : step), lastPosition);
+    m_producer->seek(m_shuttlePosition);
+    if (!showCachedFrame(m_shuttlePosition)) {
+        // Not prefetched yet, let the consumer render it
+        restartConsumer();
+        m_consumer->set("refresh", 1);
+    }
+    if ((m_shuttleSpeed < 0 && m_shuttlePosition == 0) || (m_shuttleSpeed > 0 && m_shuttlePosition == lastPosition)) {
+        // checkFrameNumber pauses the monitor once this frame is displayed
+        m_shuttleTimer.stop();
+        m_frameCache->stopPrefetch();
+    } else if (m_frameCache->hasSource()) {
+        m_frameCache->prefetch(m_shuttlePosition, m_shuttleSpeed);
+    } else if (!m_prefetchTimer.isActive()) {
+        m_prefetchTimer.start();
+    }
+}
+
 QString GLWidget::frameToTime(int frames) const
 {
     return m_consumer ? m_consumer->frames_to_time(frames, mlt_time_smpte_df) : QStringLiteral("-");
@@ -755,6 +900,7 @@ QString GLWidget::frameToTime(int frames) const
 void GLWidget::refresh()
 {
     m_refreshTimer.stop();
+    invalidateFrameCache();
     QMutexLocker locker(&m_mltMutex);
     if (m_consumer) {
         restartConsumer();
@@ -764,7 +910,7 @@ void GLWidget::refresh()
 
 bool GLWidget::checkFrameNumber(int pos, bool isPlaying)
 {
-    const double speed = m_producer->get_speed();
+    const double speed = qFuzzyIsNull(m_shuttleSpeed) ? m_producer->get_speed() : m_shuttleSpeed;
     m_proxy->positionFromConsumer(pos, isPlaying);
     if (m_isLoopMode || m_isZoneMode) {
         // not sure why we need to check against pos + 1 but otherwise the
@@ -780,6 +926,7 @@ bool GLWidget::checkFrameNumber(int pos, bool isPlaying)
                 m_proxy->setPosition(m_loopOut);
                 m_producer->seek(m_loopOut);
                 m_loopOut = 0;
+                stopPlaybackGovernor();
                 return false;
             }
             m_producer->seek(m_isZoneMode ? m_proxy->zoneIn() : m_loopIn);
@@ -792,21 +939,25 @@ bool GLWidget::checkFrameNumber(int pos, bool isPlaying)
     } else if (isPlaying) {
         if (pos > m_maxProducerPosition - 2 && !(speed < 0.)) {
             // Playing past last clip, pause
+            stopCachedShuttle();
             m_producer->set_speed(0);
             m_proxy->setSpeed(0);
             m_consumer->set("refresh", 0);
             m_consumer->purge();
             m_proxy->setPosition(qMax(0, m_maxProducerPosition));
             m_producer->seek(qMax(0, m_maxProducerPosition));
+            stopPlaybackGovernor();
             return false;
         } else if (pos <= 0 && speed < 0.) {
             // rewinding reached 0, pause
+            stopCachedShuttle();
             m_producer->set_speed(0);
             m_proxy->setSpeed(0);
             m_consumer->set("refresh", 0);
             m_consumer->purge();
             m_proxy->setPosition(0);
             m_producer->seek(0);
+            stopPlaybackGovernor();
             return false;
         }
     }
@@ -1011,6 +1162,7 @@ int GLWidget::setProducer(const std::shared_ptr<Mlt::Producer> &producer, bool i
         consumerPosition = m_consumer->position();
     }
     stop();
+    invalidateFrameCache();
     if (producer) {
         m_producer = producer;
     } else {
@@ -1061,6 +1213,83 @@ void GLWidget::resetDrops()
     }
 }
 
+double GLWidget::averageRenderTime() const
+{
+    return m_averageRenderTime;
+}
+
+void GLWidget::startPlaybackGovernor()
+{
+    m_renderTimeSum = 0;
+    m_renderCount = 0;
+    m_slowPeriods = 0;
+    m_governorDrops = droppedFrames();
+    m_governorTimer.start();
+}
+
+void GLWidget::stopPlaybackGovernor()
+{
+    m_governorTimer.stop();
+    m_slowPeriods = 0;
+    if (m_governorScaling > 0) {
+        // Paused, display the current frame at the configured resolution again
+        m_governorScaling = 0;
+        applyGovernorScaling();
+        m_refreshTimer.start();
+    }
+}
+
+void GLWidget::updatePlaybackGovernor()
+{
+    const int count = m_renderCount.exchange(0);
+    const qint64 sum = m_renderTimeSum.exchange(0);
+    // The drop count is reset by the monitor overlay
+    const int dropCount = droppedFrames();
+    const int drops = dropCount >= m_governorDrops ? dropCount - m_governorDrops : dropCount;
+    m_governorDrops = dropCount;
+    if (count == 0) {
+        return;
+    }
+    m_averageRenderTime = sum / count / 1000000.;
+    if (m_id != Kdenlive::ProjectMonitor || !KdenliveSettings::adaptivePreviewScaling() || !qFuzzyCompare(playSpeed(), 1.)) {
+        return;
+    }
+    // Frames are rendered in parallel when the consumer uses several threads
+    const int threads = m_consumer ? qMax(1, qAbs(m_consumer->get_int("real_time"))) : 1;
+    const double frameDuration = 1000. / pCore->getCurrentFps();
+    const bool slow = m_averageRenderTime / threads > frameDuration * 1.15 || drops > qMax(1, count / 10);
+    m_slowPeriods = slow ? m_slowPeriods + 1 : 0;
+    const int scaling = effectivePreviewScaling();
+    if (m_slowPeriods < 2 || scaling >= 16) {
+        return;
+    }
+    // Step one level down: 1:1, 720p, 540p, 360p, 270p
+    m_governorScaling = qMax(2, scaling * 2);
+    m_slowPeriods = 0;
+    qCDebug(KDENLIVE_LOG) << "Playback too slow (" << m_averageRenderTime << "ms per frame), lowering preview scaling to" << m_governorScaling;
+    applyGovernorScaling();
+}
+
+QSize GLWidget::consumerSize() const
+{
+    if (m_governorScaling > 0) {
+        return scaledFrameSize(effectivePreviewScaling());
+    }
+    return m_profileSize;
+}
+
+void GLWidget::applyGovernorScaling()
+{
+    if (!m_consumer) {
+        return;
+    }
+    // The monitor profile is shared with the other monitor and the timeline, only change what this consumer requests
+    const QSize size = consumerSize();
+    invalidateFrameCache();
+    m_consumer->set("width", size.width());
+    m_consumer->set("height", size.height());
+}
+
 void GLWidget::stopCapture()
 {
     if (strcmp(m_consumer->get("mlt_service"), "multi") == 0) {
@@ -1175,6 +1404,15 @@ int GLWidget::reconfigure()
             // A & B
             m_displayEvent = m_consumer->listen("consumer-frame-show", this, mlt_listener(on_frame_show));
         }
+        // Time the rendering of each frame, excluding the time the consumer waits to pace playback
+        mlt_filter timer = mlt_filter_new();
+        if (timer) {
+            timer->process = render_timer_process;
+            mlt_properties_set_data(MLT_FILTER_PROPERTIES(timer), "kdenlive:monitor", this, 0, nullptr, nullptr);
+            m_renderTimer = std::make_unique<Mlt::Filter>(timer);
+            mlt_filter_close(timer);
+            m_consumer->attach(*m_renderTimer.get());
+        }
 
         int volume = KdenliveSettings::volume();
         if (serviceName.startsWith(QLatin1String("sdl"))) {
@@ -1230,6 +1468,7 @@ float GLWidget::zoom() const
 
 void GLWidget::reloadProfile()
 {
+    invalidateFrameCache();
     // The profile display aspect ratio may have changed.
     bool existingConsumer = false;
     if (m_consumer) {
@@ -1284,6 +1523,9 @@ void GLWidget::setZoom(float zoom, bool force)
 
 void GLWidget::onFrameDisplayed(const SharedFrame &frame)
 {
+    if (frame.get_int("kdenlive:cached") == 0 && frameCacheEnabled()) {
+        m_frameCache->insert(m_frameCache->revision(), frame);
+    }
     m_contextSharedAccess.lock();
     m_sharedFrame = frame;
     m_sendFrame = sendFrameForAnalysis;
@@ -1364,6 +1606,7 @@ Mlt::Producer *GLWidget::producer()
 
 void GLWidget::resetConsumer(bool fullReset)
 {
+    invalidateFrameCache();
     if (fullReset && m_consumer) {
         m_consumer->purge();
         m_consumer->stop();
@@ -1390,6 +1633,27 @@ void GLWidget::on_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data
     }
 }
 
+mlt_frame GLWidget::render_timer_process(mlt_filter filter, mlt_frame frame)
+{
+    mlt_frame_push_service(frame, mlt_properties_get_data(MLT_FILTER_PROPERTIES(filter), "kdenlive:monitor", nullptr));
+    mlt_frame_push_get_image(frame, render_timer_get_image);
+    return frame;
+}
+
+int GLWidget::render_timer_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable)
+{
+    // Called from the consumer threads, the rest of the image stack renders the frame
+    auto *widget = static_cast<GLWidget *>(mlt_frame_pop_service(frame));
+    QElapsedTimer timer;
+    timer.start();
+    int error = mlt_frame_get_image(frame, image, format, width, height, writable);
+    if (error == 0) {
+        widget->m_renderTimeSum += timer.nsecsElapsed();
+        widget->m_renderCount++;
+    }
+    return error;
+}
+
 void GLWidget::on_gl_nosync_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data)
 {
     auto frame = Mlt::EventData(data).to_frame();
@@ -1606,7 +1870,14 @@ bool GLWidget::switchPlay(bool play, double speed)
     if (m_isZoneMode || m_isLoopMode) {
         resetZoneMode();
     }
+    if (play && canShuttleFromCache(speed)) {
+        startCachedShuttle(speed);
+        return true;
+    }
+    const bool wasShuttling = !qFuzzyIsNull(m_shuttleSpeed);
+    stopCachedShuttle();
     if (play) {
+        m_frameCache->stopPrefetch();
         if (m_consumer->position() == m_producer->get_playtime() - 1 && speed > 0) {
             // We are at the end of the clip / timeline
             if (m_id == Kdenlive::ClipMonitor || (m_id == Kdenlive::ProjectMonitor && KdenliveSettings::jumptostart())) {
@@ -1633,6 +1904,13 @@ bool GLWidget::switchPlay(bool play, double speed)
             m_consumer->purge();
             m_producer->seek(m_consumer->position() + (speed > 1. ? 1 : 0));
         }
+        startPlaybackGovernor();
+    } else if (wasShuttling) {
+        // The consumer is already paused, keep the last shuttle position
+        Q_EMIT paused();
+        m_proxy->setSpeed(0);
+        m_producer->seek(m_shuttlePosition);
+        m_prefetchTimer.start();
     } else {
         Q_EMIT paused();
         m_producer->set_speed(0);
@@ -1642,6 +1920,7 @@ bool GLWidget::switchPlay(bool play, double speed)
         m_consumer->purge();
         m_consumer->start();
         m_consumer->set("scrub_audio", 0);
+        stopPlaybackGovernor();
     }
     return true;
 }
@@ -1652,6 +1931,7 @@ bool GLWidget::playZone(bool loop)
         pCore->displayMessage(i18n("Select a zone to play"), ErrorMessage, 500);
         return false;
     }
+    stopCachedShuttle();
     double current_speed = m_producer->get_speed();
     m_producer->set_speed(0);
     m_proxy->setSpeed(0);
@@ -1674,6 +1954,7 @@ bool GLWidget::playZone(bool loop)
     }
     m_isZoneMode = true;
     m_isLoopMode = loop;
+    startPlaybackGovernor();
     return true;
 }
 
@@ -1699,6 +1980,7 @@ bool GLWidget::loopClip(QPoint inOut)
         pCore->displayMessage(i18n("Select a clip to play"), ErrorMessage, 500);
         return false;
     }
+    stopCachedShuttle();
     m_loopIn = inOut.x();
     double current_speed = m_producer->get_speed();
     m_producer->set_speed(0);
@@ -1720,6 +2002,7 @@ bool GLWidget::loopClip(QPoint inOut)
     }
     m_isZoneMode = false;
     m_isLoopMode = true;
+    startPlaybackGovernor();
     return true;
 }
 
@@ -1791,6 +2074,13 @@ void GLWidget::startConsumer()
 void GLWidget::stop()
 {
     m_refreshTimer.stop();
+    stopCachedShuttle();
+    m_frameCache->stopPrefetch();
+    m_governorTimer.stop();
+    if (m_governorScaling > 0) {
+        m_governorScaling = 0;
+        applyGovernorScaling();
+    }
     // why this lock?
     QMutexLocker locker(&m_mltMutex);
     if (m_producer) {
@@ -1810,6 +2100,9 @@ void GLWidget::stop()
 
 double GLWidget::playSpeed() const
 {
+    if (!qFuzzyIsNull(m_shuttleSpeed)) {
+        return m_shuttleSpeed;
+    }
     if (m_producer) {
         return m_producer->get_speed();
     }
@@ -1868,10 +2161,15 @@ void GLWidget::setConsumerProperty(const QString &name, const QString &value)
     }
 }
 
-bool GLWidget::updateScaling()
+int GLWidget::effectivePreviewScaling() const
+{
+    return qMax(KdenliveSettings::previewScaling(), m_governorScaling);
+}
+
+QSize GLWidget::scaledFrameSize(int scaling) const
 {
     int previewHeight = pCore->getCurrentFrameSize().height();
-    switch (KdenliveSettings::previewScaling()) {
+    switch (scaling) {
     case 2:
         previewHeight = qMin(previewHeight, 720);
         break;
@@ -1891,16 +2189,23 @@ bool GLWidget::updateScaling()
     if (pWidth % 2 > 0) {
         pWidth++;
     }
-    QSize profileSize(pWidth, previewHeight);
+    return QSize(pWidth, previewHeight);
+}
+
+bool GLWidget::updateScaling()
+{
+    QSize profileSize = scaledFrameSize(KdenliveSettings::previewScaling());
     if (profileSize == m_profileSize) {
         return false;
     }
     m_profileSize = profileSize;
+    invalidateFrameCache();
     pCore->getMonitorProfile().set_width(m_profileSize.width());
     pCore->getMonitorProfile().set_height(m_profileSize.height());
     if (m_consumer) {
-        m_consumer->set("width", m_profileSize.width());
-        m_consumer->set("height", m_profileSize.height());
+        const QSize size = consumerSize();
+        m_consumer->set("width", size.width());
+        m_consumer->set("height", size.height());
         resizeGL(width(), height());
     }
     return true;
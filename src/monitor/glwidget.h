@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QFont>
 #include <QMutex>
 #include <QOffscreenSurface>
@@ -25,6 +26,8 @@
 #include "kdenlivesettings.h"
 #include "scopes/sharedframe.h"
 
+#include <atomic>
+#include <memory>
 #include <mlt++/MltProfile.h>
 
 class QOpenGLFunctions_3_2_Core;
@@ -37,6 +40,7 @@ class Consumer;
 
 class RenderThread;
 class FrameRenderer;
+class MonitorFrameCache;
 class MonitorProxy;
 class MarkerSortModel;
 
@@ -96,6 +100,12 @@ public:
     void releaseMonitor();
     int droppedFrames() const;
     void resetDrops();
+    /** @brief Average time in ms spent rendering a frame during the last playback measure, 0 if unknown */
+    double averageRenderTime() const;
+    /** @brief Returns the preview scaling in use, which can be lower than the configured one while the playback governor is active */
+    int effectivePreviewScaling() const;
+    /** @brief Returns the size of the frames requested by the consumer, smaller than the profile size while the playback governor is active */
+    QSize consumerSize() const;
     bool checkFrameNumber(int pos, bool isPlaying);
     /** @brief Return current timeline position */
     int getCurrentPos() const;
@@ -126,6 +136,8 @@ public:
     void switchRuler(bool show);
     /** @brief Returns true if consumer is initialized */
     bool isReady() const;
+    /** @brief Drop the cached monitor frames, must be called whenever the producer output changes */
+    void invalidateFrameCache();
 
 protected:
     void mouseReleaseEvent(QMouseEvent *event) override;
@@ -229,8 +241,31 @@ private:
     QPoint m_offset;
     MonitorProxy *m_proxy;
     std::shared_ptr<Mlt::Producer> m_blackClip;
+    MonitorFrameCache *m_frameCache;
+    /** @brief Delays building the prefetch producer until seeking settles */
+    QTimer m_prefetchTimer;
+    /** @brief Time since the last seek, consecutive seeks mean the user is scrubbing */
+    QElapsedTimer m_lastSeek;
+    /** @brief Drives shuttle playback from the frame cache */
+    QTimer m_shuttleTimer;
+    double m_shuttleSpeed;
+    int m_shuttlePosition;
+    /** @brief Periodically checks the render measures while playing to adapt the preview scaling */
+    QTimer m_governorTimer;
+    /** @brief Consumer filter measuring the time spent rendering each frame */
+    std::unique_ptr<Mlt::Filter> m_renderTimer;
+    /** @brief Render measures, updated from the consumer threads */
+    std::atomic<qint64> m_renderTimeSum{0};
+    std::atomic<int> m_renderCount{0};
+    double m_averageRenderTime{0.};
+    /** @brief Preview scaling forced by the playback governor, 0 when the configured scaling is used */
+    int m_governorScaling{0};
+    int m_slowPeriods{0};
+    int m_governorDrops{0};
     static void on_frame_show(mlt_consumer, GLWidget* widget, mlt_event_data);
     static void on_frame_render(mlt_consumer, GLWidget *widget, mlt_frame frame);
+    static mlt_frame render_timer_process(mlt_filter filter, mlt_frame frame);
+    static int render_timer_get_image(mlt_frame frame, uint8_t **image, mlt_image_format *format, int *width, int *height, int writable);
     static void on_gl_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data);
     static void on_gl_nosync_frame_show(mlt_consumer, GLWidget *widget, mlt_event_data data);
     QOpenGLFramebufferObject *m_fbo;
@@ -238,6 +273,22 @@ private:
     void resetZoneMode();
     /** @brief Restart consumer, keeping preview scaling settings */
     bool restartConsumer();
+    /** @brief Returns true if the current pipeline can display frames from the frame cache */
+    bool frameCacheEnabled() const;
+    /** @brief Display the cached frame at @param position, returns false on a cache miss */
+    bool showCachedFrame(int position);
+    /** @brief Returns true if shuttling at @param speed should play from the frame cache instead of the consumer */
+    bool canShuttleFromCache(double speed) const;
+    void startCachedShuttle(double speed);
+    void stopCachedShuttle();
+    /** @brief Start measuring render times for the playback governor */
+    void startPlaybackGovernor();
+    /** @brief Stop the playback governor and restore the configured preview scaling */
+    void stopPlaybackGovernor();
+    /** @brief Returns the frame size matching a preview @param scaling */
+    QSize scaledFrameSize(int scaling) const;
+    /** @brief Request frames at the governor resolution from the consumer, without touching the monitor profile */
+    void applyGovernorScaling();
 
     /* OpenGL context management. Interfaces to MLT according to the configured render pipeline.
      */
@@ -248,6 +299,10 @@ private Q_SLOTS:
     void onFrameDisplayed(const SharedFrame &frame);
     int reconfigure();
     void refresh();
+    void startPrefetch();
+    void shuttleStep();
+    /** @brief Lower the preview scaling if the last render measures show that playback cannot keep up */
+    void updatePlaybackGovernor();
     void switchRecordState(bool on);
 
 protected:
@@ -1523,6 +1523,7 @@ void Monitor::forceMonitorRefresh()
 
 void Monitor::refreshMonitor(bool directUpdate)
 {
+    m_glMonitor->invalidateFrameCache();
     if (!m_glMonitor->isReady() || isPlaying()) {
         return;
     }
@@ -1555,6 +1556,7 @@ bool Monitor::monitorVisible() const
 
 void Monitor::refreshMonitorIfActive(bool directUpdate)
 {
+    m_glMonitor->invalidateFrameCache();
     if (!m_glMonitor->isReady() || !isActive()) {
         return;
     }
@@ -2166,6 +2168,16 @@ void Monitor::checkDrops()
         m_qmlManager->setProperty(QStringLiteral("dropped"), true);
         m_qmlManager->setProperty(QStringLiteral("fps"), QString::number(dropped, 'f', 2));
     }
+    QString renderInfo;
+    const double renderTime = m_glMonitor->averageRenderTime();
+    if (renderTime > 0.) {
+        renderInfo = i18n("%1ms", QString::number(renderTime, 'f', 1));
+        if (m_glMonitor->effectivePreviewScaling() > qMax(1, KdenliveSettings::previewScaling())) {
+            // The playback governor lowered the preview resolution
+            renderInfo.append(QStringLiteral(", %1p").arg(m_glMonitor->consumerSize().height()));
+        }
+    }
+    m_qmlManager->setProperty(QStringLiteral("renderInfo"), renderInfo);
 }
 
 void Monitor::reloadProducer(const QString &id)
@@ -2736,6 +2748,11 @@ void Monitor::purgeCache()
     m_glMonitor->purgeCache();
 }
 
+void Monitor::invalidateFrameCache()
+{
+    m_glMonitor->invalidateFrameCache();
+}
+
 void Monitor::updateBgColor()
 {
     m_glMonitor->m_bgColor = KdenliveSettings::window_background();
@@ -355,6 +355,8 @@ public Q_SLOTS:
     void forceMonitorRefresh();
     /** @brief Clear read ahead cache, to ensure up to date audio */
     void purgeCache();
+    /** @brief Drop the frames cached for scrubbing, when the monitor producer output changed */
+    void invalidateFrameCache();
 
 Q_SIGNALS:
     void screenChanged(int screenIndex);
@@ -0,0 +1,273 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "monitorframecache.h"
+#include "core.h"
+#include "kdenlivesettings.h"
+
+#include <QDebug>
+#include <memory>
+#include <mlt++/Mlt.h>
+
+MonitorFrameCache::MonitorFrameCache(QObject *parent)
+    : QThread(parent)
+{
+    setObjectName(QStringLiteral("MonitorFrameCache"));
+}
+
+MonitorFrameCache::~MonitorFrameCache()
+{
+    m_mutex.lock();
+    m_abort = true;
+    m_wait.wakeAll();
+    m_mutex.unlock();
+    wait();
+}
+
+void MonitorFrameCache::setBudget(int megabytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_budget = qint64(qMax(0, megabytes)) * 1024 * 1024;
+    evict();
+}
+
+bool MonitorFrameCache::isEnabled() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_budget > 0;
+}
+
+void MonitorFrameCache::invalidate()
+{
+    QMutexLocker lock(&m_mutex);
+    m_revision++;
+    m_frames.clear();
+    m_size = 0;
+    m_sourceXml.clear();
+    m_sourceRevision = -1;
+    m_wait.wakeAll();
+}
+
+int MonitorFrameCache::revision() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_revision;
+}
+
+void MonitorFrameCache::insert(int revision, const SharedFrame &frame)
+{
+    if (!frame.is_valid()) {
+        return;
+    }
+    const qint64 size = mlt_image_format_size(frame.get_image_format(), frame.get_image_width(), frame.get_image_height(), nullptr);
+    QMutexLocker lock(&m_mutex);
+    if (revision != m_revision || m_budget <= 0 || size <= 0) {
+        return;
+    }
+    const int position = frame.get_position();
+    auto existing = m_frames.find(position);
+    if (existing != m_frames.end()) {
+        m_size -= existing->second.size;
+        m_frames.erase(existing);
+    }
+    m_frames.emplace(position, CachedFrame{frame, size});
+    m_size += size;
+    evict();
+}
+
+bool MonitorFrameCache::lookup(int position, SharedFrame &frame) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto cached = m_frames.find(position);
+    if (cached == m_frames.end()) {
+        return false;
+    }
+    frame = cached->second.frame;
+    return true;
+}
+
+bool MonitorFrameCache::hasSource() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_sourceRevision == m_revision;
+}
+
+void MonitorFrameCache::setSource(const QByteArray &xml, QSize size, int duration, double fps)
+{
+    QMutexLocker lock(&m_mutex);
+    m_sourceXml = xml;
+    m_sourceRevision = m_revision;
+    m_frameSize = size;
+    m_duration = duration;
+    m_fps = fps;
+    m_rescale = KdenliveSettings::mltinterpolation().toUtf8();
+    m_deinterlacer = KdenliveSettings::mltdeinterlacer().toUtf8();
+    m_wait.wakeAll();
+}
+
+int MonitorFrameCache::shuttleStep(double speed)
+{
+    return qMax(1, int(qAbs(speed)));
+}
+
+void MonitorFrameCache::prefetch(int position, double speed)
+{
+    QMutexLocker lock(&m_mutex);
+    m_playhead = position;
+    m_speed = speed;
+    m_prefetching = true;
+    if (!isRunning()) {
+        start(QThread::LowPriority);
+    }
+    m_wait.wakeAll();
+}
+
+void MonitorFrameCache::stopPrefetch()
+{
+    QMutexLocker lock(&m_mutex);
+    m_prefetching = false;
+}
+
+int MonitorFrameCache::nextPrefetchPosition() const
+{
+    if (!m_prefetching || m_budget <= 0 || m_sourceRevision != m_revision || m_frameSize.isEmpty()) {
+        return -1;
+    }
+    // Never prefetch more frames than the budget can hold, otherwise we would evict our own work
+    const qint64 frameBytes = qint64(m_frameSize.width()) * m_frameSize.height() * 2;
+    const int capacity = int(qMin(m_budget / frameBytes - 1, qint64(m_fps * 10)));
+    if (capacity < 2) {
+        return -1;
+    }
+    if (qFuzzyIsNull(m_speed)) {
+        // Paused, fill a scrubbing window around the playhead, nearest frames first
+        for (int offset = 1; offset <= capacity / 2; ++offset) {
+            for (int pos : {m_playhead + offset, m_playhead - offset}) {
+                if (pos >= 0 && pos <= m_duration && m_frames.count(pos) == 0) {
+                    return pos;
+                }
+            }
+        }
+        return -1;
+    }
+    // Shuttling, only render the frames the playhead will show
+    const int step = (m_speed < 0 ? -1 : 1) * shuttleStep(m_speed);
+    for (int ix = 1; ix <= capacity * 3 / 4; ++ix) {
+        int pos = m_playhead + ix * step;
+        if (pos < 0 || pos > m_duration) {
+            break;
+        }
+        if (m_frames.count(pos) == 0) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+QByteArray MonitorFrameCache::serialize(Mlt::Producer &source)
+{
+    Mlt::Consumer c(pCore->getProjectProfile(), "xml", "string");
+    c.set("time_format", "frames");
+    c.set("no_meta", 1);
+    c.set("no_root", 1);
+    c.set("no_profile", 1);
+    c.set("root", "/");
+    c.set("store", "kdenlive");
+    Mlt::Service s(source.get_service());
+    c.connect(s);
+    c.run();
+    return QByteArray(c.get("string"));
+}
+
+void MonitorFrameCache::evict()
+{
+    while (m_size > m_budget && !m_frames.empty()) {
+        auto first = m_frames.begin();
+        auto last = std::prev(m_frames.end());
+        qint64 firstDistance = m_playhead - first->first;
+        qint64 lastDistance = last->first - m_playhead;
+        // Frames behind the shuttle direction are the least likely to be shown again
+        if (m_speed > 0) {
+            firstDistance *= 2;
+        } else if (m_speed < 0) {
+            lastDistance *= 2;
+        }
+        auto dropped = firstDistance >= lastDistance ? first : last;
+        m_size -= dropped->second.size;
+        m_frames.erase(dropped);
+    }
+}
+
+void MonitorFrameCache::run()
+{
+    std::unique_ptr<Mlt::Producer> producer;
+    int producerRevision = -1;
+    QMutexLocker lock(&m_mutex);
+    while (!m_abort) {
+        if (producer && producerRevision != m_sourceRevision) {
+            // Producer is outdated, release it and its decoders
+            lock.unlock();
+            producer.reset();
+            lock.relock();
+            continue;
+        }
+        const int position = nextPrefetchPosition();
+        if (position < 0) {
+            m_wait.wait(&m_mutex);
+            continue;
+        }
+        const int revision = m_revision;
+        if (!producer) {
+            const QByteArray xml = m_sourceXml;
+            lock.unlock();
+            std::unique_ptr<Mlt::Producer> built;
+            if (!xml.isEmpty()) {
+                built = std::make_unique<Mlt::Producer>(pCore->getProjectProfile(), "xml-string", xml.constData());
+            }
+            lock.relock();
+            if (revision != m_revision) {
+                // The monitor producer changed while we were building it
+                lock.unlock();
+                built.reset();
+                lock.relock();
+                continue;
+            }
+            producer = std::move(built);
+            producerRevision = revision;
+            if (!producer || !producer->is_valid()) {
+                qWarning() << "Cannot build monitor prefetch producer, disabling prefetch";
+                producer.reset();
+                m_prefetching = false;
+            }
+            continue;
+        }
+        const QSize size = m_frameSize;
+        const QByteArray rescale = m_rescale;
+        const QByteArray deinterlacer = m_deinterlacer;
+        lock.unlock();
+        bool rendered = false;
+        producer->seek(position);
+        std::unique_ptr<Mlt::Frame> frame(producer->get_frame());
+        if (frame && frame->is_valid()) {
+            frame->set("consumer.rescale", rescale.constData());
+            frame->set("consumer.deinterlacer", deinterlacer.constData());
+            mlt_image_format format = mlt_image_yuv422;
+            int width = size.width();
+            int height = size.height();
+            if (frame->get_image(format, width, height) != nullptr) {
+                frame->set("rendered", 1);
+                insert(revision, SharedFrame(*frame));
+                rendered = true;
+            }
+        }
+        lock.relock();
+        if (!rendered) {
+            // Don't retry the same position forever
+            m_prefetching = false;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include "scopes/sharedframe.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QSize>
+#include <QThread>
+#include <QWaitCondition>
+#include <map>
+#include <memory>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @class MonitorFrameCache
+    @brief Bounded RAM cache of rendered monitor frames, keyed by (producer revision, position).
+
+    Frames displayed by the monitor are stored here, and a prefetch thread renders the frames
+    around the playhead from its own copy of the monitor producer, following the shuttle direction
+    and speed. The copy is built from an xml serialized by the caller in the GUI thread, so the prefetch
+    thread never touches the live producers. Any change to the monitor producer must call invalidate(),
+    which bumps the revision and drops all cached frames.
+ */
+class MonitorFrameCache : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit MonitorFrameCache(QObject *parent = nullptr);
+    ~MonitorFrameCache() override;
+
+    /** @brief Set the maximum memory used by cached frames, 0 disables the cache */
+    void setBudget(int megabytes);
+    bool isEnabled() const;
+    /** @brief Drop all cached frames and the prefetch producer, bumping the revision */
+    void invalidate();
+    /** @brief Returns the current producer revision */
+    int revision() const;
+    /** @brief Store a displayed frame, ignored if the cache was invalidated since @param revision */
+    void insert(int revision, const SharedFrame &frame);
+    /** @brief Fetch the frame at @param position for the current revision, returns false on a cache miss */
+    bool lookup(int position, SharedFrame &frame) const;
+    /** @brief Returns true if the prefetch producer matches the current revision */
+    bool hasSource() const;
+    /** @brief Set the xml of the monitor producer, the prefetch thread builds its own producer from it
+     *  @param size the size of the frames rendered by the monitor consumer
+     *  @param duration the last position that can be prefetched */
+    void setSource(const QByteArray &xml, QSize size, int duration, double fps);
+    /** @brief Start prefetching frames around @param position, in the direction of @param speed */
+    void prefetch(int position, double speed);
+    /** @brief Number of frames the playhead moves on each step when shuttling at @param speed */
+    static int shuttleStep(double speed);
+    /** @brief Stop rendering frames in the prefetch thread, cached frames are kept */
+    void stopPrefetch();
+    /** @brief Returns the xml of @param source, rendered without the profile so it can be rebuilt in the prefetch thread */
+    static QByteArray serialize(Mlt::Producer &source);
+
+protected:
+    void run() override;
+
+private:
+    struct CachedFrame
+    {
+        SharedFrame frame;
+        qint64 size;
+    };
+    mutable QMutex m_mutex;
+    QWaitCondition m_wait;
+    std::map<int, CachedFrame> m_frames;
+    qint64 m_size{0};
+    qint64 m_budget{0};
+    int m_revision{0};
+    int m_playhead{0};
+    double m_speed{0.};
+    bool m_prefetching{false};
+    bool m_abort{false};
+    QByteArray m_sourceXml;
+    int m_sourceRevision{-1};
+    QSize m_frameSize;
+    int m_duration{0};
+    double m_fps{25.};
+    QByteArray m_rescale;
+    QByteArray m_deinterlacer;
+    /** @brief Returns the next uncached position the prefetch thread should render, -1 if none */
+    int nextPrefetchPosition() const;
+    /** @brief Drop the frames farthest from the playhead until the cache fits in its budget */
+    void evict();
+};
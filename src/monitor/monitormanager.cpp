@@ -110,6 +110,8 @@ void MonitorManager::focusProjectMonitor()
 
 void MonitorManager::refreshProjectRange(QPair<int, int> range, bool forceRefresh)
 {
+    // Cached frames outside of the refreshed range are outdated too, as they share the producer revision
+    m_projectMonitor->invalidateFrameCache();
     if (m_projectMonitor->position() >= range.first && m_projectMonitor->position() <= range.second) {
         if (forceRefresh) {
             m_projectMonitor->refreshMonitor(false);
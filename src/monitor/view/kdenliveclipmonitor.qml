@@ -37,6 +37,7 @@ Item {
     property double offsety : 0
     property bool dropped: false
     property string fps: '-'
+    property string renderInfo: ''
     property bool showMarkers: false
     property bool showTimecode: false
     property bool showFps: false
@@ -456,7 +457,7 @@ Item {
                 background: Rectangle {
                     color: root.dropped ? "#99ff0000" : "#66004400"
                 }
-                text: i18n("%1fps", root.fps)
+                text: root.renderInfo.length > 0 ? i18n("%1fps (%2)", root.fps, root.renderInfo) : i18n("%1fps", root.fps)
                 visible: root.showFps
                 anchors {
                     right: timecode.visible ? timecode.left : parent.right
@@ -25,6 +25,7 @@ Item {
     property bool captureRightClick: false
     property bool dropped: false
     property string fps: '-'
+    property string renderInfo: ''
     property bool showMarkers: false
     property bool showTimecode: false
     property bool showFps: false
@@ -192,7 +193,7 @@ Item {
                 background: Rectangle {
                     color: root.dropped ? "#99ff0000" : "#66004400"
                 }
-                text: i18n("%1fps", root.fps)
+                text: root.renderInfo.length > 0 ? i18n("%1fps (%2)", root.fps, root.renderInfo) : i18n("%1fps", root.fps)
                 visible: root.showFps
                 anchors {
                     right: timecode.visible ? timecode.left : parent.right
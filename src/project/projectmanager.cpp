@@ -20,6 +20,7 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
 #include "timeline2/model/timelinefunctions.hpp"
+#include "utils/decoderpool.h"
 #include "utils/qstringutils.h"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
@@ -148,6 +149,8 @@ void ProjectManager::init(const QUrl &projectUrl, const QString &clipList)
 
     m_autoSaveTimer.setSingleShot(true);
     connect(&m_autoSaveTimer, &QTimer::timeout, this, &ProjectManager::slotAutoSave);
+    m_unloadTimer.setInterval(60000);
+    connect(&m_unloadTimer, &QTimer::timeout, this, &ProjectManager::slotUnloadIdleSequences);
 }
 
 void ProjectManager::newFile(bool showProjectSettings)
@@ -277,8 +280,18 @@ void ProjectManager::newFile(QString profileName, bool showProjectSettings)
 
 void ProjectManager::setActiveTimeline(const QUuid &uuid)
 {
+    const QPair<int, int> undoState(m_project->commandStack()->index(), m_project->commandStack()->count());
+    if (m_activeTimelineModel && m_activeTimelineModel->uuid() != uuid) {
+        const QUuid previous = m_activeTimelineModel->uuid();
+        m_sequenceLastActive.insert(previous, QDateTime::currentMSecsSinceEpoch());
+        if (undoState != m_activeUndoState) {
+            // Something was done while the sequence was active, the undo history may refer to its timeline
+            m_changedSequences.insert(previous);
+        }
+    }
     m_activeTimelineModel = m_project->getTimeline(uuid);
     m_project->activeUuid = uuid;
+    m_activeUndoState = undoState;
 }
 
 void ProjectManager::activateDocument(const QUuid &uuid)
@@ -326,6 +339,7 @@ void ProjectManager::testSetActiveDocument(KdenliveDoc *doc, std::shared_ptr<Tim
         }
     }
     m_project->addTimeline(doc->uuid(), timeline);
+    watchSequence(doc->uuid(), timeline);
     m_activeTimelineModel = timeline;
     m_project->activeUuid = doc->uuid();
     m_project->loadSequenceGroupsAndGuides(doc->uuid());
@@ -365,6 +379,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
 {
     // Disable autosave
     m_autoSaveTimer.stop();
+    m_unloadTimer.stop();
     if ((m_project != nullptr) && m_project->isModified() && saveChanges) {
         QString message;
         if (m_project->url().fileName().isEmpty()) {
@@ -410,6 +425,11 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
                 pCore->window()->resetSubtitles(uid);
                 m_project->closeTimeline(uid);
             }
+            // Tabs of sequences that were not built
+            const QStringList pending = pCore->window()->openedSequences();
+            for (const QString &uid : pending) {
+                pCore->window()->closeTimelineTab(QUuid(uid));
+            }
         } else {
             // Close all timelines
             const QList<QUuid> uuids = m_project->getTimelinesUuids();
@@ -422,6 +442,10 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
     // qDebug() << "TIMELINEMODEL COUNTS: " << m_activeTimelineModel.use_count();
     // Q_ASSERT(m_activeTimelineModel.use_count() <= 1);
     m_activeTimelineModel.reset();
+    m_sequenceLastActive.clear();
+    m_changedSequences.clear();
+    m_sequenceUndoBase.clear();
+    m_activeUndoState = {-1, -1};
     // Release model shared pointers
     if (guiConstructed) {
         pCore->bin()->cleanDocument();
@@ -431,7 +455,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
         pCore->projectItemModel()->clean();
         m_project = nullptr;
     }
-    mlt_service_cache_set_size(nullptr, "producer_avformat", 0);
+    DecoderPool::clear();
     ::mlt_pool_purge();
     return true;
 }
@@ -823,25 +847,28 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
         return;
     }
 
-    // Re-open active timelines
-    QStringList openedTimelines = m_project->getDocumentProperty(QStringLiteral("opensequences")).split(QLatin1Char(';'), Qt::SkipEmptyParts);
-    for (auto &uid : openedTimelines) {
-        const QUuid uuid(uid);
-        const QString binId = pCore->projectItemModel()->getSequenceId(uuid);
-        if (!binId.isEmpty()) {
-            openTimeline(binId, uuid);
+    QUuid activeUuid(m_project->getDocumentProperty(QStringLiteral("activetimeline")));
+    if (activeUuid.isNull()) {
+        activeUuid = m_project->uuid();
+    }
+    // Only the active timeline is built now. The other sequences that had a tab get it back in the saved order, but stay
+    // MLT playlists until their tab is activated
+    if (pCore->window()) {
+        const QStringList openedTimelines = m_project->getDocumentProperty(QStringLiteral("opensequences")).split(QLatin1Char(';'), Qt::SkipEmptyParts);
+        for (auto &uid : openedTimelines) {
+            const QUuid uuid(uid);
+            std::shared_ptr<ProjectClip> sequence = pCore->projectItemModel()->getClipByBinID(pCore->projectItemModel()->getSequenceId(uuid));
+            if (sequence) {
+                pCore->window()->addPendingTimeline(uuid, sequence->clipName());
+            }
         }
     }
-    // Now that sequence clips are fully built, fetch thumbnails
+    // Fetch sequence thumbnails
     const QStringList sequenceIds = pCore->projectItemModel()->getAllSequenceClips().values();
     for (auto &id : sequenceIds) {
         ClipLoadTask::start(ObjectId(ObjectType::BinClip, id.toInt(), QUuid()), QDomElement(), true, -1, -1, this);
     }
     // Raise last active timeline
-    QUuid activeUuid(m_project->getDocumentProperty(QStringLiteral("activetimeline")));
-    if (activeUuid.isNull()) {
-        activeUuid = m_project->uuid();
-    }
     if (!activeUuid.isNull()) {
         const QString binId = pCore->projectItemModel()->getSequenceId(activeUuid);
         if (binId.isEmpty()) {
@@ -878,6 +905,7 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale, bool isBa
     }
     delete m_progressDialog;
     m_progressDialog = nullptr;
+    m_unloadTimer.start();
 }
 
 void ProjectManager::slotRevert()
@@ -1041,7 +1069,8 @@ void ProjectManager::prepareSave()
     pCore->projectItemModel()->saveDocumentProperties(pCore->window()->getCurrentTimeline()->controller()->documentProperties(), m_project->metadata());
     pCore->bin()->saveFolderState();
     pCore->projectItemModel()->saveProperty(QStringLiteral("kdenlive:documentnotes"), documentNotes());
-    pCore->projectItemModel()->saveProperty(QStringLiteral("kdenlive:docproperties.opensequences"), pCore->window()->openedSequences().join(QLatin1Char(';')));
+    const QStringList openedSequences = pCore->window()->openedSequences();
+    pCore->projectItemModel()->saveProperty(QStringLiteral("kdenlive:docproperties.opensequences"), openedSequences.join(QLatin1Char(';')));
     pCore->projectItemModel()->saveProperty(QStringLiteral("kdenlive:docproperties.activetimeline"), m_activeTimelineModel->uuid().toString());
 }
 
@@ -1262,6 +1291,7 @@ bool ProjectManager::updateTimeline(bool createNewTab, const QString &chunks, co
         qDebug() << ":::: NOT FOUND DOCUMENT GUIDES !!!!!!!!!!!\n!!!!!!!!!!!!!!!!!!!!!";
     }
     m_project->addTimeline(uuid, timelineModel);
+    watchSequence(uuid, timelineModel);
     TimelineWidget *documentTimeline = nullptr;
 
     m_project->cleanupTimelinePreview(documentDate);
@@ -1339,6 +1369,7 @@ bool ProjectManager::updateTimeline(bool createNewTab, const QString &chunks, co
     if (pCore->window()) {
         pCore->bin()->registerSequence(uuid, mainId);
         QObject::connect(timelineModel.get(), &TimelineModel::durationUpdated, this, &ProjectManager::updateSequenceDuration);
+        QObject::connect(timelineModel.get(), &TimelineModel::invalidateZone, this, [this, uuid]() { invalidateSequenceRender(uuid); });
     }
 
     m_project->loadSequenceGroupsAndGuides(uuid);
@@ -1367,6 +1398,15 @@ void ProjectManager::updateSequenceDuration(const QUuid &uuid)
     }
 }
 
+void ProjectManager::invalidateSequenceRender(const QUuid &uuid)
+{
+    const QString binId = pCore->projectItemModel()->getSequenceId(uuid);
+    std::shared_ptr<ProjectClip> mainClip = pCore->projectItemModel()->getClipByBinID(binId);
+    if (mainClip) {
+        mainClip->invalidateSequenceRender();
+    }
+}
+
 void ProjectManager::adjustProjectDuration(int duration)
 {
     pCore->monitorManager()->projectMonitor()->adjustRulerSize(duration - 1, nullptr);
@@ -1648,6 +1688,9 @@ bool ProjectManager::openTimeline(const QString &id, const QUuid &uuid, int posi
     }
     std::shared_ptr<TimelineItemModel> timelineModel = existingModel != nullptr ? existingModel : TimelineItemModel::construct(uuid, m_project->commandStack());
     m_project->addTimeline(uuid, timelineModel);
+    if (existingModel == nullptr) {
+        watchSequence(uuid, timelineModel);
+    }
     TimelineWidget *timeline = nullptr;
     if (internalLoad) {
         qDebug() << "QQQQQQQQQQQQQQQQQQQQ\nINTERNAL SEQUENCE LOAD\n\nQQQQQQQQQQQQQQQQQQQQQQ";
@@ -1685,6 +1728,7 @@ bool ProjectManager::openTimeline(const QString &id, const QUuid &uuid, int posi
         prod->parent().set("kdenlive:uuid", uuid.toString().toUtf8().constData());
         prod->parent().set("kdenlive:producer_type", ClipType::Timeline);
         QObject::connect(timelineModel.get(), &TimelineModel::durationUpdated, this, &ProjectManager::updateSequenceDuration);
+        QObject::connect(timelineModel.get(), &TimelineModel::invalidateZone, this, [this, uuid]() { invalidateSequenceRender(uuid); });
         m_project->loadSequenceGroupsAndGuides(uuid);
         clip->setProducer(prod, false, false);
         if (!duplicate) {
@@ -1790,6 +1834,65 @@ bool ProjectManager::openTimeline(const QString &id, const QUuid &uuid, int posi
     return true;
 }
 
+void ProjectManager::openPendingSequence(const QUuid &uuid)
+{
+    if (m_project == nullptr || m_project->closing || m_project->getTimelinesUuids().contains(uuid)) {
+        return;
+    }
+    const QString binId = pCore->projectItemModel()->getSequenceId(uuid);
+    if (!binId.isEmpty()) {
+        // Replaces the tab and activates it
+        openTimeline(binId, uuid);
+    }
+}
+
+void ProjectManager::slotUnloadIdleSequences()
+{
+    if (m_project == nullptr || m_project->closing || m_project->loading || pCore->window() == nullptr || !m_activeTimelineModel) {
+        return;
+    }
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QList<QUuid> uuids = m_project->getTimelinesUuids();
+    for (const QUuid &uuid : uuids) {
+        if (uuid == m_activeTimelineModel->uuid() || m_changedSequences.contains(uuid) || now - m_sequenceLastActive.value(uuid, now) < 600000) {
+            continue;
+        }
+        if (m_project->commandStack()->count() > m_sequenceUndoBase.value(uuid, 0)) {
+            // Undo commands may refer to its timeline, the undo stack would crash on them once it is closed
+            continue;
+        }
+        std::shared_ptr<TimelineItemModel> model = m_project->getTimeline(uuid);
+        if (!model || model->hasTimelinePreview()) {
+            continue;
+        }
+        // Same as closing its tab, but the tab stays and unloading is not a change of the project
+        const bool modified = m_project->isModified();
+        model.reset();
+        closeTimeline(uuid, false, false);
+        pCore->window()->unloadTimeline(uuid);
+        m_project->setModified(modified);
+        m_sequenceLastActive.remove(uuid);
+    }
+}
+
+void ProjectManager::slotUndoIndexChanged(int index)
+{
+    for (auto it = m_sequenceUndoBase.begin(); it != m_sequenceUndoBase.end(); ++it) {
+        if (it.value() > index) {
+            // The next command replaces the undone ones, and can refer to this sequence
+            it.value() = index;
+        }
+    }
+}
+
+void ProjectManager::watchSequence(const QUuid &uuid, const std::shared_ptr<TimelineItemModel> &model)
+{
+    // Changes coming from other sequences or the bin also prevent unloading it
+    connect(model.get(), &TimelineModel::contentChanged, this, [this, uuid]() { m_changedSequences.insert(uuid); });
+    connect(m_project->commandStack().get(), &QUndoStack::indexChanged, this, &ProjectManager::slotUndoIndexChanged, Qt::UniqueConnection);
+    m_sequenceUndoBase.insert(uuid, m_project->commandStack()->count());
+}
+
 void ProjectManager::setTimelinePropery(QUuid uuid, const QString &prop, const QString &val)
 {
     std::shared_ptr<TimelineItemModel> model = m_project->getTimeline(uuid);
@@ -1832,6 +1935,10 @@ bool ProjectManager::closeTimeline(const QUuid &uuid, bool onDeletion, bool clea
 {
     std::shared_ptr<TimelineItemModel> model = m_project->getTimeline(uuid);
     if (model == nullptr) {
+        if (onDeletion && pCore->window()) {
+            // The sequence may have a tab waiting to build it
+            pCore->window()->closeTimelineTab(uuid);
+        }
         qDebug() << "=== ERROR CANNOT FIND TIMELINE TO CLOSE: " << uuid << "\n\nHHHHHHHHHHHH";
         return false;
     }
@@ -13,6 +13,8 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include <QTimer>
 #include <QUrl>
 #include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
 
 #include "timeline2/model/timelineitemmodel.hpp"
 
@@ -204,6 +206,8 @@ public Q_SLOTS:
     virtual void slotAddTextNote(const QString &text);
     /** @brief Open a timeline with a referenc to a track / position. */
     void seekTimeline(const QString &frameAndTrack);
+    /** @brief Build a sequence whose tab was restored or unloaded, and activate it. */
+    void openPendingSequence(const QUuid &uuid);
     /** @brief Create a sequence clip from timeline selection. */
     void slotCreateSequenceFromSelection();
 
@@ -211,6 +215,8 @@ private Q_SLOTS:
     void slotRevert();
     /** @brief A timeline sequence duration changed, update our properties. */
     void updateSequenceDuration(const QUuid &uuid);
+    /** @brief The content of a timeline sequence changed, stop using its rendered intermediate in other timelines. */
+    void invalidateSequenceRender(const QUuid &uuid);
     /** @brief Open the project's backupdialog. */
     bool slotOpenBackup(const QUrl &url = QUrl());
     /** @brief Start autosaving the document. */
@@ -218,6 +224,10 @@ private Q_SLOTS:
     /** @brief Report progress of folder move operation. */
     void slotMoveProgress(KJob *, unsigned long progress);
     void slotMoveFinished(KJob *job);
+    /** @brief Release the timelines of sequences that were not used nor changed for a while, their tabs build them again when activated. */
+    void slotUnloadIdleSequences();
+    /** @brief The undo stack index moved, commands above it may be replaced by commands on the loaded sequences. */
+    void slotUndoIndexChanged(int index);
 
 Q_SIGNALS:
     void docOpened(KdenliveDoc *document);
@@ -231,6 +241,8 @@ private:
     bool checkForBackupFile(const QUrl &url, bool newFile = false);
     /** @brief Update the sequence producer stored in the project model. */
     void updateSequenceProducer(const QUuid &uuid, std::shared_ptr<Mlt::Producer> prod);
+    /** @brief Track the changes and undo history of a sequence whose timeline was just built, every timeline creation goes through here. */
+    void watchSequence(const QUuid &uuid, const std::shared_ptr<TimelineItemModel> &model);
 
     KdenliveDoc *m_project{nullptr};
     std::shared_ptr<TimelineItemModel> m_activeTimelineModel;
@@ -239,6 +251,16 @@ private:
     QUrl m_startUrl;
     QString m_loadClipsOnOpen;
     QMap<QString, QString> m_replacementPattern;
+    /** @brief Checks for idle sequences to unload */
+    QTimer m_unloadTimer;
+    /** @brief When each open sequence was last deactivated, in ms since epoch */
+    QHash<QUuid, qint64> m_sequenceLastActive;
+    /** @brief Sequences edited since they were built, they are never unloaded */
+    QSet<QUuid> m_changedSequences;
+    /** @brief The undo stack index and count when the active sequence was activated */
+    QPair<int, int> m_activeUndoState{-1, -1};
+    /** @brief The undo stack count when each sequence was built, only the commands above it can refer to its timeline */
+    QHash<QUuid, int> m_sequenceUndoBase;
 
     QAction *m_fileRevert;
     KRecentFilesAction *m_recentFilesAction;
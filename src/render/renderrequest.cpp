@@ -6,17 +6,22 @@
 #include "renderrequest.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
+#include "mainwindow.h"
 #include "project/projectmanager.h"
+#include "timeline2/model/timelineitemmodel.hpp"
+#include "timeline2/view/previewmanager.h"
+#include "timeline2/view/timelinewidget.h"
+#include "utils/KMessageBox_KdenliveCompat.h"
 #include "utils/qstringutils.h"
 #include "xml/xml.hpp"
 
-#include "utils/KMessageBox_KdenliveCompat.h"
-
-#include <QTemporaryFile>
-
-// TODO: remove, see generatePlaylistFile()
+// TODO: remove KMessageBox and QInputDialog, see generatePlaylistFile()
 #include <KMessageBox>
 #include <QInputDialog>
+#include <QTemporaryFile>
+
+#include <algorithm>
 
 RenderRequest::RenderRequest()
 {
@@ -80,6 +85,16 @@ void RenderRequest::setOverlayData(const QString &data)
     m_overlayData = data;
 }
 
+void RenderRequest::setSmartRender(bool enabled)
+{
+    m_smartRender = enabled;
+}
+
+void RenderRequest::setSegmentCount(int count)
+{
+    m_segmentCount = qMax(1, count);
+}
+
 std::vector<RenderRequest::RenderJob> RenderRequest::process()
 {
     m_errors.clear();
@@ -226,6 +241,23 @@ void RenderRequest::createRenderJobs(std::vector<RenderJob> &jobs, const QDomDoc
         // Set two pass parameters. In case pass is 0 the function does nothing.
         setDocTwoPassParams(pass, final, job.outputPath);
 
+        if (pass == 0 && m_segmentCount > 1 && !m_presetParams.isImageSequence() && m_presetParams.value(QStringLiteral("vn")) != QLatin1String("1")) {
+            // kdenlive_render will render the video segments in parallel
+            const QList<int> splitPoints =
+                getSegmentSplitPoints(consumer.attribute(QStringLiteral("in")).toInt(), consumer.attribute(QStringLiteral("out")).toInt());
+            if (!splitPoints.isEmpty()) {
+                QStringList points;
+                for (int point : splitPoints) {
+                    points << QString::number(point);
+                }
+                consumer.setAttribute(QStringLiteral("kdenlive:segments"), points.join(QLatin1Char(',')));
+            }
+        }
+        if (pass == 0 && m_smartRender && !m_delayedRendering && !m_presetParams.isImageSequence() &&
+            m_presetParams.value(QStringLiteral("vn")) != QLatin1String("1")) {
+            setPreviewChunks(consumer);
+        }
+
         if (!Xml::docContentToFile(final, job.playlistPath)) {
             addErrorMessage(i18n("Cannot write to file %1", job.playlistPath));
             return;
@@ -347,6 +379,126 @@ void RenderRequest::setDocTwoPassParams(int pass, QDomDocument &doc, const QStri
     }
 }
 
+QList<int> RenderRequest::getSegmentSplitPoints(int in, int out)
+{
+    std::vector<int> candidates;
+    if (auto ptr = m_guidesModel.lock()) {
+        double fps = pCore->getCurrentFps();
+        for (const auto &marker : ptr->getAllMarkers()) {
+            candidates.push_back(marker.time().frames(fps));
+        }
+    }
+    if (pCore->window() && pCore->window()->getCurrentTimeline() && pCore->window()->getCurrentTimeline()->model()) {
+        std::vector<int> cuts = pCore->window()->getCurrentTimeline()->model()->getCutPositions();
+        candidates.insert(candidates.end(), cuts.begin(), cuts.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    // Don't start a process for less than 10 seconds of video
+    int minLength = qRound(pCore->getCurrentFps() * 10);
+    return segmentSplitPoints(in, out, m_segmentCount, minLength, candidates);
+}
+
+void RenderRequest::setPreviewChunks(QDomElement &consumer)
+{
+    KdenliveDoc *project = pCore->currentDoc();
+    if (!pCore->window() || !pCore->window()->getCurrentTimeline() || !pCore->window()->getCurrentTimeline()->model()) {
+        return;
+    }
+    // Chunks don't contain the overlay and have subtitles burnt in
+    if (!m_overlayData.isEmpty() || (m_embedSubtitles && project->hasSubtitles()) || m_presetParams.hasAlpha()) {
+        return;
+    }
+    // Chunks must have been rendered from the same clips
+    if (project->useProxy() && KdenliveSettings::proxypreview() != m_proxyRendering) {
+        return;
+    }
+    std::shared_ptr<PreviewManager> preview = pCore->window()->getCurrentTimeline()->model()->previewManager();
+    if (!preview || !previewParamsMatch(preview->consumerParams(), m_presetParams)) {
+        return;
+    }
+    const QMap<int, QString> chunks =
+        preview->renderedChunkFiles(consumer.attribute(QStringLiteral("in")).toInt(), consumer.attribute(QStringLiteral("out")).toInt());
+    if (chunks.isEmpty()) {
+        return;
+    }
+    QStringList positions;
+    for (int position : chunks.keys()) {
+        positions << QString::number(position);
+    }
+    consumer.setAttribute(QStringLiteral("kdenlive:chunks"), positions.join(QLatin1Char(',')));
+    consumer.setAttribute(QStringLiteral("kdenlive:chunksize"), KdenliveSettings::timelinechunks());
+    consumer.setAttribute(QStringLiteral("kdenlive:chunkfolder"), QFileInfo(chunks.first()).absolutePath());
+    consumer.setAttribute(QStringLiteral("kdenlive:chunkextension"), QFileInfo(chunks.first()).suffix());
+}
+
+bool RenderRequest::previewParamsMatch(const QStringList &previewParams, const RenderPresetParams &presetParams)
+{
+    static const QStringList ignored = {QStringLiteral("f"),      QStringLiteral("an"), QStringLiteral("acodec"),    QStringLiteral("ab"),
+                                        QStringLiteral("ar"),     QStringLiteral("ac"), QStringLiteral("aq"),        QStringLiteral("channels"),
+                                        QStringLiteral("threads"), QStringLiteral("real_time"), QStringLiteral("glsl.")};
+    QMap<QString, QString> preview;
+    for (const QString &param : previewParams) {
+        const QString key = param.section(QLatin1Char('='), 0, 0);
+        if (!ignored.contains(key) && !key.startsWith(QLatin1String("meta."))) {
+            preview.insert(key, param.section(QLatin1Char('='), 1));
+        }
+    }
+    QMap<QString, QString> preset;
+    QMapIterator<QString, QString> it(presetParams);
+    while (it.hasNext()) {
+        it.next();
+        // Metadata is written by the muxer
+        if (!ignored.contains(it.key()) && !it.key().startsWith(QLatin1String("meta."))) {
+            preset.insert(it.key(), it.value());
+        }
+    }
+    return !preview.isEmpty() && preview == preset;
+}
+
+int RenderRequest::jobThreadCost(int processingThreads, int encodingThreads)
+{
+    // Encoders are usually limited by the frames MLT delivers, so an automatic thread count does not use the whole machine
+    const int defaultEncodingThreads = 2;
+    return qMax(1, qAbs(processingThreads)) + (encodingThreads > 0 ? encodingThreads : defaultEncodingThreads);
+}
+
+bool RenderRequest::canStartJob(int usedThreads, int jobThreads, int budget)
+{
+    return usedThreads <= 0 || usedThreads + jobThreads <= budget;
+}
+
+QList<int> RenderRequest::segmentSplitPoints(int in, int out, int count, int minLength, const std::vector<int> &candidates)
+{
+    QList<int> points;
+    const int length = out - in + 1;
+    count = qMin(count, length / qMax(1, minLength));
+    if (count < 2) {
+        return points;
+    }
+    const int step = length / count;
+    const int tolerance = step / 4;
+    int previous = in;
+    for (int i = 1; i < count; i++) {
+        const int ideal = in + i * step;
+        int best = -1;
+        // A segment boundary on a cut or guide is less likely to be noticed
+        for (auto it = std::lower_bound(candidates.begin(), candidates.end(), ideal - tolerance); it != candidates.end() && *it <= ideal + tolerance; ++it) {
+            if (best < 0 || qAbs(*it - ideal) < qAbs(best - ideal)) {
+                best = *it;
+            }
+        }
+        if (best < 0) {
+            best = ideal;
+        }
+        if (best - previous < minLength || out + 1 - best < minLength) {
+            continue;
+        }
+        points << best;
+        previous = best;
+    }
+    return points;
+}
+
 std::vector<RenderRequest::RenderSection> RenderRequest::getGuideSections()
 {
     std::vector<RenderSection> sections;
@@ -34,11 +34,22 @@ public:
     void setAudioFilePerTrack(bool enabled);
     void setGuideParams(std::weak_ptr<MarkerListModel> model, bool enableMultiExport, int filterCategory);
     void setOverlayData(const QString &data);
+    /** @brief Render the video in @param count segments using separate processes, 1 disables segmented rendering */
+    void setSegmentCount(int count);
+    /** @brief Reuse the valid timeline preview chunks through stream copy when their encoding matches the preset */
+    void setSmartRender(bool enabled);
 
     std::vector<RenderJob> process();
 
     QStringList errorMessages();
 
+    /** @brief Number of threads used by a render job with @param processingThreads consumer threads and @param encodingThreads encoder threads.
+     *  An automatic encoder thread count (0) counts as a few threads, so that jobs with default settings can share the machine */
+    static int jobThreadCost(int processingThreads, int encodingThreads);
+    /** @brief Returns true if a job using @param jobThreads threads can start while @param usedThreads of the @param budget threads are busy.
+     *  A job always starts when no other job is rendering */
+    static bool canStartJob(int usedThreads, int jobThreads, int budget);
+
 private:
     struct RenderSection
     {
@@ -60,12 +71,25 @@ private:
     bool m_guideMultiExport = false;
     int m_guideCategory = -1; /// category used as filter if @variable guideMultiExport is @value true
     bool m_twoPass = false;
+    int m_segmentCount = 1;
+    bool m_smartRender = false;
 
     QStringList m_errors;
 
     void setDocGeneralParams(QDomDocument doc, int in, int out);
     void setDocTwoPassParams(int pass, QDomDocument &doc, const QString &outputFile);
     std::vector<RenderSection> getGuideSections();
+    /** @brief Returns the first frame of each segment except the first one, to render [in, out] in parallel.
+     *  Segments are split at a cut or guide when one is close to the ideal split position */
+    QList<int> getSegmentSplitPoints(int in, int out);
+    /** @brief Split [in, out] in up to @param count segments of at least @param minLength frames
+     *  @param candidates sorted positions where splitting is preferred */
+    static QList<int> segmentSplitPoints(int in, int out, int count, int minLength, const std::vector<int> &candidates);
+    /** @brief Store the timeline preview chunks that can be copied into the output of @param consumer */
+    void setPreviewChunks(QDomElement &consumer);
+    /** @brief Returns true if chunks encoded with @param previewParams can be joined with frames rendered using @param presetParams.
+     *  Audio and container parameters are ignored, the audio is rendered separately */
+    static bool previewParamsMatch(const QStringList &previewParams, const RenderPresetParams &presetParams);
     static void prepareMultiAudioFiles(std::vector<RenderJob> &jobs, const QDomDocument &doc, const QString &playlistFile, const QString &targetFile);
 
     static QString createEmptyTempFile(const QString &extension);
@@ -1410,7 +1410,7 @@ void ClipModel::setGrab(bool grab)
     m_grabbed = grab;
     if (auto ptr = m_parent.lock()) {
         QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::GrabbedRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::GrabbedRole});
     }
 }
 
@@ -1424,7 +1424,7 @@ void ClipModel::setSelected(bool sel)
     if (auto ptr = m_parent.lock()) {
         if (m_currentTrackId != -1) {
             QModelIndex ix = ptr->makeClipIndexFromID(m_id);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::SelectedRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::SelectedRole});
         }
     }
 }
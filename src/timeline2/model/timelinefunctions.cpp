@@ -66,6 +66,217 @@ QMap<int, int> tracksMap;
 QMap<int, int> spacerUngroupedItems;
 int spacerMinPosition;
 QSemaphore semaphore(1);
+std::unique_ptr<TimelineClipboard> timelineClipboard;
+
+/** @brief Blocks the monitor refresh of a timeline while alive, restoring the previous state so that blocks can be nested */
+class RefreshBlocker
+{
+public:
+    explicit RefreshBlocker(bool &blockRefresh)
+        : m_blockRefresh(blockRefresh)
+        , m_previous(blockRefresh)
+    {
+        m_blockRefresh = true;
+    }
+    ~RefreshBlocker() { release(); }
+    Q_DISABLE_COPY(RefreshBlocker)
+    /** @brief Restore the previous state before the end of the scope */
+    void release()
+    {
+        if (!m_released) {
+            m_blockRefresh = m_previous;
+            m_released = true;
+        }
+    }
+
+private:
+    bool &m_blockRefresh;
+    bool m_previous;
+    bool m_released = false;
+};
+
+/** @brief Source track description of a pasted clip */
+struct PasteTrackInfo
+{
+    int track;
+    bool audioTrack;
+    int mirrorTrack;
+};
+
+/** @brief Find the destination tracks for a paste operation and store the mapping from source track positions in tracksMap
+    @param clipTracks the source tracks of the pasted clips
+    @param compositionTracks the source track and a_track of the pasted compositions
+    @param trackId the track where the user requested to paste
+    @param emptyPaste set to true if there is nothing to paste on tracks
+    @returns false if the timeline does not have enough tracks to paste
+ */
+static bool buildPasteTracksMap(const std::shared_ptr<TimelineItemModel> &timeline, const QVector<PasteTrackInfo> &clipTracks,
+                                const QVector<QPair<int, int>> &compositionTracks, bool hasSubtitles, int masterSourceTrack, int masterAudioTrack,
+                                int sourceAudioTracks, int trackId, bool &emptyPaste)
+{
+    // Check available tracks
+    QPair<QList<int>, QList<int>> projectTracks = TimelineFunctions::getAVTracksIds(timeline);
+    // find paste tracks
+    // List of all source audio tracks
+    QList<int> audioTracks;
+    // List of all source video tracks
+    QList<int> videoTracks;
+    // List of all audio tracks with their corresponding video mirror
+    std::unordered_map<int, int> audioMirrors;
+    // List of all source audio tracks that don't have video mirror
+    QList<int> singleAudioTracks;
+    // Number of required video tracks with mirror
+    int topAudioMirror = 0;
+    for (const PasteTrackInfo &info : clipTracks) {
+        int trackPos = info.track;
+        if (trackPos < 0) {
+            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
+            return false;
+        }
+        if (info.audioTrack) {
+            if (!audioTracks.contains(trackPos)) {
+                audioTracks << trackPos;
+            }
+            int videoMirror = info.mirrorTrack;
+            if (videoMirror == -1 || masterSourceTrack == -1) {
+                if (singleAudioTracks.contains(trackPos)) {
+                    continue;
+                }
+                singleAudioTracks << trackPos;
+                continue;
+            }
+            audioMirrors[trackPos] = videoMirror;
+            if (videoMirror > topAudioMirror) {
+                // We have to check how many video tracks with mirror are needed
+                topAudioMirror = videoMirror;
+            }
+            if (videoTracks.contains(videoMirror)) {
+                continue;
+            }
+            videoTracks << videoMirror;
+        } else {
+            if (videoTracks.contains(trackPos)) {
+                continue;
+            }
+            videoTracks << trackPos;
+        }
+    }
+    for (const auto &compoTracks : compositionTracks) {
+        int trackPos = compoTracks.first;
+        if (!videoTracks.contains(trackPos)) {
+            videoTracks << trackPos;
+        }
+        int atrackPos = compoTracks.second;
+        if (atrackPos == 0 || videoTracks.contains(atrackPos)) {
+            continue;
+        }
+        videoTracks << atrackPos;
+    }
+    if (audioTracks.isEmpty() && videoTracks.isEmpty() && !hasSubtitles) {
+        // playlist does not have any tracks
+        emptyPaste = true;
+        return true;
+    }
+    // Now we have a list of all source tracks, check that we have enough target tracks
+    std::sort(videoTracks.begin(), videoTracks.end());
+    std::sort(audioTracks.begin(), audioTracks.end());
+    std::sort(singleAudioTracks.begin(), singleAudioTracks.end());
+    int requestedVideoTracks = videoTracks.isEmpty() ? 0 : videoTracks.last() - videoTracks.first() + 1;
+    int requestedAudioTracks = audioTracks.isEmpty() ? 0 : audioTracks.last() - audioTracks.first() + 1;
+    if (requestedVideoTracks > projectTracks.second.size() || requestedAudioTracks > projectTracks.first.size()) {
+        pCore->displayMessage(i18n("Not enough tracks to paste clipboard (requires %1 audio, %2 video tracks)", requestedAudioTracks, requestedVideoTracks),
+                              ErrorMessage, 500);
+        return false;
+    }
+
+    // Find destination master track
+    // Check we have enough tracks above/below
+    if (requestedVideoTracks > 0) {
+        int tracksBelow = masterSourceTrack - videoTracks.first();
+        int tracksAbove = videoTracks.last() - masterSourceTrack;
+        if (projectTracks.second.indexOf(trackId) < tracksBelow) {
+            // not enough tracks below, try to paste on upper track
+            trackId = projectTracks.second.at(tracksBelow);
+        } else if ((projectTracks.second.size() - (projectTracks.second.indexOf(trackId) + 1)) < tracksAbove) {
+            // not enough tracks above, try to paste on lower track
+            trackId = projectTracks.second.at(projectTracks.second.size() - tracksAbove - 1);
+        }
+        // Find top-most video track that requires an audio mirror
+        int topAudioOffset = videoTracks.indexOf(topAudioMirror) - videoTracks.indexOf(masterSourceTrack);
+        // Check if we have enough video tracks with mirror at paste track position
+        if (requestedAudioTracks > 0 && projectTracks.first.size() <= (projectTracks.second.indexOf(trackId) + topAudioOffset)) {
+            int updatedPos = projectTracks.first.size() - topAudioOffset - 1;
+            if (updatedPos < 0 || updatedPos >= projectTracks.second.size()) {
+                pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
+                return false;
+            }
+            trackId = projectTracks.second.at(updatedPos);
+        }
+    } else if (requestedAudioTracks > 0) {
+        // Audio only
+        masterSourceTrack = masterAudioTrack;
+        int tracksBelow = masterSourceTrack - audioTracks.first();
+        int tracksAbove = audioTracks.last() - masterSourceTrack;
+        if (projectTracks.first.indexOf(trackId) < tracksBelow) {
+            // not enough tracks below, try to paste on upper track
+            trackId = projectTracks.first.at(tracksBelow);
+        } else if ((projectTracks.first.size() - (projectTracks.first.indexOf(trackId) + 1)) < tracksAbove) {
+            // not enough tracks above, try to paste on lower track
+            trackId = projectTracks.first.at(projectTracks.first.size() - tracksAbove - 1);
+        }
+    }
+    tracksMap.clear();
+    bool audioMaster = false;
+    int masterIx = projectTracks.second.indexOf(trackId);
+    if (masterIx == -1) {
+        masterIx = projectTracks.first.indexOf(trackId);
+        audioMaster = true;
+    }
+    for (int tk : qAsConst(videoTracks)) {
+        int newPos = masterIx + tk - masterSourceTrack;
+        if (newPos < 0 || newPos >= projectTracks.second.size()) {
+            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
+            return false;
+        }
+        tracksMap.insert(tk, projectTracks.second.at(newPos));
+    }
+    bool audioOffsetCalculated = false;
+    int audioOffset = 0;
+    for (const auto &mirror : audioMirrors) {
+        int videoIx = tracksMap.value(mirror.second);
+        int mirrorIx = timeline->getMirrorAudioTrackId(videoIx);
+        if (mirrorIx > 0) {
+            tracksMap.insert(mirror.first, mirrorIx);
+            if (!audioOffsetCalculated) {
+                int oldPosition = mirror.first;
+                int currentPosition = timeline->getTrackPosition(tracksMap.value(oldPosition));
+                audioOffset = currentPosition - oldPosition;
+                audioOffsetCalculated = true;
+            }
+        }
+    }
+    if (!audioOffsetCalculated && audioMaster) {
+        audioOffset = masterIx - masterSourceTrack;
+        audioOffsetCalculated = true;
+    } else if (audioMirrors.size() == 0) {
+        // We are passing ungrouped audio clips, calculate offset
+        if (sourceAudioTracks > 0) {
+            audioOffset = projectTracks.first.count() - sourceAudioTracks;
+        }
+    }
+    for (int oldPos : qAsConst(singleAudioTracks)) {
+        if (tracksMap.contains(oldPos)) {
+            continue;
+        }
+        int offsetId = oldPos + audioOffset;
+        if (offsetId < 0 || offsetId >= projectTracks.first.size()) {
+            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
+            return false;
+        }
+        tracksMap.insert(oldPos, projectTracks.first.at(offsetId));
+    }
+    return true;
+}
 
 bool TimelineFunctions::cloneClip(const std::shared_ptr<TimelineItemModel> &timeline, int clipId, int &newId, PlaylistState::ClipState state, Fun &undo,
                                   Fun &redo)
@@ -137,7 +348,7 @@ bool TimelineFunctions::processClipCut(const std::shared_ptr<TimelineItemModel>
     PlaylistState::ClipState state = timeline->m_allClips[clipId]->clipState();
     // Check if clip has an end Mix
     bool res = cloneClip(timeline, clipId, newId, state, undo, redo);
-    timeline->m_blockRefresh = true;
+    RefreshBlocker blockRefresh(timeline->m_blockRefresh);
     int updatedDuration = position - start;
     res = res && timeline->requestItemResize(clipId, updatedDuration, true, true, undo, redo);
     int newDuration = timeline->getClipPlaytime(clipId);
@@ -175,7 +386,6 @@ bool TimelineFunctions::processClipCut(const std::shared_ptr<TimelineItemModel>
         updateDuration();
         PUSH_LAMBDA(updateDuration, redo);
     }
-    timeline->m_blockRefresh = false;
     return res;
 }
 
@@ -280,13 +490,18 @@ bool TimelineFunctions::requestClipCut(const std::shared_ptr<TimelineItemModel>
 }
 
 bool TimelineFunctions::requestClipCutAll(std::shared_ptr<TimelineItemModel> timeline, int position)
+{
+    return requestMultipleClipCut(timeline, {position});
+}
+
+bool TimelineFunctions::requestMultipleClipCut(const std::shared_ptr<TimelineItemModel> &timeline, QVector<int> positions, const QVector<int> &trackIds)
 {
     QVector<std::shared_ptr<TrackModel>> affectedTracks;
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
 
     for (const auto &track : timeline->m_allTracks) {
-        if (!track->isLocked()) {
+        if (!track->isLocked() && (trackIds.isEmpty() || trackIds.contains(track->getId()))) {
             affectedTracks << track;
         }
     }
@@ -295,28 +510,44 @@ bool TimelineFunctions::requestClipCutAll(std::shared_ptr<TimelineItemModel> tim
         pCore->displayMessage(i18n("All tracks are locked"), ErrorMessage, 500);
         return false;
     }
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
 
+    // Changes are sent to the view and timeline preview once all cuts are done
     unsigned count = 0;
-    for (auto track : qAsConst(affectedTracks)) {
-        int clipId = track->getClipByPosition(position);
-        if (clipId > -1) {
-            // Found clip at position in track, cut it. Update undo/redo as we go.
-            if (!TimelineFunctions::requestClipCut(timeline, clipId, position, undo, redo)) {
-                qWarning() << "Failed to cut clip " << clipId << " at " << position;
-                pCore->displayMessage(i18n("Failed to cut clip"), ErrorMessage, 500);
-                // Undo all cuts made, assert successful undo.
-                bool undone = undo();
-                Q_ASSERT(undone);
-                return false;
+    {
+        TimelineChangeBatch batch(timeline.get());
+        for (int position : qAsConst(positions)) {
+            for (const auto &track : qAsConst(affectedTracks)) {
+                int clipId = track->getClipByPosition(position);
+                if (clipId > -1) {
+                    // Found clip at position in track, cut it. Update undo/redo as we go.
+                    if (!TimelineFunctions::requestClipCut(timeline, clipId, position, undo, redo)) {
+                        qWarning() << "Failed to cut clip " << clipId << " at " << position;
+                        pCore->displayMessage(i18n("Failed to cut clip"), ErrorMessage, 500);
+                        // Undo all cuts made, assert successful undo.
+                        bool undone = undo();
+                        Q_ASSERT(undone);
+                        return false;
+                    }
+                    count++;
+                }
             }
-            count++;
         }
     }
 
     if (!count) {
         pCore->displayMessage(i18n("No clips to cut"), ErrorMessage);
     } else {
-        pCore->pushUndo(undo, redo, i18n("Cut all clips"));
+        Fun batch_undo = [timeline, undo]() {
+            TimelineChangeBatch batch(timeline.get());
+            return undo();
+        };
+        Fun batch_redo = [timeline, redo]() {
+            TimelineChangeBatch batch(timeline.get());
+            return redo();
+        };
+        pCore->pushUndo(batch_undo, batch_redo, positions.size() > 1 ? i18n("Cut clips") : i18n("Cut all clips"));
     }
 
     return count > 0;
@@ -1617,6 +1848,9 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
     container.setAttribute(QStringLiteral("fps"), QString::number(pCore->getCurrentFps()));
     copiedItems.appendChild(container);
     QStringList binIds;
+    // Build the in-process description of the copy along with the xml one
+    auto clipboard = std::make_unique<TimelineClipboard>();
+    clipboard->documentId = pCore->currentDoc()->getDocumentProperty(QStringLiteral("documentid"));
     for (int id : allIds) {
         int startPos = timeline->getItemPosition(id);
         if (offset == -1 || startPos < offset) {
@@ -1633,14 +1867,52 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
                 binIds << bid;
             }
             int tid = timeline->getItemTrackId(id);
+            TimelineClipboard::ClipItem item;
+            item.id = id;
+            item.binId = bid;
+            item.track = clipXml.attribute(QStringLiteral("track")).toInt();
+            item.audioTrack = clipXml.hasAttribute(QStringLiteral("audioTrack"));
+            item.mirrorTrack = clipXml.attribute(QStringLiteral("mirrorTrack"), QStringLiteral("-1")).toInt();
+            item.position = startPos;
+            item.in = timeline->m_allClips[id]->getIn();
+            item.out = timeline->m_allClips[id]->getOut();
+            item.subPlaylist = timeline->m_allClips[id]->getSubPlaylistIndex();
+            item.audioStream = timeline->m_allClips[id]->getIntProperty(QStringLiteral("audio_index"));
+            item.speed = timeline->m_allClips[id]->getSpeed();
+            item.warpPitch = !qFuzzyCompare(item.speed, 1.) && timeline->m_allClips[id]->getIntProperty(QStringLiteral("warp_pitch"));
+            item.timeRemap = clipXml.hasAttribute(QStringLiteral("timemap"));
+            item.timeMap = clipXml.attribute(QStringLiteral("timemap"));
+            item.timePitch = clipXml.attribute(QStringLiteral("timepitch")).toInt();
+            item.timeBlend = clipXml.attribute(QStringLiteral("timeblend"));
+            item.effects = clipboard->data.importNode(clipXml.firstChildElement(QStringLiteral("effects")), true).toElement();
             if (timeline->getTrackById_const(tid)->hasStartMix(id)) {
                 QDomElement mix = timeline->getTrackById_const(tid)->mixXml(copiedItems, id);
                 clipXml.appendChild(mix);
+                item.mix = clipboard->data.importNode(mix, true).toElement();
             }
+            clipboard->clips.push_back(item);
         } else if (timeline->isComposition(id)) {
-            container.appendChild(timeline->m_allCompositions[id]->toXml(copiedItems));
+            QDomElement compoXml = timeline->m_allCompositions[id]->toXml(copiedItems);
+            container.appendChild(compoXml);
+            TimelineClipboard::CompositionItem item;
+            item.id = id;
+            item.assetId = compoXml.attribute(QStringLiteral("composition"));
+            item.track = compoXml.attribute(QStringLiteral("track")).toInt();
+            item.aTrack = compoXml.attribute(QStringLiteral("a_track")).toInt();
+            item.position = startPos;
+            item.in = compoXml.attribute(QStringLiteral("in")).toInt();
+            item.out = compoXml.attribute(QStringLiteral("out")).toInt();
+            QDomElement prop = compoXml.firstChildElement(QStringLiteral("property"));
+            while (!prop.isNull()) {
+                item.properties.append({prop.attribute(QStringLiteral("name")), prop.text()});
+                prop = prop.nextSiblingElement(QStringLiteral("property"));
+            }
+            clipboard->compositions.push_back(item);
         } else if (timeline->isSubTitle(id)) {
-            container.appendChild(timeline->getSubtitleModel()->toXml(id, copiedItems));
+            QDomElement subXml = timeline->getSubtitleModel()->toXml(id, copiedItems);
+            container.appendChild(subXml);
+            clipboard->subtitles.push_back(
+                {id, subXml.attribute(QStringLiteral("in")).toInt(), subXml.attribute(QStringLiteral("out")).toInt(), subXml.attribute(QStringLiteral("text"))});
         } else {
             Q_ASSERT(false);
         }
@@ -1651,6 +1923,7 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
         std::shared_ptr<ProjectClip> clip = pCore->projectItemModel()->getClipByBinID(id);
         QDomDocument tmp;
         container2.appendChild(clip->toXml(tmp));
+        clipboard->binHashes.insert(id, clip->hash());
     }
     container.setAttribute(QStringLiteral("offset"), offset);
     container.setAttribute(QStringLiteral("duration"), lastFrame - offset);
@@ -1669,10 +1942,15 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
     /* masterTrack contains the reference track over which we want to paste.
        this is a video track, unless audioCopy is defined */
     container.setAttribute(QStringLiteral("masterTrack"), masterTrack);
+    clipboard->masterTrack = masterTrack;
+    clipboard->masterAudioTrack = container.attribute(QStringLiteral("masterAudioTrack"), QStringLiteral("0")).toInt();
+    clipboard->offset = offset;
+    clipboard->duration = lastFrame - offset;
     container.setAttribute(QStringLiteral("documentid"), pCore->currentDoc()->getDocumentProperty(QStringLiteral("documentid")));
     QPair<int, int> avTracks = timeline->getAVtracksCount();
     container.setAttribute(QStringLiteral("audioTracks"), avTracks.first);
     container.setAttribute(QStringLiteral("videoTracks"), avTracks.second);
+    clipboard->audioTracks = avTracks.first;
     QDomElement grp = copiedItems.createElement(QStringLiteral("groups"));
     container.appendChild(grp);
     std::unordered_set<int> groupRoots;
@@ -1700,9 +1978,29 @@ QString TimelineFunctions::copyClips(const std::shared_ptr<TimelineItemModel> &t
     }
     qDebug() << "\n=======";
     grp.appendChild(copiedItems.createTextNode(timeline->m_groups->toJson(groupRoots)));
+    std::function<TimelineClipboard::GroupNode(int)> buildGroupNode = [&](int gid) {
+        TimelineClipboard::GroupNode node;
+        if (timeline->m_groups->isLeaf(gid)) {
+            node.type = GroupType::Leaf;
+            node.itemId = gid;
+            return node;
+        }
+        node.type = timeline->m_groups->getType(gid);
+        node.itemId = -1;
+        for (int child : timeline->m_groups->getDirectChildren(gid)) {
+            node.children.push_back(buildGroupNode(child));
+        }
+        return node;
+    };
+    for (int gp : groupRoots) {
+        if (gp > -1 && !timeline->m_groups->isLeaf(gp)) {
+            clipboard->groups.push_back(buildGroupNode(gp));
+        }
+    }
 
-    qDebug() << " / // / PASTED DOC: \n\n" << copiedItems.toString() << "\n\n------------";
-    return copiedItems.toString();
+    clipboard->clipboardText = copiedItems.toString();
+    timelineClipboard = std::move(clipboard);
+    return timelineClipboard->clipboardText;
 }
 
 bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &timeline, const QString &pasteString, int trackId, int position)
@@ -1710,7 +2008,7 @@ bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &tim
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
     if (TimelineFunctions::pasteClips(timeline, pasteString, trackId, position, undo, redo)) {
-        pCore->pushUndo(undo, redo, i18n("Paste clips"));
+        pCore->pushUndo(undo, redo, i18n("Paste clips"), pasteString.size() * qint64(sizeof(QChar)));
         return true;
     }
     return false;
@@ -1740,6 +2038,15 @@ bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &tim
         }
     }
     waitingBinIds.clear();
+    if (inPos == 0 && duration == -1 && canPasteFromClipboard(pasteString)) {
+        // Copied from this document, directly paste from the in-process clipboard
+        bool result = TimelineFunctions::pasteClipboard(timeline, *timelineClipboard, trackId, position, undo, redo);
+        semaphore.release(1);
+        if (result) {
+            pCore->seekMonitor(Kdenlive::ProjectMonitor, position + timelineClipboard->duration);
+        }
+        return result;
+    }
     QDomDocument copiedItems;
     copiedItems.setContent(pasteString);
     if (copiedItems.documentElement().tagName() == QLatin1String("kdenlive-scene")) {
@@ -1751,190 +2058,32 @@ bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &tim
     }
     const QString docId = copiedItems.documentElement().attribute(QStringLiteral("documentid"));
     mappedIds.clear();
-    // Check available tracks
-    QPair<QList<int>, QList<int>> projectTracks = TimelineFunctions::getAVTracksIds(timeline);
     int masterSourceTrack = copiedItems.documentElement().attribute(QStringLiteral("masterTrack"), QStringLiteral("-1")).toInt();
     QDomNodeList clips = copiedItems.documentElement().elementsByTagName(QStringLiteral("clip"));
     QDomNodeList compositions = copiedItems.documentElement().elementsByTagName(QStringLiteral("composition"));
     QDomNodeList subtitles = copiedItems.documentElement().elementsByTagName(QStringLiteral("subtitle"));
-    // find paste tracks
-    // List of all source audio tracks
-    QList<int> audioTracks;
-    // List of all source video tracks
-    QList<int> videoTracks;
-    // List of all audio tracks with their corresponding video mirror
-    std::unordered_map<int, int> audioMirrors;
-    // List of all source audio tracks that don't have video mirror
-    QList<int> singleAudioTracks;
-    // Number of required video tracks with mirror
-    int topAudioMirror = 0;
+    QVector<PasteTrackInfo> clipTracks;
     for (int i = 0; i < clips.count(); i++) {
         QDomElement prod = clips.at(i).toElement();
-        int trackPos = prod.attribute(QStringLiteral("track")).toInt();
-        if (trackPos < 0) {
-            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
-            semaphore.release(1);
-            return false;
-        }
-        bool audioTrack = prod.hasAttribute(QStringLiteral("audioTrack"));
-        if (audioTrack) {
-            if (!audioTracks.contains(trackPos)) {
-                audioTracks << trackPos;
-            }
-            int videoMirror = prod.attribute(QStringLiteral("mirrorTrack")).toInt();
-            if (videoMirror == -1 || masterSourceTrack == -1) {
-                if (singleAudioTracks.contains(trackPos)) {
-                    continue;
-                }
-                singleAudioTracks << trackPos;
-                continue;
-            }
-            audioMirrors[trackPos] = videoMirror;
-            if (videoMirror > topAudioMirror) {
-                // We have to check how many video tracks with mirror are needed
-                topAudioMirror = videoMirror;
-            }
-            if (videoTracks.contains(videoMirror)) {
-                continue;
-            }
-            videoTracks << videoMirror;
-        } else {
-            if (videoTracks.contains(trackPos)) {
-                continue;
-            }
-            videoTracks << trackPos;
-        }
+        clipTracks.append({prod.attribute(QStringLiteral("track")).toInt(), prod.hasAttribute(QStringLiteral("audioTrack")),
+                           prod.attribute(QStringLiteral("mirrorTrack")).toInt()});
     }
+    QVector<QPair<int, int>> compositionTracks;
     for (int i = 0; i < compositions.count(); i++) {
         QDomElement prod = compositions.at(i).toElement();
-        int trackPos = prod.attribute(QStringLiteral("track")).toInt();
-        if (!videoTracks.contains(trackPos)) {
-            videoTracks << trackPos;
-        }
-        int atrackPos = prod.attribute(QStringLiteral("a_track")).toInt();
-        if (atrackPos == 0 || videoTracks.contains(atrackPos)) {
-            continue;
-        }
-        videoTracks << atrackPos;
+        compositionTracks.append({prod.attribute(QStringLiteral("track")).toInt(), prod.attribute(QStringLiteral("a_track")).toInt()});
     }
-    if (audioTracks.isEmpty() && videoTracks.isEmpty() && subtitles.isEmpty()) {
-        // playlist does not have any tracks, exit
-        semaphore.release(1);
-        return true;
-    }
-    // Now we have a list of all source tracks, check that we have enough target tracks
-    std::sort(videoTracks.begin(), videoTracks.end());
-    std::sort(audioTracks.begin(), audioTracks.end());
-    std::sort(singleAudioTracks.begin(), singleAudioTracks.end());
-    // qDebug()<<"== GOT WANTED TKS\n VIDEO: "<<videoTracks<<"\n AUDIO TKS: "<<audioTracks<<"\n SINGLE AUDIO: "<<singleAudioTracks;
-    int requestedVideoTracks = videoTracks.isEmpty() ? 0 : videoTracks.last() - videoTracks.first() + 1;
-    int requestedAudioTracks = audioTracks.isEmpty() ? 0 : audioTracks.last() - audioTracks.first() + 1;
-    if (requestedVideoTracks > projectTracks.second.size() || requestedAudioTracks > projectTracks.first.size()) {
-        pCore->displayMessage(i18n("Not enough tracks to paste clipboard (requires %1 audio, %2 video tracks)", requestedAudioTracks, requestedVideoTracks),
-                              ErrorMessage, 500);
+    bool emptyPaste = false;
+    if (!buildPasteTracksMap(timeline, clipTracks, compositionTracks, !subtitles.isEmpty(), masterSourceTrack,
+                             copiedItems.documentElement().attribute(QStringLiteral("masterAudioTrack")).toInt(),
+                             copiedItems.documentElement().attribute(QStringLiteral("audioTracks")).toInt(), trackId, emptyPaste)) {
         semaphore.release(1);
         return false;
     }
-
-    // Find destination master track
-    // Check we have enough tracks above/below
-    if (requestedVideoTracks > 0) {
-        qDebug() << "MASTERSTK: " << masterSourceTrack << ", VTKS: " << videoTracks;
-        int tracksBelow = masterSourceTrack - videoTracks.first();
-        int tracksAbove = videoTracks.last() - masterSourceTrack;
-        qDebug() << "// RQST TKS BELOW: " << tracksBelow << " / ABOVE: " << tracksAbove;
-        qDebug() << "// EXISTING TKS BELOW: " << projectTracks.second.indexOf(trackId) << ", IX: " << trackId;
-        qDebug() << "// EXISTING TKS ABOVE: " << projectTracks.second.size() << " - " << projectTracks.second.indexOf(trackId);
-        if (projectTracks.second.indexOf(trackId) < tracksBelow) {
-            qDebug() << "// UPDATING BELOW TID IX TO: " << tracksBelow;
-            // not enough tracks below, try to paste on upper track
-            trackId = projectTracks.second.at(tracksBelow);
-        } else if ((projectTracks.second.size() - (projectTracks.second.indexOf(trackId) + 1)) < tracksAbove) {
-            // not enough tracks above, try to paste on lower track
-            qDebug() << "// UPDATING ABOVE TID IX TO: " << (projectTracks.second.size() - tracksAbove);
-            trackId = projectTracks.second.at(projectTracks.second.size() - tracksAbove - 1);
-        }
-        // Find top-most video track that requires an audio mirror
-        int topAudioOffset = videoTracks.indexOf(topAudioMirror) - videoTracks.indexOf(masterSourceTrack);
-        // Check if we have enough video tracks with mirror at paste track position
-        if (requestedAudioTracks > 0 && projectTracks.first.size() <= (projectTracks.second.indexOf(trackId) + topAudioOffset)) {
-            int updatedPos = projectTracks.first.size() - topAudioOffset - 1;
-            if (updatedPos < 0 || updatedPos >= projectTracks.second.size()) {
-                pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
-                semaphore.release(1);
-                return false;
-            }
-            trackId = projectTracks.second.at(updatedPos);
-        }
-    } else if (requestedAudioTracks > 0) {
-        // Audio only
-        masterSourceTrack = copiedItems.documentElement().attribute(QStringLiteral("masterAudioTrack")).toInt();
-        int tracksBelow = masterSourceTrack - audioTracks.first();
-        int tracksAbove = audioTracks.last() - masterSourceTrack;
-        if (projectTracks.first.indexOf(trackId) < tracksBelow) {
-            qDebug() << "// UPDATING BELOW TID IX TO: " << tracksBelow;
-            // not enough tracks below, try to paste on upper track
-            trackId = projectTracks.first.at(tracksBelow);
-        } else if ((projectTracks.first.size() - (projectTracks.first.indexOf(trackId) + 1)) < tracksAbove) {
-            // not enough tracks above, try to paste on lower track
-            qDebug() << "// UPDATING ABOVE TID IX TO: " << (projectTracks.first.size() - tracksAbove);
-            trackId = projectTracks.first.at(projectTracks.first.size() - tracksAbove - 1);
-        }
-    }
-    tracksMap.clear();
-    bool audioMaster = false;
-    int masterIx = projectTracks.second.indexOf(trackId);
-    if (masterIx == -1) {
-        masterIx = projectTracks.first.indexOf(trackId);
-        audioMaster = true;
-    }
-    for (int tk : qAsConst(videoTracks)) {
-        int newPos = masterIx + tk - masterSourceTrack;
-        if (newPos < 0 || newPos >= projectTracks.second.size()) {
-            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
-            semaphore.release(1);
-            return false;
-        }
-        tracksMap.insert(tk, projectTracks.second.at(newPos));
-        // qDebug() << "/// MAPPING SOURCE TRACK: "<<tk<<" TO PROJECT TK: "<<projectTracks.second.at(newPos)<<" =
-        // "<<timeline->getTrackMltIndex(projectTracks.second.at(newPos));
-    }
-    bool audioOffsetCalculated = false;
-    int audioOffset = 0;
-    for (const auto &mirror : audioMirrors) {
-        int videoIx = tracksMap.value(mirror.second);
-        int mirrorIx = timeline->getMirrorAudioTrackId(videoIx);
-        if (mirrorIx > 0) {
-            tracksMap.insert(mirror.first, mirrorIx);
-            if (!audioOffsetCalculated) {
-                int oldPosition = mirror.first;
-                int currentPosition = timeline->getTrackPosition(tracksMap.value(oldPosition));
-                audioOffset = currentPosition - oldPosition;
-                audioOffsetCalculated = true;
-            }
-        }
-    }
-    if (!audioOffsetCalculated && audioMaster) {
-        audioOffset = masterIx - masterSourceTrack;
-        audioOffsetCalculated = true;
-    } else if (audioMirrors.size() == 0) {
-        // We are passing ungrouped audio clips, calculate offset
-        int sourceAudioTracks = copiedItems.documentElement().attribute(QStringLiteral("audioTracks")).toInt();
-        if (sourceAudioTracks > 0) {
-            audioOffset = projectTracks.first.count() - sourceAudioTracks;
-        }
-    }
-    for (int oldPos : qAsConst(singleAudioTracks)) {
-        if (tracksMap.contains(oldPos)) {
-            continue;
-        }
-        int offsetId = oldPos + audioOffset;
-        if (offsetId < 0 || offsetId >= projectTracks.first.size()) {
-            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
-            semaphore.release(1);
-            return false;
-        }
-        tracksMap.insert(oldPos, projectTracks.first.at(offsetId));
+    if (emptyPaste) {
+        // playlist does not have any tracks, exit
+        semaphore.release(1);
+        return true;
     }
     std::function<void(const QString &)> callBack = [timeline, copiedItems, position, inPos, duration](const QString &binId) {
         waitingBinIds.removeAll(binId);
@@ -2155,6 +2304,223 @@ bool TimelineFunctions::pasteClips(const std::shared_ptr<TimelineItemModel> &tim
     return true;
 }
 
+bool TimelineFunctions::canPasteFromClipboard(const QString &pasteString)
+{
+    if (!timelineClipboard || timelineClipboard->clipboardText != pasteString) {
+        return false;
+    }
+    if (timelineClipboard->documentId != pCore->currentDoc()->getDocumentProperty(QStringLiteral("documentid"))) {
+        return false;
+    }
+    // Ensure the bin clips were not removed or replaced since the copy
+    QMapIterator<QString, QString> i(timelineClipboard->binHashes);
+    while (i.hasNext()) {
+        i.next();
+        if (!pCore->projectItemModel()->validateClip(i.key(), i.value())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TimelineFunctions::pasteClipboard(const std::shared_ptr<TimelineItemModel> &timeline, const TimelineClipboard &clipboard, int trackId, int position,
+                                       Fun &undo, Fun &redo)
+{
+    QVector<PasteTrackInfo> clipTracks;
+    clipTracks.reserve(int(clipboard.clips.size()));
+    for (const auto &clip : clipboard.clips) {
+        clipTracks.append({clip.track, clip.audioTrack, clip.mirrorTrack});
+    }
+    QVector<QPair<int, int>> compositionTracks;
+    compositionTracks.reserve(int(clipboard.compositions.size()));
+    for (const auto &compo : clipboard.compositions) {
+        compositionTracks.append({compo.track, compo.aTrack});
+    }
+    bool emptyPaste = false;
+    if (!buildPasteTracksMap(timeline, clipTracks, compositionTracks, !clipboard.subtitles.empty(), clipboard.masterTrack, clipboard.masterAudioTrack,
+                             clipboard.audioTracks, trackId, emptyPaste)) {
+        return false;
+    }
+    if (emptyPaste) {
+        return true;
+    }
+    Fun local_undo = []() { return true; };
+    Fun local_redo = []() { return true; };
+    std::unordered_map<int, int> correspondingIds;
+    QVector<std::pair<const TimelineClipboard::ClipItem *, int>> pastedMixes;
+    // Monitor refresh and timeline duration are only updated once all items are planted
+    RefreshBlocker blockRefresh(timeline->m_blockRefresh);
+    bool res = true;
+    for (const auto &clip : clipboard.clips) {
+        int curTrackId = tracksMap.value(clip.track);
+        if (!timeline->isTrack(curTrackId)) {
+            pCore->displayMessage(i18n("Not enough tracks to paste clipboard"), ErrorMessage, 500);
+            res = false;
+            break;
+        }
+        int newId;
+        res = timeline->requestClipCreation(clip.binId, newId, timeline->getTrackById_const(curTrackId)->trackType(), clip.audioStream, clip.speed,
+                                            clip.warpPitch, local_undo, local_redo);
+        if (!res) {
+            break;
+        }
+        std::shared_ptr<ClipModel> newClip = timeline->m_allClips[newId];
+        if (clip.timeRemap) {
+            newClip->useTimeRemapProducer(true, local_undo, local_redo);
+            if (newClip->m_producer->parent().type() == mlt_service_chain_type) {
+                Mlt::Chain fromChain(newClip->m_producer->parent());
+                int count = fromChain.link_count();
+                for (int i = 0; i < count; i++) {
+                    QScopedPointer<Mlt::Link> fromLink(fromChain.link(i));
+                    if (fromLink && fromLink->is_valid() && fromLink->get("mlt_service") &&
+                        fromLink->get("mlt_service") == QLatin1String("timeremap")) {
+                        fromLink->set("map", clip.timeMap.toUtf8().constData());
+                        fromLink->set("pitch", clip.timePitch);
+                        fromLink->set("image_mode", clip.timeBlend.toUtf8().constData());
+                        break;
+                    }
+                }
+            }
+        }
+        int in = clip.in;
+        int out = clip.out;
+        if (newClip->m_endlessResize) {
+            out = out - in;
+            in = 0;
+            newClip->m_producer->set("length", out + 1);
+            newClip->m_producer->set("out", out);
+        }
+        newClip->setInOut(in, out);
+        if (clip.subPlaylist > 0) {
+            newClip->setSubPlaylistIndex(clip.subPlaylist, curTrackId);
+        }
+        correspondingIds[clip.id] = newId;
+        if (!clip.effects.isNull()) {
+            timeline->getClipEffectStackModel(newId)->fromXml(clip.effects, local_undo, local_redo);
+        }
+        res = timeline->getTrackById(curTrackId)->requestClipInsertion(newId, position + clip.position - clipboard.offset, true, true, local_undo, local_redo,
+                                                                       true);
+        if (!res) {
+            qDebug() << "=== COULD NOT PASTE CLIP: " << newId << " ON TRACK: " << curTrackId << " AT: " << position;
+            break;
+        }
+        if (!clip.mix.isNull()) {
+            pastedMixes.append({&clip, curTrackId});
+        }
+    }
+    // Mixes (same track transitions)
+    for (int k = 0; res && k < pastedMixes.size(); k++) {
+        const QDomElement &mix = pastedMixes.at(k).first->mix;
+        int originalFirstClipId = mix.attribute(QLatin1String("firstClip")).toInt();
+        int originalSecondClipId = mix.attribute(QLatin1String("secondClip")).toInt();
+        if (correspondingIds.count(originalFirstClipId) == 0 || correspondingIds.count(originalSecondClipId) == 0) {
+            continue;
+        }
+        QVector<QPair<QString, QVariant>> params;
+        QDomNodeList paramsXml = mix.elementsByTagName(QLatin1String("param"));
+        for (int j = 0; j < paramsXml.count(); j++) {
+            QDomElement e = paramsXml.at(j).toElement();
+            params.append({e.attribute(QLatin1String("name")), e.text()});
+        }
+        std::pair<QString, QVector<QPair<QString, QVariant>>> mixParams = {mix.attribute(QLatin1String("asset")), params};
+        MixInfo mixData;
+        mixData.firstClipId = correspondingIds[originalFirstClipId];
+        mixData.secondClipId = correspondingIds[originalSecondClipId];
+        mixData.firstClipInOut.second = mix.attribute(QLatin1String("mixEnd")).toInt();
+        mixData.secondClipInOut.first = mix.attribute(QLatin1String("mixStart")).toInt();
+        mixData.mixOffset = mix.attribute(QLatin1String("mixOffset")).toInt();
+        std::pair<int, int> tracks = {mix.attribute(QLatin1String("a_track")).toInt(), mix.attribute(QLatin1String("b_track")).toInt()};
+        if (tracks.first == tracks.second) {
+            tracks = {0, 1};
+        }
+        timeline->getTrackById_const(pastedMixes.at(k).second)->createMix(mixData, mixParams, tracks, true);
+    }
+    // Compositions
+    for (size_t i = 0; res && i < clipboard.compositions.size(); i++) {
+        const auto &compo = clipboard.compositions.at(i);
+        int curTrackId = tracksMap.value(compo.track);
+        int aTrackId = 0;
+        if (compo.aTrack >= 0 && tracksMap.contains(compo.aTrack)) {
+            // We need to add 1 here to account for black background track
+            aTrackId = timeline->getTrackPosition(tracksMap.value(compo.aTrack)) + 1;
+        }
+        auto transProps = std::make_unique<Mlt::Properties>();
+        for (const auto &prop : compo.properties) {
+            transProps->set(prop.first.toUtf8().constData(), prop.second.toUtf8().constData());
+        }
+        int newId;
+        res = timeline->requestCompositionCreation(compo.assetId, compo.out - compo.in + 1, std::move(transProps), newId, local_undo, local_redo);
+        res = res && timeline->requestCompositionMove(newId, curTrackId, aTrackId, position + compo.position - clipboard.offset, true, true, local_undo,
+                                                      local_redo);
+        if (res) {
+            correspondingIds[compo.id] = newId;
+        }
+    }
+    // Subtitles
+    if (res && !clipboard.subtitles.empty()) {
+        auto subModel = timeline->getSubtitleModel();
+        if (!subModel) {
+            // This timeline doesn't yet have subtitles, initiate
+            pCore->window()->slotShowSubtitles(true);
+            subModel = timeline->getSubtitleModel();
+        }
+        for (size_t i = 0; res && i < clipboard.subtitles.size(); i++) {
+            const auto &sub = clipboard.subtitles.at(i);
+            int in = position + sub.in - clipboard.offset;
+            res = subModel->addSubtitle(GenTime(in, pCore->getCurrentFps()), GenTime(position + sub.out - clipboard.offset, pCore->getCurrentFps()), sub.text,
+                                        local_undo, local_redo);
+            if (res) {
+                correspondingIds[sub.id] = timeline->getSubtitleByStartPosition(in);
+            }
+        }
+    }
+    blockRefresh.release();
+    if (!res) {
+        bool undone = local_undo();
+        Q_ASSERT(undone);
+        pCore->displayMessage(i18n("Could not paste items in timeline"), ErrorMessage, 500);
+        return false;
+    }
+    Fun updateDuration = [timeline]() {
+        timeline->updateDuration();
+        return true;
+    };
+    updateDuration();
+    PUSH_LAMBDA(updateDuration, local_undo);
+    PUSH_LAMBDA(updateDuration, local_redo);
+    timeline->checkRefresh(position, position + clipboard.duration);
+    // Rebuild groups directly from the copied hierarchy
+    std::function<int(const TimelineClipboard::GroupNode &)> rebuildGroup = [&](const TimelineClipboard::GroupNode &node) {
+        if (node.type == GroupType::Leaf) {
+            auto it = correspondingIds.find(node.itemId);
+            return it == correspondingIds.end() ? -1 : it->second;
+        }
+        std::unordered_set<int> ids;
+        for (const auto &child : node.children) {
+            int id = rebuildGroup(child);
+            if (id > -1) {
+                ids.insert(id);
+            }
+        }
+        if (ids.empty()) {
+            return -1;
+        }
+        return timeline->m_groups->groupItems(ids, local_undo, local_redo, node.type);
+    };
+    for (const auto &node : clipboard.groups) {
+        rebuildGroup(node);
+    }
+    // Ensure to clear selection in undo/redo too.
+    Fun unselect = [timeline]() {
+        timeline->requestClearSelection();
+        return true;
+    };
+    PUSH_FRONT_LAMBDA(unselect, local_undo);
+    PUSH_FRONT_LAMBDA(unselect, local_redo);
+    UPDATE_UNDO_REDO_NOLOCK(local_redo, local_undo, undo, redo);
+    return true;
+}
+
 bool TimelineFunctions::pasteTimelineClips(const std::shared_ptr<TimelineItemModel> &timeline, const QDomDocument &copiedItems, int position, int inPos,
                                            int duration)
 {
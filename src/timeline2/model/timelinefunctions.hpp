@@ -12,11 +12,88 @@ SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
 #include "undohelper.hpp"
 #include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include <QDir>
+#include <QDomDocument>
+#include <QMap>
+#include <QVector>
 
 class TimelineItemModel;
 
+/** @class TimelineClipboard
+    @brief In-process description of the last timeline copy.
+    Items are referenced by their bin id and position, so that pasting in the same document can reuse the already loaded bin producers
+    instead of parsing the xml representation that is sent to the system clipboard (which is only needed to paste in another instance).
+ */
+struct TimelineClipboard
+{
+    struct ClipItem
+    {
+        int id;
+        QString binId;
+        int track;
+        bool audioTrack;
+        int mirrorTrack;
+        int position;
+        int in;
+        int out;
+        int subPlaylist;
+        int audioStream;
+        double speed;
+        bool warpPitch;
+        bool timeRemap;
+        QString timeMap;
+        int timePitch;
+        QString timeBlend;
+        /** @brief Effect stack of the source clip, owned by TimelineClipboard::data */
+        QDomElement effects;
+        /** @brief Start mix of the source clip if any, owned by TimelineClipboard::data */
+        QDomElement mix;
+    };
+    struct CompositionItem
+    {
+        int id;
+        QString assetId;
+        int track;
+        int aTrack;
+        int position;
+        int in;
+        int out;
+        QVector<QPair<QString, QString>> properties;
+    };
+    struct SubtitleItem
+    {
+        int id;
+        int in;
+        int out;
+        QString text;
+    };
+    /** @brief A node of the copied group hierarchy. Leaves reference the source item id */
+    struct GroupNode
+    {
+        GroupType type;
+        int itemId;
+        std::vector<GroupNode> children;
+    };
+    /** @brief The document this copy was made from */
+    QString documentId;
+    /** @brief The xml data sent to the system clipboard for this copy, used to check that the clipboard was not changed since */
+    QString clipboardText;
+    int offset{0};
+    int duration{0};
+    int masterTrack{-1};
+    int masterAudioTrack{-1};
+    int audioTracks{0};
+    /** @brief Bin ids of the copied clips with their hash at copy time */
+    QMap<QString, QString> binHashes;
+    std::vector<ClipItem> clips;
+    std::vector<CompositionItem> compositions;
+    std::vector<SubtitleItem> subtitles;
+    std::vector<GroupNode> groups;
+    QDomDocument data;
+};
+
 /** @namespace TimelineFunction
     @brief This namespace contains a list of static methods for advanced timeline editing features
     based on timelinemodel methods
@@ -38,6 +115,14 @@ struct TimelineFunctions
 
     /** @brief Cuts all clips at given position */
     static bool requestClipCutAll(std::shared_ptr<TimelineItemModel> timeline, int position);
+    /** @brief Cuts the clips of several tracks at several positions, creating a single undo entry.
+       View updates and timeline preview invalidation are batched during the operation and sent once at the end.
+       Returns true if at least one clip was cut
+       @param timeline : ptr to the timeline model
+       @param positions: positions (in frames from the beginning of the timeline) where to cut
+       @param trackIds: ids of the tracks to cut, all unlocked tracks if empty
+    */
+    static bool requestMultipleClipCut(const std::shared_ptr<TimelineItemModel> &timeline, QVector<int> positions, const QVector<int> &trackIds = {});
 
     /** @brief Makes a perfect clone of a given clip, but do not insert it */
     static bool cloneClip(const std::shared_ptr<TimelineItemModel> &timeline, int clipId, int &newId, PlaylistState::ClipState state, Fun &undo, Fun &redo);
@@ -50,6 +135,11 @@ struct TimelineFunctions
                            int inPos = 0, int duration = -1);
     static bool pasteClipsWithUndo(const std::shared_ptr<TimelineItemModel> &timeline, const QString &pasteString, int trackId, int position, Fun &undo,
                                    Fun &redo);
+    /** @brief Paste the clips described by the in-process clipboard, in a single undo operation. Returns true on success */
+    static bool pasteClipboard(const std::shared_ptr<TimelineItemModel> &timeline, const TimelineClipboard &clipboard, int trackId, int position, Fun &undo,
+                               Fun &redo);
+    /** @brief Returns true if the given paste string was produced by the last copy and can be pasted from the in-process clipboard */
+    static bool canPasteFromClipboard(const QString &pasteString);
     static bool pasteTimelineClips(const std::shared_ptr<TimelineItemModel> &timeline, const QDomDocument &copiedItems, int position, int inPos = 0,
                                    int duration = -1);
     static bool pasteTimelineClips(const std::shared_ptr<TimelineItemModel> &timeline, QDomDocument copiedItems, int position, Fun &timeline_undo,
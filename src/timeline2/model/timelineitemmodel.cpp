@@ -22,6 +22,8 @@
 #include "transitions/transitionsrepository.hpp"
 #include <QDebug>
 #include <QFileInfo>
+#include <algorithm>
+#include <map>
 #include <mlt++/MltField.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
@@ -47,6 +49,7 @@ TimelineItemModel::TimelineItemModel(const QUuid &uuid, std::weak_ptr<DocUndoSta
     : TimelineModel(uuid, std::move(undo_stack))
 {
     m_guidesModel->registerSnapModel(std::static_pointer_cast<SnapInterface>(m_snaps));
+    connect(this, &QAbstractItemModel::dataChanged, this, [this]() { m_dataChangedCount++; });
 }
 
 void TimelineItemModel::finishConstruct(const std::shared_ptr<TimelineItemModel> &ptr)
@@ -665,11 +668,17 @@ void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelInd
             roles.push_back(TimelineModel::OutPointRole);
         }
     }
+    if (batchChange(topleft, bottomright, roles)) {
+        return;
+    }
     Q_EMIT dataChanged(topleft, bottomright, roles);
 }
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
 {
+    if (batchChange(topleft, bottomright, roles)) {
+        return;
+    }
     Q_EMIT dataChanged(topleft, bottomright, roles);
 }
 
@@ -781,6 +790,9 @@ void TimelineItemModel::buildTrackCompositing(bool rebuild)
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role)
 {
+    if (batchChange(topleft, bottomright, {role})) {
+        return;
+    }
     Q_EMIT dataChanged(topleft, bottomright, {role});
 }
 
@@ -811,6 +823,119 @@ void TimelineItemModel::_resetView()
     endResetModel();
 }
 
+void TimelineItemModel::beginChangeBatch()
+{
+    if (m_changeBatches++ > 0) {
+        return;
+    }
+    // Timeline preview is invalidated once for the whole batch
+    m_batchedZone = {-1, -1};
+    if (m_timelinePreview) {
+        disconnect(this, &TimelineModel::invalidateZone, m_timelinePreview.get(), &PreviewManager::invalidatePreview);
+        m_batchedZoneConnection = connect(this, &TimelineModel::invalidateZone, this, [this](int in, int out) {
+            if (in > out) {
+                std::swap(in, out);
+            }
+            if (m_batchedZone.first == -1) {
+                m_batchedZone = {in, out};
+            } else {
+                m_batchedZone = {qMin(in, m_batchedZone.first), qMax(out, m_batchedZone.second)};
+            }
+        });
+    }
+}
+
+bool TimelineItemModel::batchChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
+{
+    if (m_changeBatches == 0 || !topleft.isValid()) {
+        return false;
+    }
+    const QModelIndex parent = topleft.parent();
+    const int last = bottomright.isValid() ? bottomright.row() : topleft.row();
+    for (int row = topleft.row(); row <= last; ++row) {
+        const QModelIndex ix = row == topleft.row() ? topleft : index(row, 0, parent);
+        if (!ix.isValid()) {
+            continue;
+        }
+        BatchedChange &change = m_batchedChanges[int(ix.internalId())];
+        if (roles.isEmpty()) {
+            change.allRoles = true;
+            change.roles.clear();
+        } else if (!change.allRoles) {
+            for (int role : roles) {
+                if (!change.roles.contains(role)) {
+                    change.roles.push_back(role);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void TimelineItemModel::endChangeBatch()
+{
+    Q_ASSERT(m_changeBatches > 0);
+    if (--m_changeBatches > 0) {
+        return;
+    }
+    if (m_batchedZoneConnection) {
+        disconnect(m_batchedZoneConnection);
+        m_batchedZoneConnection = QMetaObject::Connection();
+        if (m_timelinePreview) {
+            connect(this, &TimelineModel::invalidateZone, m_timelinePreview.get(), &PreviewManager::invalidatePreview, Qt::DirectConnection);
+            if (m_batchedZone.first > -1) {
+                Q_EMIT invalidateZone(m_batchedZone.first, m_batchedZone.second);
+            }
+        }
+    }
+    if (m_batchedChanges.empty()) {
+        return;
+    }
+    // Items may have changed track or row during the batch, find their current index. Track changes are stored with parent -1
+    std::map<int, std::vector<std::pair<int, BatchedChange>>> changedRows;
+    for (auto &change : m_batchedChanges) {
+        const int itemId = change.first;
+        QModelIndex ix;
+        int parentId = -1;
+        if (isClip(itemId) && getClipTrackId(itemId) != -1) {
+            ix = makeClipIndexFromID(itemId);
+            parentId = getClipTrackId(itemId);
+        } else if (isComposition(itemId) && getCompositionTrackId(itemId) != -1) {
+            ix = makeCompositionIndexFromID(itemId);
+            parentId = getCompositionTrackId(itemId);
+        } else if (isTrack(itemId)) {
+            ix = makeTrackIndexFromID(itemId);
+        }
+        if (!ix.isValid()) {
+            // Item deleted or removed from its track during the batch
+            continue;
+        }
+        std::sort(change.second.roles.begin(), change.second.roles.end());
+        changedRows[parentId].emplace_back(ix.row(), change.second);
+    }
+    m_batchedChanges.clear();
+    // Send one signal per run of consecutive rows sharing the same roles
+    for (auto &track : changedRows) {
+        const QModelIndex parent = track.first == -1 ? QModelIndex() : makeTrackIndexFromID(track.first);
+        auto &changes = track.second;
+        std::sort(changes.begin(), changes.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+        size_t first = 0;
+        for (size_t i = 1; i <= changes.size(); ++i) {
+            if (i < changes.size() && changes[i].first == changes[i - 1].first + 1 && changes[i].second.allRoles == changes[first].second.allRoles &&
+                changes[i].second.roles == changes[first].second.roles) {
+                continue;
+            }
+            Q_EMIT dataChanged(index(changes[first].first, 0, parent), index(changes[i - 1].first, 0, parent), changes[first].second.roles);
+            first = i;
+        }
+    }
+}
+
+int TimelineItemModel::dataChangedCount() const
+{
+    return m_dataChangedCount;
+}
+
 void TimelineItemModel::passSequenceProperties(const QMap<QString, QString> baseProperties)
 {
     QMapIterator<QString, QString> i(baseProperties);
@@ -103,11 +103,33 @@ public:
     void _endRemoveRows() override;
     void _endInsertRows() override;
     void _resetView() override;
+    void beginChangeBatch() override;
+    void endChangeBatch() override;
+    /** @brief Returns the number of dataChanged signals emitted by this model, used by tests to check the notification volume */
+    int dataChangedCount() const;
 
 protected:
     /** @brief This is an helper function that finishes a construction of a freshly created TimelineItemModel */
     static void finishConstruct(const std::shared_ptr<TimelineItemModel> &ptr);
 
+private:
+    /** @brief Nesting level of beginChangeBatch() calls */
+    int m_changeBatches{0};
+    struct BatchedChange
+    {
+        /** @brief True if a notification did not specify its roles, all roles must then be announced */
+        bool allRoles{false};
+        QVector<int> roles;
+    };
+    /** @brief Changes notified during the current batch, by item id */
+    std::unordered_map<int, BatchedChange> m_batchedChanges;
+    /** @brief Zone invalidated during the current batch */
+    QPair<int, int> m_batchedZone{-1, -1};
+    QMetaObject::Connection m_batchedZoneConnection;
+    int m_dataChangedCount{0};
+    /** @brief Record a change to the given index and roles if a batch is running, returns false if it must be sent immediately */
+    bool batchChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles);
+
 Q_SIGNALS:
     /** @brief Triggered when a video track visibility changed */
     void trackVisibilityChanged();
@@ -23,6 +23,7 @@
 #include "snapmodel.hpp"
 #include "timeline2/view/previewmanager.h"
 #include "timelinefunctions.hpp"
+#include "utils/decoderpool.h"
 
 #include "monitor/monitormanager.h"
 
@@ -30,7 +31,6 @@
 #include <QCryptographicHash>
 #include <QDebug>
 #include <QModelIndex>
-#include <QThread>
 #include <mlt++/MltConsumer.h>
 #include <mlt++/MltField.h>
 #include <mlt++/MltProfile.h>
@@ -177,9 +177,21 @@ void TimelineModel::prepareClose(bool softDelete)
     // m_subtitleModel->removeAllSubtitles();
 }
 
+TimelineChangeBatch::TimelineChangeBatch(TimelineModel *model)
+    : m_model(model)
+{
+    m_model->beginChangeBatch();
+}
+
+TimelineChangeBatch::~TimelineChangeBatch()
+{
+    m_model->endChangeBatch();
+}
+
 TimelineModel::~TimelineModel()
 {
     m_closing = true;
+    DecoderPool::removeTimeline(m_uuid);
     if (!m_softDelete) {
         qDebug() << "::::::==\n\nCLOSING TIMELINE MODEL\n\n::::::::";
         QScopedPointer<Mlt::Service> service(m_tractor->field());
@@ -1232,9 +1244,15 @@ bool TimelineModel::requestClipMove(int clipId, int trackId, int position, bool
     }
     std::function<bool(void)> undo = []() { return true; };
     std::function<bool(void)> redo = []() { return true; };
+    // Inserting a clip in the timeline must keep its own undo step
+    bool inTimeline = getClipTrackId(clipId) != -1;
     bool res = requestClipMove(clipId, trackId, position, moveMirrorTracks, updateView, invalidateTimeline, logUndo, undo, redo, revertMove);
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move clip"));
+        if (inTimeline) {
+            PUSH_MERGEABLE_UNDO(undo, redo, i18n("Move clip"), clipId);
+        } else {
+            PUSH_UNDO(undo, redo, i18n("Move clip"));
+        }
     }
     TRACE_RES(res);
     return res;
@@ -1272,7 +1290,7 @@ bool TimelineModel::requestSubtitleMove(int clipId, int position, bool updateVie
     std::function<bool(void)> redo = []() { return true; };
     bool res = requestSubtitleMove(clipId, position, updateView, logUndo, logUndo, finalMove, undo, redo);
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move subtitle"));
+        PUSH_MERGEABLE_UNDO(undo, redo, i18n("Move subtitle"), clipId);
     }
     return res;
 }
@@ -2162,6 +2180,21 @@ bool TimelineModel::requestCompositionDeletion(int compositionId, Fun &undo, Fun
     return false;
 }
 
+std::vector<int> TimelineModel::getCutPositions() const
+{
+    READ_LOCK();
+    std::set<int> cuts;
+    for (const auto &clip : m_allClips) {
+        if (clip.second->getCurrentTrackId() == -1) {
+            continue;
+        }
+        int position = clip.second->getPosition();
+        cuts.insert(position);
+        cuts.insert(position + clip.second->getPlaytime());
+    }
+    return std::vector<int>(cuts.begin(), cuts.end());
+}
+
 std::unordered_set<int> TimelineModel::getItemsInRange(int trackId, int start, int end, bool listCompositions)
 {
     Q_UNUSED(listCompositions)
@@ -2372,6 +2405,8 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
                                      bool revertMove, bool moveMirrorTracks, bool allowViewRefresh, const QVector<int> &allowedTracks)
 {
     QWriteLocker locker(&m_lock);
+    // Each moved item sends several notifications, announce them at once when done
+    TimelineChangeBatch batch(this);
     Q_ASSERT(m_allGroups.count(groupId) > 0);
     Q_ASSERT(isItem(itemId));
     if (getGroupElements(groupId).count(itemId) == 0) {
@@ -2799,7 +2834,15 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
     update_model();
     PUSH_LAMBDA(update_model, local_redo);
     PUSH_LAMBDA(update_model, local_undo);
-    UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
+    Fun batched_undo = [this, local_undo]() {
+        TimelineChangeBatch undoBatch(this);
+        return local_undo();
+    };
+    Fun batched_redo = [this, local_redo]() {
+        TimelineChangeBatch redoBatch(this);
+        return local_redo();
+    };
+    UPDATE_UNDO_REDO(batched_redo, batched_undo, undo, redo);
     return true;
 }
 
@@ -4466,8 +4509,7 @@ void TimelineModel::registerTrack(std::shared_ptr<TrackModel> track, int pos, bo
     Q_ASSERT(m_iteratorTable.count(id) == 0); // check that id is not used (shouldn't happen)
     m_iteratorTable[id] = it;
     endInsertRows();
-    int cache = int(QThread::idealThreadCount()) + int(m_allTracks.size() + 1) * 2;
-    mlt_service_cache_set_size(nullptr, "producer_avformat", qMax(4, cache));
+    DecoderPool::setTimelineTracks(m_uuid, int(m_allTracks.size()));
 }
 
 void TimelineModel::registerClip(const std::shared_ptr<ClipModel> &clip, bool registerProducer)
@@ -4533,8 +4575,7 @@ Fun TimelineModel::deregisterTrack_lambda(int id)
         if (!m_closing) {
             // Finish operation
             endRemoveRows();
-            int cache = int(QThread::idealThreadCount()) + int(m_allTracks.size() + 1) * 2;
-            mlt_service_cache_set_size(nullptr, "producer_avformat", qMax(4, cache));
+            DecoderPool::setTimelineTracks(m_uuid, int(m_allTracks.size()));
         }
         return true;
     };
@@ -5155,7 +5196,11 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int positio
     }
 
     if (res && logUndo) {
-        PUSH_UNDO(undo, redo, i18n("Move composition"));
+        if (tk > -1) {
+            PUSH_MERGEABLE_UNDO(undo, redo, i18n("Move composition"), compoId);
+        } else {
+            PUSH_UNDO(undo, redo, i18n("Move composition"));
+        }
         checkRefresh(min, max);
     }
     return res;
@@ -5273,79 +5318,59 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int composi
 
 bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
 {
-    // We ensure that the compositions are planted in a decreasing order of a_track, and increasing order of b_track.
-    // For that, there is no better option than to disconnect every composition and then reinsert everything in the correct order.
-    std::vector<std::pair<int, int>> compos;
-    for (const auto &compo : m_allCompositions) {
-        int trackId = compo.second->getCurrentTrackId();
-        if (trackId == -1 || compo.second->getATrack() == -1) {
-            continue;
-        }
-        // Note: we need to retrieve the position of the track, that is its melt index.
-        int trackPos = getTrackMltIndex(trackId);
-        compos.emplace_back(trackPos, compo.first);
-        if (compo.first != currentCompo) {
-            unplantComposition(compo.first);
-        }
+    int trackId = getCompositionTrackId(currentCompo);
+    int aTrack = m_allCompositions[currentCompo]->getATrack();
+    if (trackId == -1 || aTrack == -1) {
+        return true;
     }
-    // sort by decreasing b_track
-    std::sort(compos.begin(), compos.end(), [&](const std::pair<int, int> &a, const std::pair<int, int> &b) {
-        if (m_allCompositions[a.second]->getATrack() == m_allCompositions[b.second]->getATrack()) {
-            return a.first < b.first;
-        }
-        return m_allCompositions[a.second]->getATrack() > m_allCompositions[b.second]->getATrack();
-    });
-    // replant
+    Q_ASSERT(aTrack < m_tractor->count());
+    Mlt::Transition &transition = *m_allCompositions[currentCompo].get();
+    if (mlt_service_consumer(transition.get_service()) != nullptr) {
+        unplantComposition(currentCompo);
+    }
+    // Note: we need to retrieve the position of the track, that is its melt index.
+    int trackPos = getTrackMltIndex(trackId);
+    transition.set_tracks(aTrack, trackPos);
+
     QScopedPointer<Mlt::Field> field(m_tractor->field());
     field->lock();
-
-    // Unplant track compositing
-    mlt_service nextservice = mlt_service_get_producer(field->get_service());
-    mlt_properties properties = MLT_SERVICE_PROPERTIES(nextservice);
-    QString resource = mlt_properties_get(properties, "mlt_service");
-
-    mlt_service_type mlt_type = mlt_service_identify(nextservice);
-    QList<Mlt::Transition *> trackCompositions;
-    while (mlt_type == mlt_service_transition_type) {
-        Mlt::Transition transition(reinterpret_cast<mlt_transition>(nextservice));
-        nextservice = mlt_service_producer(nextservice);
-        int internal = transition.get_int("internal_added");
-        if (internal > 0 && resource != QLatin1String("mix")) {
-            trackCompositions << new Mlt::Transition(transition);
-            field->disconnect_service(transition);
-            transition.disconnect_all_producers();
-        }
-        if (nextservice == nullptr) {
-            break;
+    // Compositions are planted in a decreasing order of a_track, and increasing order of b_track, below the track compositing.
+    // The field's transition chain is always kept in that order, so it is our index: walking down from the top, we look for the
+    // first composition that has to stay below the new one and only plant the new composition above it.
+    mlt_service top = field->get_service();
+    mlt_service consumer = top;
+    mlt_service nextservice = mlt_service_get_producer(top);
+    while (nextservice != nullptr && mlt_service_identify(nextservice) == mlt_service_transition_type) {
+        auto tr = mlt_transition(nextservice);
+        int currentTrack = mlt_transition_get_b_track(tr);
+        int currentATrack = mlt_transition_get_a_track(tr);
+        // Skip track compositing and invalid transitions created by MLT on track deletion
+        if (mlt_properties_get_int(MLT_TRANSITION_PROPERTIES(tr), "internal_added") == 0 && currentTrack != currentATrack) {
+            if (currentATrack > aTrack || (currentATrack == aTrack && currentTrack <= trackPos)) {
+                break;
+            }
         }
-        mlt_type = mlt_service_identify(nextservice);
-        properties = MLT_SERVICE_PROPERTIES(nextservice);
-        resource = mlt_properties_get(properties, "mlt_service");
+        consumer = nextservice;
+        nextservice = mlt_service_producer(nextservice);
     }
-    // Sort track compositing
-    std::sort(trackCompositions.begin(), trackCompositions.end(), [](Mlt::Transition *a, Mlt::Transition *b) { return a->get_b_track() < b->get_b_track(); });
-
-    for (const auto &compo : compos) {
-        int aTrack = m_allCompositions[compo.second]->getATrack();
-        Q_ASSERT(aTrack != -1 && aTrack < m_tractor->count());
-
-        Mlt::Transition &transition = *m_allCompositions[compo.second].get();
-        transition.set_tracks(aTrack, compo.first);
-        int ret = field->plant_transition(transition, aTrack, compo.first);
-
-        mlt_service consumer = mlt_service_consumer(transition.get_service());
-        Q_ASSERT(consumer != nullptr);
-        if (ret != 0) {
-            field->unlock();
-            return false;
+    int ret = 0;
+    if (consumer == top || nextservice == nullptr) {
+        // The composition goes above all others
+        ret = field->plant_transition(transition, aTrack, trackPos);
+    } else {
+        // Insert the composition between the two services, the same way MLT relinks them when removing a service from the field
+        ret = mlt_transition_connect(transition.get_transition(), nextservice, aTrack, trackPos);
+        if (ret == 0) {
+            mlt_service_connect_producer(consumer, transition.get_service(), mlt_transition_get_a_track(mlt_transition(consumer)));
+            mlt_transition(consumer)->producer = transition.get_service();
+            field->fire_event("service-changed");
         }
     }
-    // Replant last tracks compositing
-    while (!trackCompositions.isEmpty()) {
-        Mlt::Transition *firstTr = trackCompositions.takeFirst();
-        field->plant_transition(*firstTr, firstTr->get_a_track(), firstTr->get_b_track());
-    }
+    Q_ASSERT(mlt_service_consumer(transition.get_service()) != nullptr);
     field->unlock();
+    if (ret != 0) {
+        return false;
+    }
     if (updateView) {
         QModelIndex modelIndex = makeCompositionIndexFromID(currentCompo);
         notifyChange(modelIndex, modelIndex, ItemATrack);
@@ -5603,6 +5628,9 @@ const QString TimelineModel::sceneList(const QString &root, const QString &fullP
     // Disabling meta creates cleaner files, but then we don't have access to metadata on the fly (meta channels, etc)
     // And we must use "avformat" instead of "avformat-novalidate" on project loading which causes a big delay on project opening
     // xmlConsumer.set("no_meta", 1);
+    // Preview chunks rendered in memory cannot be reloaded, keep them out of the xml
+    const QMap<int, std::shared_ptr<Mlt::Producer>> ramChunks =
+        m_timelinePreview ? m_timelinePreview->takeRamChunks() : QMap<int, std::shared_ptr<Mlt::Producer>>();
     Mlt::Service s(m_tractor->get_service());
     std::unique_ptr<Mlt::Filter> filter = nullptr;
     if (!filterData.isEmpty()) {
@@ -5616,12 +5644,16 @@ const QString TimelineModel::sceneList(const QString &root, const QString &fullP
     if (filter) {
         s.detach(*filter.get());
     }
+    if (m_timelinePreview) {
+        m_timelinePreview->restoreRamChunks(ramChunks);
+    }
     playlist = fullPath.isEmpty() ? QString::fromUtf8(xmlConsumer.get("kdenlive_playlist")) : fullPath;
     return playlist;
 }
 
 void TimelineModel::checkRefresh(int start, int end)
 {
+    Q_EMIT contentChanged();
     if (m_blockRefresh) {
         return;
     }
@@ -6031,6 +6063,7 @@ bool TimelineModel::requestClearSelection(bool onDeletion)
 {
     QWriteLocker locker(&m_lock);
     TRACE();
+    TimelineChangeBatch batch(this);
     if (m_selectedMix > -1) {
         m_selectedMix = -1;
         Q_EMIT selectedMixChanged(-1, nullptr);
@@ -6160,6 +6193,7 @@ bool TimelineModel::requestSetSelection(const std::unordered_set<int> &ids)
 {
     QWriteLocker locker(&m_lock);
     TRACE(ids);
+    TimelineChangeBatch batch(this);
     requestClearSelection();
     // if the items are in groups, we must retrieve their topmost containing groups
     std::unordered_set<int> roots;
@@ -33,6 +33,24 @@ class ProfileModel;
 class MarkerListModel;
 class MarkerSortModel;
 class PreviewManager;
+class TimelineModel;
+
+/** @class TimelineChangeBatch
+    @brief Scoped batching of the clip and composition changes announced to the view and timeline preview.
+    While an instance lives, the changes notified by the timeline are accumulated; when the outermost instance is destroyed
+    they are sent as merged dataChanged ranges, one per run of consecutive rows sharing the same roles, and the timeline
+    preview is invalidated once for the union of the changed zones. Row insertions and removals are still sent as they happen.
+ */
+class TimelineChangeBatch
+{
+public:
+    explicit TimelineChangeBatch(TimelineModel *model);
+    ~TimelineChangeBatch();
+    Q_DISABLE_COPY(TimelineChangeBatch)
+
+private:
+    TimelineModel *m_model;
+};
 
 /** @brief This class represents a Timeline object, as viewed by the backend.
    In general, the Gui associated with it will send modification queries (such as resize or move), and this class authorize them or not depending on the
@@ -105,6 +123,7 @@ public:
     friend class MarkerListModel;
     friend class TimeRemap;
     friend struct TimelineFunctions;
+    friend class TimelineChangeBatch;
 
     Q_PROPERTY(QString visibleSequenceName MEMBER m_visibleSequenceName NOTIFY visibleSequenceNameChanged)
 
@@ -765,6 +784,9 @@ public:
      */
     std::unordered_set<int> getItemsInRange(int trackId, int start, int end = -1, bool listCompositions = true);
 
+    /** @brief Returns the sorted positions where a timeline clip starts or ends */
+    std::vector<int> getCutPositions() const;
+
     /** @brief Returns a list of all luma files used in the project
      */
     QStringList extractCompositionLumas() const;
@@ -936,8 +958,8 @@ protected:
      */
     static int getNextId();
 
-    /** @brief unplant and the replant all the compositions in the correct order
-       @param currentCompo is the id of a compo that have not yet been planted, if any. Otherwise send -1
+    /** @brief Plant a composition at its place in the field, keeping the compositions in the correct order
+       @param currentCompo is the id of the compo to plant. Only this composition is (re)planted, the others are left in place
      */
     bool replantCompositions(int currentCompo, bool updateView);
 
@@ -963,7 +985,7 @@ public:
     bool checkConsistency(const std::vector<int> &guideSnaps = {});
 
 protected:
-    /** @brief Refresh project monitor if cursor was inside range */
+    /** @brief Notify that the timeline content changed, and refresh project monitor if cursor was inside range */
     void checkRefresh(int start, int end);
 
     bool m_blockRefresh;
@@ -972,6 +994,8 @@ Q_SIGNALS:
     /** @brief signal triggered by clearAssetView */
     void requestClearAssetView(int);
     void requestMonitorRefresh();
+    /** @brief signal triggered whenever the rendered timeline changed, wherever the playhead is */
+    void contentChanged();
     /** @brief signal triggered by track operations */
     void invalidateZone(int in, int out);
     /** @brief signal triggered when a track duration changed (insertion/deletion) */
@@ -1070,4 +1094,8 @@ protected:
     virtual QModelIndex makeCompositionIndexFromID(int) const = 0;
     virtual QModelIndex makeTrackIndexFromID(int) const = 0;
     virtual void _resetView() = 0;
+    /** @brief Start accumulating the changes sent by notifyChange, see TimelineChangeBatch. Calls can be nested */
+    virtual void beginChangeBatch() = 0;
+    /** @brief Send the changes accumulated since the matching beginChangeBatch() call, if it was the outermost */
+    virtual void endChangeBatch() = 0;
 };
@@ -100,6 +100,7 @@ TrackModel::~TrackModel()
         field->unlock();
         m_sameCompositions.clear();
         m_allClips.clear();
+        m_clipPos.clear();
         m_allCompositions.clear();
         m_track->remove_track(1);
         m_track->remove_track(0);
@@ -187,6 +188,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             std::shared_ptr<ClipModel> clip = ptr->getClipPtr(clipId);
             m_allClips[clip->getId()] = clip; // store clip
             // update clip position and track
+            m_clipPos.emplace(position, clipId);
             clip->setPosition(position);
             if (finalMove) {
                 clip->setSubPlaylistIndex(subPlaylist, m_id);
@@ -437,6 +439,7 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
             m_playlists[target_track].consolidate_blanks();
             m_allClips[clipId]->setCurrentTrackId(-1);
             // m_allClips[clipId]->setSubPlaylistIndex(-1);
+            removeClipPosition(clipId, m_allClips[clipId]->getPosition());
             m_allClips.erase(clipId);
             delete prod;
             field->unblock();
@@ -707,7 +710,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
             // The second is parameter is delta - 1 because this function expects an out time, which is basically size - 1
             m_playlists[target_track].insert_blank(blank_index, delta - 1);
             if (!right) {
-                m_allClips[clipId]->setPosition(clip_position + delta);
+                setClipPosition(clipId, clip_position + delta);
                 // Because we inserted blank before, the index of our clip has increased
                 target_clip_mutable++;
             }
@@ -802,7 +805,7 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
                     // m_track->unblock();
                 }
                 if (!right && err == 0) {
-                    m_allClips[clipId]->setPosition(m_playlists[target_track].clip_start(target_clip_mutable));
+                    setClipPosition(clipId, m_playlists[target_track].clip_start(target_clip_mutable));
                 }
                 if (err == 0) {
                     update_snaps(m_allClips[clipId]->getPosition(), m_allClips[clipId]->getPosition() + out - in + 1);
@@ -956,6 +959,62 @@ int TrackModel::getRowfromComposition(int tid) const
     return int(m_allClips.size()) + int(std::distance(m_allCompositions.begin(), m_allCompositions.find(tid)));
 }
 
+void TrackModel::setClipPosition(int clipId, int position)
+{
+    removeClipPosition(clipId, m_allClips[clipId]->getPosition());
+    m_clipPos.emplace(position, clipId);
+    m_allClips[clipId]->setPosition(position);
+}
+
+void TrackModel::removeClipPosition(int clipId, int position)
+{
+    auto range = m_clipPos.equal_range(position);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == clipId) {
+            m_clipPos.erase(it);
+            return;
+        }
+    }
+}
+
+std::vector<int> TrackModel::getRowsInRange(int position, int end) const
+{
+    READ_LOCK();
+    // Items of a track never contain one another (mixed clips only overlap their neighbour), so items sorted by start are also
+    // sorted by end: walk back from the first item starting in the range until an item ends before it
+    auto collect = [position, end](const auto &index, const auto &items) {
+        std::vector<int> ids;
+        auto first = index.lower_bound(position);
+        for (auto it = first; it != index.begin();) {
+            --it;
+            if (it->first + items.at(it->second)->getPlaytime() <= position) {
+                break;
+            }
+            ids.push_back(it->second);
+        }
+        for (auto it = first; it != index.end() && it->first <= end; ++it) {
+            ids.push_back(it->second);
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    };
+    // Rows follow the QAbstractItemModel layout: clips first, then compositions, both sorted by id
+    auto toRows = [](const std::vector<int> &ids, const auto &items, int offset, std::vector<int> &rows) {
+        auto wanted = ids.cbegin();
+        int row = offset;
+        for (auto it = items.cbegin(); it != items.cend() && wanted != ids.cend(); ++it, ++row) {
+            if (it->first == *wanted) {
+                rows.push_back(row);
+                ++wanted;
+            }
+        }
+    };
+    std::vector<int> rows;
+    toRows(collect(m_clipPos, m_allClips), m_allClips, 0, rows);
+    toRows(collect(m_compoPos, m_allCompositions), m_allCompositions, int(m_allClips.size()), rows);
+    return rows;
+}
+
 QVariant TrackModel::getProperty(const QString &name) const
 {
     READ_LOCK();
@@ -1004,6 +1063,12 @@ bool TrackModel::checkConsistency()
         clips.emplace_back(c.second->getPosition(), c.first);
     }
     std::sort(clips.begin(), clips.end());
+    std::vector<std::pair<int, int>> indexedClips(m_clipPos.cbegin(), m_clipPos.cend());
+    std::sort(indexedClips.begin(), indexedClips.end());
+    if (indexedClips != clips) {
+        qDebug() << "ERROR: The clip position index does not match the clips of the track";
+        return false;
+    }
     int last_out = 0;
     for (size_t i = 0; i < clips.size(); ++i) {
         auto cur_clip = m_allClips[clips[i].second];
@@ -1765,7 +1830,7 @@ bool TrackModel::requestRemoveMix(std::pair<int, int> clipIds, Fun &undo, Fun &r
                 /*QModelIndex ix = ptr->makeClipIndexFromID(clipIds.first);
                 Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::DurationRole});*/
                 QModelIndex ix2 = ptr->makeClipIndexFromID(clipIds.second);
-                Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
             }
             return true;
         };
@@ -1809,7 +1874,7 @@ bool TrackModel::requestRemoveMix(std::pair<int, int> clipIds, Fun &undo, Fun &r
                 m_sameCompositions[clipIds.second] = asset;
                 m_mixList.insert(clipIds.first, clipIds.second);
                 QModelIndex ix2 = ptr->makeClipIndexFromID(clipIds.second);
-                Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+                ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
             }
             return true;
         };
@@ -2093,7 +2158,7 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
             std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipIds.second));
             movedClip->setMixDuration(0);
             QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
             QScopedPointer<Mlt::Field> field(m_track->field());
             field->lock();
             field->disconnect_service(transition);
@@ -2126,7 +2191,7 @@ bool TrackModel::requestClipMix(const QString &mixId, std::pair<int, int> clipId
                                            ->requestResize(mixPosition + mixDurations.first + mixDurations.second - firstClipPos, true, local_undo, local_redo,
                                                            true, true);
                     QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-                    Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+                    ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
                 }
             }
             return result;
@@ -2225,7 +2290,7 @@ bool TrackModel::deleteMix(int clipId, bool final, bool notify)
             std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipId));
             movedClip->setMixDuration(final ? 0 : 1);
             QModelIndex ix = ptr->makeClipIndexFromID(clipId);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::StartRole, TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
         if (final) {
             Mlt::Transition &transition = *static_cast<Mlt::Transition *>(m_sameCompositions[clipId]->getAsset());
@@ -2285,7 +2350,7 @@ bool TrackModel::createMix(MixInfo info, std::pair<QString, QVector<QPair<QStrin
         m_mixList.insert(info.firstClipId, info.secondClipId);
         if (finalMove) {
             QModelIndex ix2 = ptr->makeClipIndexFromID(info.secondClipId);
-            Q_EMIT ptr->dataChanged(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix2, ix2, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
         return true;
     }
@@ -2354,7 +2419,7 @@ bool TrackModel::createMix(std::pair<int, int> clipIds, std::pair<int, int> mixD
         std::shared_ptr<ClipModel> movedClip(ptr->getClipPtr(clipIds.second));
         movedClip->setMixDuration(mixData.second);
         QModelIndex ix = ptr->makeClipIndexFromID(clipIds.second);
-        Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+        ptr->notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         bool reverse = movedClip->getSubPlaylistIndex() == 0;
         // Insert mix transition
         QString assetName;
@@ -2471,7 +2536,7 @@ void TrackModel::syncronizeMixes(bool finalMove)
         if (auto ptr = m_parent.lock()) {
             ptr->getClipPtr(secondClipId)->setMixDuration(mixOut - mixIn);
             QModelIndex ix = ptr->makeClipIndexFromID(secondClipId);
-            Q_EMIT ptr->dataChanged(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
+            ptr->notifyChange(ix, ix, {TimelineModel::MixRole, TimelineModel::MixCutRole});
         }
     }
     for (int i : qAsConst(toDelete)) {
@@ -13,8 +13,10 @@
 #include <mlt++/MltPlaylist.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 class TimelineModel;
 class ClipModel;
@@ -264,6 +266,10 @@ protected:
     */
     int getRowfromComposition(int compoId) const;
 
+    /** @brief Returns the sorted rows of the clips and compositions intersecting the range [position, end].
+     *  This is used by the timeline view to only instantiate the visible items, items are looked up in the position indexes */
+    std::vector<int> getRowsInRange(int position, int end) const;
+
     /** @brief This is an helper function that test frame level consistency with the MLT structures */
     bool checkConsistency();
 
@@ -367,6 +373,12 @@ private:
      *  those positions here to check for moves and resize
      */
     std::map<int, int> m_compoPos;
+    /** We store the clips ordered by position, so that the clips intersecting a range can be found without visiting all clips */
+    std::multimap<int, int> m_clipPos;
+    /** @brief Move clip @param clipId to @param position, keeping the position index up to date */
+    void setClipPosition(int clipId, int position);
+    /** @brief Remove clip @param clipId starting at @param position from the position index */
+    void removeClipPosition(int clipId, int position);
 
     /// This is a lock that ensures safety in case of concurrent access
     mutable QReadWriteLock m_lock;
@@ -14,6 +14,7 @@
 #include "mainwindow.h"
 #include "monitor/monitor.h"
 #include "profiles/profilemodel.hpp"
+#include "timeline2/view/rampreviewchunk.h"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
 #include "xml/xml.hpp"
@@ -25,6 +26,7 @@
 #include <QMutexLocker>
 #include <QSaveFile>
 #include <QStandardPaths>
+#include <QtConcurrent>
 
 PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *parent)
     : QObject(parent)
@@ -36,6 +38,9 @@ PreviewManager::PreviewManager(Mlt::Tractor *tractor, QUuid uuid, QObject *paren
     , m_warnOnCrash(true)
     , m_previewTrackIndex(-1)
     , m_initialized(false)
+    , m_ramPreview(false)
+    , m_ramRenderId(0)
+    , m_ramWorkers(0)
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
@@ -214,6 +219,32 @@ const QDir PreviewManager::getCacheDir() const
     return m_cacheDir;
 }
 
+QMap<int, QString> PreviewManager::renderedChunkFiles(int in, int out) const
+{
+    QMap<int, QString> files;
+    if (!m_initialized || m_ramPreview) {
+        return files;
+    }
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    QMutexLocker lock(&m_dirtyMutex);
+    for (const auto &chunk : m_renderedChunks) {
+        int frame = chunk.toInt();
+        if (frame < in || frame + chunkSize - 1 > out || m_dirtyChunks.contains(chunk)) {
+            continue;
+        }
+        const QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(frame).arg(m_extension));
+        if (QFile::exists(fileName)) {
+            files.insert(frame, fileName);
+        }
+    }
+    return files;
+}
+
+const QStringList &PreviewManager::consumerParams() const
+{
+    return m_consumerParams;
+}
+
 void PreviewManager::reconnectTrack()
 {
     disconnectTrack();
@@ -313,6 +344,8 @@ bool PreviewManager::loadParams()
     if (KdenliveSettings::gpu_accel()) {
         m_consumerParams << QStringLiteral("glsl.=1");
     }
+    // GPU accelerated monitors expect textures, which cannot be kept in memory
+    m_ramPreview = KdenliveSettings::ramtimelinepreview() && !KdenliveSettings::gpu_accel();
     return true;
 }
 
@@ -484,12 +517,12 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     }
     if (add) {
         Q_EMIT dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!isRunning() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool isRendering = isRunning();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
@@ -519,6 +552,9 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
+    if (m_ramWorkers > 0) {
+        abortRamRendering();
+    }
     if (m_previewProcess.state() == QProcess::NotRunning) {
         return;
     }
@@ -548,6 +584,11 @@ void PreviewManager::startPreviewRender()
         m_waitingThumbs.clear();
         // clear log
         m_errorLog.clear();
+        if (m_ramPreview) {
+            m_previewTimer.stop();
+            startRamPreviewRender();
+            return;
+        }
         const QString sceneList = m_cacheDir.absoluteFilePath(QStringLiteral("preview.mlt"));
         if (!KdenliveSettings::proxypreview() && pCore->currentDoc()->useProxy()) {
             const QString playlist =
@@ -566,6 +607,188 @@ void PreviewManager::startPreviewRender()
     }
 }
 
+void PreviewManager::startRamPreviewRender()
+{
+    QString playlist;
+    m_tractor->lock();
+    // The preview track contains in memory producers that cannot be serialized
+    disconnectTrack();
+    if (!KdenliveSettings::proxypreview() && pCore->currentDoc()->useProxy()) {
+        playlist = pCore->projectItemModel()->sceneList(m_cacheDir.absolutePath(), QString(), QString(), pCore->currentDoc()->getTimeline(m_uuid)->tractor(), -1);
+        QDomDocument doc;
+        doc.setContent(playlist);
+        KdenliveDoc::useOriginals(doc);
+        playlist = doc.toString();
+    } else {
+        playlist = pCore->currentDoc()->getTimeline(m_uuid)->sceneList(m_cacheDir.absolutePath());
+    }
+    reconnectTrack();
+    m_tractor->unlock();
+    if (playlist.isEmpty()) {
+        return;
+    }
+    QMutexLocker lock(&m_dirtyMutex);
+    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end(), chunkSort);
+    m_ramQueueMutex.lock();
+    m_ramQueue.clear();
+    for (const auto &chunk : qAsConst(m_dirtyChunks)) {
+        m_ramQueue << chunk.toInt();
+    }
+    m_ramQueueMutex.unlock();
+    m_chunksToRender = m_dirtyChunks.count();
+    m_processedChunks = 0;
+    lock.unlock();
+    // Render at the monitor size, which is what will be played
+    Mlt::Profile &monitorProfile = pCore->getMonitorProfile();
+    const QSize frameSize(monitorProfile.width(), monitorProfile.height());
+    const qint64 budget = qint64(KdenliveSettings::ramtimelinepreviewsize()) * 1024 * 1024;
+    const QByteArray scene = playlist.toUtf8();
+    const QByteArray interpolation = KdenliveSettings::mltinterpolation().toUtf8();
+    const int renderId = ++m_ramRenderId;
+    // Each thread loads its own copy of the timeline
+    const int threads = qBound(1, QThread::idealThreadCount() / 2, qMin(4, m_chunksToRender));
+    m_ramRenderThreads.clear();
+    m_ramWorkers = threads;
+    pCore->currentDoc()->previewProgress(0);
+    for (int i = 0; i < threads; ++i) {
+        m_ramRenderThreads << QtConcurrent::run([this, scene, frameSize, budget, interpolation, renderId]() {
+            doRamPreviewRender(scene, frameSize, budget, interpolation, renderId);
+        });
+    }
+}
+
+void PreviewManager::doRamPreviewRender(const QByteArray &scene, QSize frameSize, qint64 budget, const QByteArray &interpolation, int renderId)
+{
+    Mlt::Producer producer(pCore->getProjectProfile(), "xml-string", scene.constData());
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    bool budgetReached = false;
+    bool failed = !producer.is_valid();
+    while (!failed && !m_abortRamRender) {
+        int chunk;
+        m_ramQueueMutex.lock();
+        if (m_ramQueue.isEmpty()) {
+            m_ramQueueMutex.unlock();
+            break;
+        }
+        chunk = m_ramQueue.takeFirst();
+        m_ramQueueMutex.unlock();
+        std::shared_ptr<RamPreviewChunk> ramChunk = RamPreviewChunk::create(frameSize, chunkSize, budget);
+        if (!ramChunk) {
+            budgetReached = true;
+            break;
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, chunk, renderId]() {
+                if (renderId == m_ramRenderId) {
+                    workingPreview = chunk;
+                    Q_EMIT workingPreviewChanged();
+                }
+            },
+            Qt::QueuedConnection);
+        for (int ix = 0; ix < chunkSize && !m_abortRamRender; ix++) {
+            producer.seek(chunk + ix);
+            std::unique_ptr<Mlt::Frame> frame(producer.get_frame());
+            if (!frame || !frame->is_valid()) {
+                failed = true;
+                break;
+            }
+            frame->set("consumer.rescale", interpolation.constData());
+            mlt_image_format format = mlt_image_yuv422;
+            int width = frameSize.width();
+            int height = frameSize.height();
+            const uint8_t *image = frame->get_image(format, width, height);
+            if (image == nullptr || format != mlt_image_yuv422 || width != frameSize.width() || height != frameSize.height()) {
+                failed = true;
+                break;
+            }
+            ramChunk->appendFrame(image);
+        }
+        if (failed || m_abortRamRender) {
+            break;
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, chunk, ramChunk, renderId]() {
+                if (renderId == m_ramRenderId) {
+                    gotRamPreviewRender(chunk, ramChunk);
+                }
+            },
+            Qt::QueuedConnection);
+    }
+    if (budgetReached || failed) {
+        // Stop the other threads too
+        QMutexLocker lock(&m_ramQueueMutex);
+        m_ramQueue.clear();
+    }
+    QMetaObject::invokeMethod(
+        this, [this, renderId, budgetReached, failed]() { ramPreviewWorkerDone(renderId, budgetReached, failed); }, Qt::QueuedConnection);
+}
+
+void PreviewManager::abortRamRendering()
+{
+    m_abortRamRender = true;
+    m_ramQueueMutex.lock();
+    m_ramQueue.clear();
+    m_ramQueueMutex.unlock();
+    for (auto &future : m_ramRenderThreads) {
+        future.waitForFinished();
+    }
+    m_ramRenderThreads.clear();
+    m_abortRamRender = false;
+    // Discard the results still queued by the aborted threads
+    m_ramRenderId++;
+    m_ramWorkers = 0;
+    workingPreview = -1;
+    Q_EMIT workingPreviewChanged();
+    Q_EMIT previewRender(-1, QString(), 1000);
+}
+
+void PreviewManager::gotRamPreviewRender(int frame, const std::shared_ptr<RamPreviewChunk> &chunk)
+{
+    if (m_previewTrack == nullptr || !m_previewTrack->is_blank_at(frame)) {
+        return;
+    }
+    std::unique_ptr<Mlt::Producer> prod = RamPreviewChunk::producer(chunk, pCore->getProjectProfile());
+    if (!prod || !prod->is_valid()) {
+        qCDebug(KDENLIVE_LOG) << "* * * INVALID RAM PREVIEW CHUNK: " << frame;
+        return;
+    }
+    m_dirtyMutex.lock();
+    m_dirtyChunks.removeAll(QVariant(frame));
+    m_dirtyMutex.unlock();
+    m_renderedChunks << frame;
+    Q_EMIT renderedChunksChanged();
+    m_tractor->lock();
+    m_previewTrack->insert_at(frame, prod.get(), 1);
+    m_previewTrack->consolidate_blanks();
+    m_tractor->unlock();
+    m_processedChunks++;
+    pCore->currentDoc()->previewProgress(1000 * m_processedChunks / qMax(1, m_chunksToRender));
+}
+
+void PreviewManager::ramPreviewWorkerDone(int renderId, bool budgetReached, bool failed)
+{
+    if (renderId != m_ramRenderId) {
+        return;
+    }
+    if (failed) {
+        abortRamRendering();
+        Q_EMIT previewRender(0, i18n("Cannot render timeline preview in memory"), -1);
+        return;
+    }
+    if (budgetReached) {
+        pCore->displayMessage(i18n("Timeline preview memory limit reached, some zones were not rendered"), InformationMessage, 500);
+    }
+    if (--m_ramWorkers > 0) {
+        return;
+    }
+    m_ramRenderThreads.clear();
+    workingPreview = -1;
+    Q_EMIT workingPreviewChanged();
+    pCore->currentDoc()->previewProgress(1000);
+}
+
 void PreviewManager::receivedStderr()
 {
     QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'), Qt::SkipEmptyParts);
@@ -675,7 +898,7 @@ void PreviewManager::invalidatePreview(int startFrame, int endFrame)
     int end = endFrame - endFrame % chunkSize;
 
     m_previewGatherTimer.stop();
-    bool previewWasRunning = m_previewProcess.state() == QProcess::Running;
+    bool previewWasRunning = m_previewProcess.state() == QProcess::Running || m_ramWorkers > 0;
     bool alreadyRendered = false;
     bool wasInDirtyZone = false;
     if (!m_renderedChunks.isEmpty()) {
@@ -838,13 +1061,82 @@ void PreviewManager::removeOverlayTrack()
 
 QPair<QStringList, QStringList> PreviewManager::previewChunks()
 {
+    const QList<int> inMemory = ramChunks();
     QMutexLocker lock(&m_dirtyMutex);
-    std::sort(m_renderedChunks.begin(), m_renderedChunks.end(), chunkSort);
-    const QStringList renderedChunks = getCompressedList(m_renderedChunks);
-    std::sort(m_dirtyChunks.begin(), m_dirtyChunks.end(), chunkSort);
-    const QStringList dirtyChunks = getCompressedList(m_dirtyChunks);
+    QVariantList rendered = m_renderedChunks;
+    QVariantList dirty = m_dirtyChunks;
     lock.unlock();
-    return {renderedChunks, dirtyChunks};
+    for (int frame : inMemory) {
+        // In memory chunks are lost on close, they will have to be rendered again
+        rendered.removeAll(QVariant(frame));
+        if (!dirty.contains(QVariant(frame))) {
+            dirty << frame;
+        }
+    }
+    std::sort(rendered.begin(), rendered.end(), chunkSort);
+    std::sort(dirty.begin(), dirty.end(), chunkSort);
+    return {getCompressedList(rendered), getCompressedList(dirty)};
+}
+
+QList<int> PreviewManager::ramChunks() const
+{
+    QList<int> chunks;
+    if (m_previewTrack == nullptr) {
+        return chunks;
+    }
+    m_tractor->lock();
+    for (int i = 0; i < m_previewTrack->count(); i++) {
+        if (m_previewTrack->is_blank(i)) {
+            continue;
+        }
+        std::unique_ptr<Mlt::Producer> clip(m_previewTrack->get_clip(i));
+        if (clip && qstrcmp(clip->parent().get("mlt_service"), "kdenlive_rampreview") == 0) {
+            chunks << m_previewTrack->clip_start(i);
+        }
+    }
+    m_tractor->unlock();
+    return chunks;
+}
+
+QMap<int, std::shared_ptr<Mlt::Producer>> PreviewManager::takeRamChunks()
+{
+    QMap<int, std::shared_ptr<Mlt::Producer>> chunks;
+    if (m_previewTrack == nullptr) {
+        return chunks;
+    }
+    m_tractor->lock();
+    for (int i = m_previewTrack->count() - 1; i >= 0; i--) {
+        if (m_previewTrack->is_blank(i)) {
+            continue;
+        }
+        std::unique_ptr<Mlt::Producer> clip(m_previewTrack->get_clip(i));
+        if (clip && qstrcmp(clip->parent().get("mlt_service"), "kdenlive_rampreview") == 0) {
+            const int frame = m_previewTrack->clip_start(i);
+            chunks.insert(frame, std::shared_ptr<Mlt::Producer>(m_previewTrack->replace_with_blank(i)));
+        }
+    }
+    if (!chunks.isEmpty()) {
+        m_previewTrack->consolidate_blanks();
+    }
+    m_tractor->unlock();
+    return chunks;
+}
+
+void PreviewManager::restoreRamChunks(const QMap<int, std::shared_ptr<Mlt::Producer>> &chunks)
+{
+    if (m_previewTrack == nullptr || chunks.isEmpty()) {
+        return;
+    }
+    m_tractor->lock();
+    QMapIterator<int, std::shared_ptr<Mlt::Producer>> i(chunks);
+    while (i.hasNext()) {
+        i.next();
+        if (m_previewTrack->is_blank_at(i.key())) {
+            m_previewTrack->insert_at(i.key(), i.value().get(), 1);
+        }
+    }
+    m_previewTrack->consolidate_blanks();
+    m_tractor->unlock();
 }
 
 const QStringList PreviewManager::getCompressedList(const QVariantList items) const
@@ -908,5 +1200,5 @@ int PreviewManager::addedTracks() const
 
 bool PreviewManager::isRunning() const
 {
-    return workingPreview >= 0 || m_previewProcess.state() != QProcess::NotRunning;
+    return workingPreview >= 0 || m_ramWorkers > 0 || m_previewProcess.state() != QProcess::NotRunning;
 }
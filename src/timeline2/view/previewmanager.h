@@ -10,11 +10,15 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QMap>
 #include <QMutex>
 #include <QProcess>
 #include <QTimer>
 #include <QUuid>
+#include <atomic>
+#include <memory>
 
+class RamPreviewChunk;
 class TimelineController;
 
 namespace Mlt {
@@ -30,6 +34,8 @@ class Producer;
     This allow us to get a preview with a smooth playback of our project.
     Only the preview zone is rendered. Once defined, a preview zone shows as a red line below
     the timeline ruler. As chunks are rendered, the zone turns to green.
+    In RAM preview mode, chunks are rendered in-process to uncompressed frames kept in memory
+    instead of encoded files, within a configurable memory budget.
  */
 class PreviewManager : public QObject
 {
@@ -70,8 +76,15 @@ public:
     void removeOverlayTrack();
     /** @brief The current preview chunk being processed, -1 if none */
     int workingPreview;
-    /** @brief Returns the list of existing chunks */
+    /** @brief Returns the list of existing chunks, chunks only rendered in memory are listed as dirty since they are not saved */
     QPair<QStringList, QStringList> previewChunks();
+    /** @brief Returns the start frames of the chunks rendered in memory on the preview track */
+    QList<int> ramChunks() const;
+    /** @brief Replace the chunks rendered in memory by blanks so that the preview track can be serialized
+     *  @returns the removed chunks keyed by their start frame, to be passed to restoreRamChunks() */
+    QMap<int, std::shared_ptr<Mlt::Producer>> takeRamChunks();
+    /** @brief Put back the chunks removed by takeRamChunks() */
+    void restoreRamChunks(const QMap<int, std::shared_ptr<Mlt::Producer>> &chunks);
     bool hasOverlayTrack() const;
     bool hasPreviewTrack() const;
     int addedTracks() const;
@@ -79,6 +92,11 @@ public:
     bool hasDefinedRange() const;
     /** @brief Returns true if the render process is still running */
     bool isRunning() const;
+    /** @brief Returns the files of the rendered chunks lying entirely in [in, out], keyed by their first frame.
+     *  Empty in RAM preview mode since chunks only exist in memory */
+    QMap<int, QString> renderedChunkFiles(int in, int out) const;
+    /** @brief Returns the consumer parameters used to encode the chunks */
+    const QStringList &consumerParams() const;
 
 private:
     Mlt::Tractor *m_tractor;
@@ -109,12 +127,34 @@ private:
     int m_processedChunks;
     /** @brief: The render process output, useful in case of failure */
     QString m_errorLog;
+    /** @brief: True if chunks are rendered in memory instead of encoded files */
+    bool m_ramPreview;
+    /** @brief: The threads rendering chunks in memory */
+    QList<QFuture<void>> m_ramRenderThreads;
+    /** @brief: The chunks waiting to be rendered in memory */
+    QList<int> m_ramQueue;
+    QMutex m_ramQueueMutex;
+    std::atomic<bool> m_abortRamRender{false};
+    /** @brief: Id of the current in memory render, results of aborted renders are discarded */
+    int m_ramRenderId;
+    /** @brief: The count of threads still rendering in memory */
+    int m_ramWorkers;
     /** @brief: After an undo/redo, if we have preview history, use it. */
     void reloadChunks(const QVariantList &chunks);
     /** @brief: A chunk failed to render, abort. */
     void corruptedChunk(int workingPreview, const QString &fileName);
     /** @brief: Get a compressed list of chunks, like: "0-500,525,575". */
     const QStringList getCompressedList(const QVariantList items) const;
+    /** @brief: Start rendering the dirty chunks in memory. */
+    void startRamPreviewRender();
+    /** @brief: Render chunks from the in memory queue, run in a worker thread. */
+    void doRamPreviewRender(const QByteArray &scene, QSize frameSize, qint64 budget, const QByteArray &interpolation, int renderId);
+    /** @brief: Stop the threads rendering chunks in memory. */
+    void abortRamRendering();
+    /** @brief: A chunk has been rendered in memory, add it to the preview track. */
+    void gotRamPreviewRender(int frame, const std::shared_ptr<RamPreviewChunk> &chunk);
+    /** @brief: A thread rendering chunks in memory has finished. */
+    void ramPreviewWorkerDone(int renderId, bool budgetReached, bool failed);
 
     /** @brief Compare two chunks for usage by std::sort
      * @returns true if @param c1 is less than @param c2
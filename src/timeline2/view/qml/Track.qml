@@ -29,10 +29,138 @@ Item{
         return type != ProducerType.Composition && type != ProducerType.Track;
     }
 
+    // Frame range for which items currently have a delegate, -1 if none
+    property int viewportStart: -1
+    property int viewportEnd: -1
+
+    function scheduleViewportUpdate(force) {
+        if (force) {
+            viewportTimer.force = true
+        }
+        if (!viewportTimer.running) {
+            viewportTimer.start()
+        }
+    }
+
+    // Only create delegates for the items intersecting the visible part of the timeline, plus one screen on each side
+    function updateViewport(force) {
+        if (trackInternalId < 0) {
+            return
+        }
+        var margin = scrollView.width
+        var trackTop = trackRoot.y + subtitleTrack.height
+        var visible = trackTop + trackRoot.height > scrollView.contentY - scrollView.height && trackTop < scrollView.contentY + 2 * scrollView.height
+        if (!force) {
+            if (!visible && viewportEnd < 0) {
+                return
+            }
+            if (visible && viewportEnd >= 0 && scrollView.contentX / root.timeScale >= viewportStart && (scrollView.contentX + scrollView.width) / root.timeScale <= viewportEnd) {
+                // Visible part still covered by the existing delegates
+                return
+            }
+        }
+        var start = 0
+        var end = -1
+        if (visible) {
+            start = Math.max(0, Math.floor((scrollView.contentX - margin) / root.timeScale))
+            end = Math.ceil((scrollView.contentX + scrollView.width + margin) / root.timeScale)
+        }
+        var rows = timeline.visibleItemRows(trackInternalId, start, end, dragProxy.draggedItem)
+        var wanted = {}
+        for (var i = 0; i < rows.length; i++) {
+            wanted[rows[i]] = true
+        }
+        // Only visit the items leaving or entering the viewport, group membership follows the items when rows move
+        var leaving = []
+        for (var j = 0; j < viewportGroup.count; j++) {
+            var index = viewportGroup.get(j).itemsIndex
+            if (!wanted[index]) {
+                leaving.push(index)
+            }
+        }
+        for (var k = 0; k < leaving.length; k++) {
+            trackModel.items.get(leaving[k]).inViewport = false
+        }
+        for (var r = 0; r < rows.length; r++) {
+            if (rows[r] < trackModel.items.count) {
+                var entry = trackModel.items.get(rows[r])
+                if (!entry.inViewport) {
+                    entry.inViewport = true
+                }
+            }
+        }
+        viewportStart = start
+        viewportEnd = end
+    }
+
     width: clipRow.width
 
+    Timer {
+        id: viewportTimer
+        interval: 40
+        property bool force: false
+        onTriggered: {
+            var forced = force
+            force = false
+            trackRoot.updateViewport(forced)
+        }
+    }
+
+    Connections {
+        target: scrollView
+        function onContentXChanged() { trackRoot.scheduleViewportUpdate(false) }
+        function onContentYChanged() { trackRoot.scheduleViewportUpdate(false) }
+        function onWidthChanged() { trackRoot.scheduleViewportUpdate(true) }
+        function onHeightChanged() { trackRoot.scheduleViewportUpdate(false) }
+    }
+
+    Connections {
+        target: root
+        function onTimeScaleChanged() { trackRoot.scheduleViewportUpdate(true) }
+    }
+
+    function isTrackChange(parent) {
+        // Changes to the track list also shift our rows
+        return !parent.valid || parent.row === trackRoot.rootIndex.row
+    }
+
+    Connections {
+        // Items were added, removed or moved, row numbers and positions may have changed
+        target: trackModel.model
+        function onRowsInserted(parent) {
+            if (trackRoot.isTrackChange(parent)) {
+                trackRoot.scheduleViewportUpdate(true)
+            }
+        }
+        function onRowsRemoved(parent) {
+            if (trackRoot.isTrackChange(parent)) {
+                trackRoot.scheduleViewportUpdate(true)
+            }
+        }
+        function onDataChanged(topLeft) {
+            if (topLeft.parent.valid && topLeft.parent.row === trackRoot.rootIndex.row) {
+                trackRoot.scheduleViewportUpdate(true)
+            }
+        }
+        function onModelReset() { trackRoot.scheduleViewportUpdate(true) }
+        function onLayoutChanged() { trackRoot.scheduleViewportUpdate(true) }
+    }
+
+    onYChanged: scheduleViewportUpdate(false)
+    onHeightChanged: scheduleViewportUpdate(false)
+    onTrackInternalIdChanged: scheduleViewportUpdate(true)
+    // A new root index resets the delegate model, including the viewport group
+    onRootIndexChanged: scheduleViewportUpdate(true)
+    Component.onCompleted: scheduleViewportUpdate(true)
+
     DelegateModel {
         id: trackModel
+        groups: DelegateModelGroup {
+            id: viewportGroup
+            name: "viewport"
+            includeByDefault: false
+        }
+        filterOnGroup: "viewport"
         delegate: Item {
             property var itemModel : model
             property bool clipItem: isClip(model.clipType)
@@ -8,6 +8,7 @@
 #include "bin/projectitemmodel.h"
 #include "capture/mediacapture.h"
 #include "core.h"
+#include "jobs/audiolevelstask.h"
 #include "kdenlivesettings.h"
 #include <QElapsedTimer>
 #include <QPainter>
@@ -75,6 +76,7 @@ class TimelineWaveform : public QQuickPaintedItem
     Q_PROPERTY(QColor fillColor1 MEMBER m_color NOTIFY propertyChanged)
     Q_PROPERTY(QColor fillColor2 MEMBER m_color2 NOTIFY propertyChanged)
     Q_PROPERTY(int waveInPoint MEMBER m_inPoint NOTIFY propertyChanged)
+    Q_PROPERTY(double wavePosition MEMBER m_position NOTIFY propertyChanged)
     Q_PROPERTY(int channels MEMBER m_channels NOTIFY propertyChanged)
     Q_PROPERTY(int ix MEMBER m_index)
     Q_PROPERTY(QString binId MEMBER m_binId NOTIFY levelsChanged)
@@ -93,8 +95,11 @@ public:
     TimelineWaveform(QQuickItem *parent = nullptr)
         : QQuickPaintedItem(parent)
         , m_repaint(false)
+        , m_position(0.)
         , m_speed(1.)
         , m_opaquePaint(false)
+        , m_peaksFirst(0)
+        , m_peaksInvalid(false)
     {
         setAntialiasing(false);
         setOpaquePainting(m_opaquePaint);
@@ -104,6 +109,10 @@ public:
         // setMipmap(true);
         // setTextureSize(QSize(1, 1));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
+            m_peaksPath.clear();
+            m_peaksHeader = AudioLevelsTask::PeaksHeader();
+            m_peaks.clear();
+            m_peaksInvalid = false;
             if (!m_binId.isEmpty()) {
                 if (m_audioLevels.isEmpty() && m_stream >= 0) {
                     update();
@@ -146,6 +155,21 @@ public:
         int h = int(height());
         double offset = 0;
         bool pathDraw = increment > 1.2;
+        bool reverse = m_speed < 0;
+        const QVector<uint8_t> *levels = &m_audioLevels;
+        int maxLength = m_audioLevels.length();
+        if (reverse) {
+            m_inPoint = qMin(m_inPoint, maxLength - m_channels);
+        }
+        int startPos = int(m_inPoint / indicesPrPixel);
+        if (!reverse && m_scale / m_speed > 1. && loadPixelLevels()) {
+            // Zoomed past one frame per pixel, draw one value per pixel from the peaks instead of stretching the frame levels
+            levels = &m_pixelLevels;
+            maxLength = m_pixelLevels.length();
+            increment = 1.;
+            indicesPrPixel = m_channels;
+            startPos = 0;
+        }
         if (increment > 1. && !pathDraw) {
             pen.setWidth(int(ceil(increment)));
             offset = pen.width() / 2.;
@@ -163,12 +187,6 @@ public:
         if (m_audioMax > 1) {
             scaleFactor = m_audioMax;
         }
-        bool reverse = m_speed < 0;
-        int maxLength = m_audioLevels.length();
-        if (reverse) {
-            m_inPoint = qMin(m_inPoint, maxLength - m_channels);
-        }
-        int startPos = int(m_inPoint / indicesPrPixel);
         if (!KdenliveSettings::displayallchannels()) {
             // Draw merged channels
             double i = 0;
@@ -192,9 +210,9 @@ public:
                 if (idx + m_channels >= maxLength || idx < 0) {
                     break;
                 }
-                level = m_audioLevels.at(idx) / scaleFactor;
+                level = levels->at(idx) / scaleFactor;
                 for (int k = 1; k < m_channels; k++) {
-                    level = qMax(level, m_audioLevels.at(idx + k) / scaleFactor);
+                    level = qMax(level, levels->at(idx + k) / scaleFactor);
                 }
                 if (pathDraw) {
                     double val = height() - level * height();
@@ -253,10 +271,10 @@ public:
                     idx += channel;
                     if (idx >= maxLength || idx < 0) break;
                     if (pathDraw) {
-                        level = m_audioLevels.at(idx) * scaleFactor;
+                        level = levels->at(idx) * scaleFactor;
                         path.lineTo(i, y - level);
                     } else {
-                        level = m_audioLevels.at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
+                        level = levels->at(idx) * scaleFactor; // divide height by 510 (2*255) to get height
                         painter->drawLine(int(i), int(y - level), int(i), int(y + level));
                     }
                 }
@@ -282,6 +300,66 @@ Q_SIGNALS:
     void audioChannelsChanged();
 
 private:
+    /** @brief Fill m_pixelLevels with the peak level of each pixel of this chunk, reading from the peaks file only the visible range.
+        Returns false if the peaks are not available */
+    bool loadPixelLevels()
+    {
+        if (m_peaksInvalid) {
+            return false;
+        }
+        if (m_peaksPath.isEmpty()) {
+            // Empty while the peaks are created, the clip remembers missing files
+            m_peaksPath = pCore->projectItemModel()->getAudioPeaksPathByBinID(m_binId, m_stream);
+            if (m_peaksPath.isEmpty()) {
+                return false;
+            }
+        }
+        const double fps = pCore->getCurrentFps();
+        if (m_peaksHeader.count == 0 && !AudioLevelsTask::readPeaks(m_peaksPath, 0, 0, m_peaksHeader, m_peaks)) {
+            // Don't open the file again on each paint
+            m_peaksInvalid = true;
+            return false;
+        }
+        if (m_peaksHeader.channels != m_channels || fps <= 0) {
+            return false;
+        }
+        const double samplesPerPixel = m_peaksHeader.frequency / fps * m_speed / m_scale;
+        const double firstSample = m_position * m_peaksHeader.frequency / fps;
+        const int pixels = int(ceil(width())) + 2;
+        const qint64 first = qMax(qint64(0), qint64(firstSample / m_peaksHeader.samplesPerPeak));
+        const qint64 last = qMin(m_peaksHeader.count, qint64(ceil((firstSample + pixels * samplesPerPixel) / m_peaksHeader.samplesPerPeak)) + 1);
+        if (last <= first) {
+            return false;
+        }
+        if (first < m_peaksFirst || last > m_peaksFirst + m_peaks.length() / m_channels) {
+            if (!AudioLevelsTask::readPeaks(m_peaksPath, first, int(last - first), m_peaksHeader, m_peaks)) {
+                m_peaksHeader = AudioLevelsTask::PeaksHeader();
+                m_peaksInvalid = true;
+                return false;
+            }
+            m_peaksFirst = first;
+        }
+        const qint64 available = m_peaks.length() / m_channels;
+        m_pixelLevels.resize(pixels * m_channels);
+        int pixel = 0;
+        for (; pixel < pixels; pixel++) {
+            const qint64 start = qint64((firstSample + pixel * samplesPerPixel) / m_peaksHeader.samplesPerPeak) - m_peaksFirst;
+            const qint64 end = qMax(start + 1, qint64(ceil((firstSample + (pixel + 1) * samplesPerPixel) / m_peaksHeader.samplesPerPeak)) - m_peaksFirst);
+            if (start < 0 || start >= available) {
+                break;
+            }
+            for (int channel = 0; channel < m_channels; channel++) {
+                uint8_t level = 0;
+                for (qint64 peak = start; peak < qMin(end, available); peak++) {
+                    level = qMax(level, m_peaks.at(int(peak * m_channels + channel)));
+                }
+                m_pixelLevels[pixel * m_channels + channel] = level;
+            }
+        }
+        m_pixelLevels.resize(pixel * m_channels);
+        return pixel > 0;
+    }
+
     QVector<uint8_t> m_audioLevels;
     int m_inPoint;
     int m_outPoint;
@@ -295,12 +373,22 @@ private:
     int m_channels;
     int m_precisionFactor;
     int m_stream;
+    /** @brief Source frame displayed at the left of this chunk */
+    double m_position;
     double m_scale;
     double m_speed;
     double m_audioMax;
     bool m_firstChunk;
     bool m_opaquePaint;
     int m_index;
+    QString m_peaksPath;
+    AudioLevelsTask::PeaksHeader m_peaksHeader;
+    /** @brief Peaks read from the file, starting at peak m_peaksFirst */
+    QVector<uint8_t> m_peaks;
+    qint64 m_peaksFirst;
+    /** @brief The peaks file could not be read, use the frame levels until the clip changes */
+    bool m_peaksInvalid;
+    QVector<uint8_t> m_pixelLevels;
 };
 
 class TimelineRecWaveform : public QQuickPaintedItem
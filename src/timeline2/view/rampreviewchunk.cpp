@@ -0,0 +1,153 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "rampreviewchunk.h"
+
+#include <atomic>
+#include <cstring>
+#include <mlt++/Mlt.h>
+
+namespace {
+std::atomic<qint64> usedRamPreviewMemory{0};
+
+using ChunkRef = std::shared_ptr<const RamPreviewChunk>;
+
+void deleteChunkRef(void *ref)
+{
+    delete static_cast<ChunkRef *>(ref);
+}
+
+int ramChunkGetImage(mlt_frame frame, uint8_t **buffer, mlt_image_format *format, int *width, int *height, int /*writable*/)
+{
+    mlt_properties properties = MLT_FRAME_PROPERTIES(frame);
+    auto *ref = static_cast<ChunkRef *>(mlt_properties_get_data(properties, "kdenlive:rampreview", nullptr));
+    if (ref == nullptr) {
+        return 1;
+    }
+    const RamPreviewChunk *chunk = ref->get();
+    const QByteArray &data = chunk->frame(mlt_properties_get_int(properties, "kdenlive:rampreview.index"));
+    // Frames are shared by all playbacks of the chunk, give MLT its own copy
+    auto *image = static_cast<uint8_t *>(mlt_pool_alloc(data.size()));
+    memcpy(image, data.constData(), size_t(data.size()));
+    mlt_frame_set_image(frame, image, data.size(), mlt_pool_release);
+    *buffer = image;
+    *format = mlt_image_yuv422;
+    *width = chunk->size().width();
+    *height = chunk->size().height();
+    mlt_properties_set_int(properties, "format", *format);
+    mlt_properties_set_int(properties, "width", *width);
+    mlt_properties_set_int(properties, "height", *height);
+    return 0;
+}
+
+int ramChunkGetFrame(mlt_producer producer, mlt_frame_ptr frame, int /*index*/)
+{
+    mlt_properties properties = MLT_PRODUCER_PROPERTIES(producer);
+    auto *ref = static_cast<ChunkRef *>(mlt_properties_get_data(properties, "kdenlive:rampreview", nullptr));
+    *frame = mlt_frame_init(MLT_PRODUCER_SERVICE(producer));
+    if (*frame == nullptr || ref == nullptr) {
+        return 1;
+    }
+    mlt_properties frameProperties = MLT_FRAME_PROPERTIES(*frame);
+    mlt_frame_set_position(*frame, mlt_producer_position(producer));
+    const int index = qBound(0, int(mlt_producer_frame(producer)), (*ref)->count() - 1);
+    mlt_properties_set_int(frameProperties, "kdenlive:rampreview.index", index);
+    mlt_properties_set_data(frameProperties, "kdenlive:rampreview", new ChunkRef(*ref), 0, deleteChunkRef, nullptr);
+    mlt_properties_set_int(frameProperties, "progressive", 1);
+    mlt_properties_set_int(frameProperties, "meta.media.width", (*ref)->size().width());
+    mlt_properties_set_int(frameProperties, "meta.media.height", (*ref)->size().height());
+    mlt_properties_set_double(frameProperties, "aspect_ratio", mlt_profile_sar(mlt_service_profile(MLT_PRODUCER_SERVICE(producer))));
+    mlt_frame_push_get_image(*frame, ramChunkGetImage);
+    mlt_producer_prepare_next(producer);
+    return 0;
+}
+
+/** @brief Attach the first available filter from @param services, used to convert and scale our frames on request */
+void attachNormalizer(Mlt::Producer &producer, Mlt::Profile &profile, const QVector<const char *> &services)
+{
+    for (const char *service : services) {
+        Mlt::Filter filter(profile, service);
+        if (filter.is_valid()) {
+            filter.set("_loader", 1);
+            producer.attach(filter);
+            return;
+        }
+    }
+}
+} // namespace
+
+std::shared_ptr<RamPreviewChunk> RamPreviewChunk::create(QSize size, int frames, qint64 budget)
+{
+    const qint64 reserved = qint64(size.width()) * size.height() * 2 * frames;
+    qint64 used = usedRamPreviewMemory.load();
+    do {
+        if (used + reserved > budget) {
+            return nullptr;
+        }
+    } while (!usedRamPreviewMemory.compare_exchange_weak(used, used + reserved));
+    return std::shared_ptr<RamPreviewChunk>(new RamPreviewChunk(size, reserved));
+}
+
+qint64 RamPreviewChunk::usedMemory()
+{
+    return usedRamPreviewMemory.load();
+}
+
+RamPreviewChunk::RamPreviewChunk(QSize size, qint64 reserved)
+    : m_size(size)
+    , m_reserved(reserved)
+{
+}
+
+RamPreviewChunk::~RamPreviewChunk()
+{
+    usedRamPreviewMemory -= m_reserved;
+}
+
+void RamPreviewChunk::appendFrame(const uint8_t *image)
+{
+    m_frames.append(QByteArray(reinterpret_cast<const char *>(image), m_size.width() * m_size.height() * 2));
+}
+
+int RamPreviewChunk::count() const
+{
+    return m_frames.count();
+}
+
+QSize RamPreviewChunk::size() const
+{
+    return m_size;
+}
+
+const QByteArray &RamPreviewChunk::frame(int ix) const
+{
+    return m_frames.at(ix);
+}
+
+std::unique_ptr<Mlt::Producer> RamPreviewChunk::producer(const std::shared_ptr<const RamPreviewChunk> &chunk, Mlt::Profile &profile)
+{
+    if (!chunk || chunk->count() == 0) {
+        return nullptr;
+    }
+    mlt_producer ramProducer = mlt_producer_new(profile.get_profile());
+    if (ramProducer == nullptr) {
+        return nullptr;
+    }
+    ramProducer->get_frame = ramChunkGetFrame;
+    mlt_properties properties = MLT_PRODUCER_PROPERTIES(ramProducer);
+    mlt_properties_set(properties, "mlt_service", "kdenlive_rampreview");
+    mlt_properties_set_position(properties, "length", chunk->count());
+    mlt_properties_set_position(properties, "out", chunk->count() - 1);
+    mlt_properties_set_data(properties, "kdenlive:rampreview", new ChunkRef(chunk), 0, deleteChunkRef, nullptr);
+    auto prod = std::make_unique<Mlt::Producer>(ramProducer);
+    mlt_producer_close(ramProducer);
+    // Frames are stored at the monitor size, let MLT convert them if the consumer requests something else
+    attachNormalizer(*prod, profile, {"avcolor_space", "imageconvert"});
+    attachNormalizer(*prod, profile, {"swscale", "rescale"});
+    attachNormalizer(*prod, profile, {"resize"});
+    return prod;
+}
@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QSize>
+#include <QVector>
+#include <memory>
+
+namespace Mlt {
+class Producer;
+class Profile;
+} // namespace Mlt
+
+/** @class RamPreviewChunk
+    @brief A timeline preview chunk rendered to uncompressed yuv422 frames in memory.
+    The memory of all chunks is accounted globally so that the RAM preview stays within its budget.
+ */
+class RamPreviewChunk
+{
+public:
+    /** @brief Reserve memory for a chunk of @param frames frames of @param size
+     *  @returns nullptr if the chunk would not fit in @param budget bytes */
+    static std::shared_ptr<RamPreviewChunk> create(QSize size, int frames, qint64 budget);
+    /** @brief Total memory reserved by all existing RAM preview chunks */
+    static qint64 usedMemory();
+    /** @brief Build a producer playing @param chunk, to be inserted in the preview track */
+    static std::unique_ptr<Mlt::Producer> producer(const std::shared_ptr<const RamPreviewChunk> &chunk, Mlt::Profile &profile);
+    ~RamPreviewChunk();
+
+    /** @brief Copy a yuv422 image of the chunk size as next frame */
+    void appendFrame(const uint8_t *image);
+    int count() const;
+    QSize size() const;
+    const QByteArray &frame(int ix) const;
+
+private:
+    RamPreviewChunk(QSize size, qint64 reserved);
+    QSize m_size;
+    qint64 m_reserved;
+    QVector<QByteArray> m_frames;
+};
@@ -56,6 +56,7 @@
 #endif
 #include <QtMath>
 
+#include <algorithm>
 #include <memory>
 #include <unistd.h>
 
@@ -136,6 +137,9 @@ void TimelineController::setModel(std::shared_ptr<TimelineItemModel> model)
     connect(this, &TimelineController::videoTargetChanged, this, &TimelineController::updateVideoTarget);
     connect(this, &TimelineController::audioTargetChanged, this, &TimelineController::updateAudioTarget);
     connect(m_model.get(), &TimelineItemModel::requestMonitorRefresh, [&]() { pCore->refreshProjectMonitorOnce(); });
+    // Cached and prefetched monitor frames are outdated by any change, even away from the playhead
+    connect(m_model.get(), &TimelineModel::contentChanged, this, &TimelineController::invalidateMonitorCache);
+    connect(m_model.get(), &TimelineModel::invalidateZone, this, &TimelineController::invalidateMonitorCache);
     connect(m_model.get(), &TimelineModel::durationUpdated, this, &TimelineController::checkDuration);
     connect(m_model.get(), &TimelineModel::selectionChanged, this, &TimelineController::selectionChanged);
     connect(m_model.get(), &TimelineModel::selectedMixChanged, this, &TimelineController::showMixModel);
@@ -2709,8 +2713,16 @@ void TimelineController::removeTrackClips(int trackId, int frame)
     }
 }
 
+void TimelineController::invalidateMonitorCache()
+{
+    if (m_model->uuid() == pCore->currentTimelineId()) {
+        pCore->invalidateProjectMonitorCache();
+    }
+}
+
 void TimelineController::invalidateItem(int cid)
 {
+    invalidateMonitorCache();
     if (!m_model->hasTimelinePreview() || !m_model->isItem(cid)) {
         return;
     }
@@ -4063,6 +4075,30 @@ int TimelineController::getItemMovingTrack(int itemId) const
     return m_model->m_allCompositions[itemId]->getCurrentTrackId();
 }
 
+QVariantList TimelineController::visibleItemRows(int tid, int start, int end, int keepItemId) const
+{
+    QVariantList result;
+    if (!m_model->isTrack(tid)) {
+        return result;
+    }
+    auto track = m_model->getTrackById_const(tid);
+    std::vector<int> rows = track->getRowsInRange(start, end);
+    int keepRow = -1;
+    if (m_model->isClip(keepItemId) && m_model->getClipTrackId(keepItemId) == tid) {
+        keepRow = track->getRowfromClip(keepItemId);
+    } else if (m_model->isComposition(keepItemId) && m_model->getCompositionTrackId(keepItemId) == tid) {
+        keepRow = track->getRowfromComposition(keepItemId);
+    }
+    if (keepRow > -1 && !std::binary_search(rows.begin(), rows.end(), keepRow)) {
+        rows.insert(std::lower_bound(rows.begin(), rows.end(), keepRow), keepRow);
+    }
+    result.reserve(int(rows.size()));
+    for (int row : rows) {
+        result << row;
+    }
+    return result;
+}
+
 bool TimelineController::endFakeMove(int clipId, int position, bool updateView, bool logUndo, bool invalidateTimeline)
 {
     Q_ASSERT(m_model->m_allClips.count(clipId) > 0);
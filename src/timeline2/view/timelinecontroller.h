@@ -465,6 +465,9 @@ public:
 
     Q_INVOKABLE bool endFakeMove(int clipId, int position, bool updateView, bool logUndo, bool invalidateTimeline);
     Q_INVOKABLE int getItemMovingTrack(int itemId) const;
+    /** @brief Returns the model rows of the items of track @param tid intersecting the frames [start, end].
+     *  The row of @param keepItemId is also returned if it belongs to the track, so that a dragged item is never destroyed */
+    Q_INVOKABLE QVariantList visibleItemRows(int tid, int start, int end, int keepItemId = -1) const;
     bool endFakeGroupMove(int clipId, int groupId, int delta_track, int delta_pos, bool updateView, bool logUndo);
     bool endFakeGroupMove(int clipId, int groupId, int delta_track, int delta_pos, bool updateView, bool finalMove, Fun &undo, Fun &redo);
 
@@ -690,6 +693,8 @@ public Q_SLOTS:
     void addEffectToCurrentClip(const QStringList &effectData);
     /** @brief Dis / enable timeline preview. */
     void disablePreview(bool disable);
+    /** @brief Drop the project monitor cached frames if this timeline is displayed. */
+    void invalidateMonitorCache();
     void invalidateItem(int cid);
     void invalidateTrack(int tid);
     void checkDuration();
@@ -82,6 +82,10 @@ bool TimelineTabs::raiseTimeline(const QUuid &uuid)
     for (int i = 0; i < count(); i++) {
         TimelineWidget *timeline = static_cast<TimelineWidget *>(widget(i));
         if (timeline->getUuid() == uuid) {
+            if (timeline->model() == nullptr) {
+                // The sequence has to be built first
+                return false;
+            }
             if (i != currentIndex()) {
                 setCurrentIndex(i);
             }
@@ -91,6 +95,36 @@ bool TimelineTabs::raiseTimeline(const QUuid &uuid)
     return false;
 }
 
+void TimelineTabs::addPendingTimeline(const QUuid uuid, const QString &tabName)
+{
+    QMutexLocker lk(&m_lock);
+    disconnect(this, &TimelineTabs::currentChanged, this, &TimelineTabs::connectCurrent);
+    // An empty timeline widget, replaced by the real one in addTimeline
+    addTab(new TimelineWidget(uuid, this), tabName);
+    setTabsClosable(count() > 1);
+    connect(this, &TimelineTabs::currentChanged, this, &TimelineTabs::connectCurrent);
+}
+
+void TimelineTabs::unloadTimeline(const QUuid uuid)
+{
+    QMutexLocker lk(&m_lock);
+    for (int i = 0; i < count(); i++) {
+        TimelineWidget *timeline = static_cast<TimelineWidget *>(widget(i));
+        if (timeline->getUuid() != uuid || timeline == m_activeTimeline || timeline->model() == nullptr) {
+            continue;
+        }
+        disconnect(this, &TimelineTabs::currentChanged, this, &TimelineTabs::connectCurrent);
+        insertTab(i, new TimelineWidget(uuid, this), tabText(i));
+        removeTab(i + 1);
+        timeline->blockSignals(true);
+        timeline->setSource(QUrl());
+        timeline->unsetModel();
+        delete timeline;
+        connect(this, &TimelineTabs::currentChanged, this, &TimelineTabs::connectCurrent);
+        break;
+    }
+}
+
 void TimelineTabs::setModified(const QUuid &uuid, bool modified)
 {
     for (int i = 0; i < count(); i++) {
@@ -113,7 +147,20 @@ TimelineWidget *TimelineTabs::addTimeline(const QUuid uuid, const QString &tabNa
     newTimeline->setTimelineMenu(m_timelineClipMenu, m_timelineCompositionMenu, m_timelineMenu, m_guideMenu, m_timelineRulerMenu, m_editGuideAction,
                                  m_headerMenu, m_thumbsMenu, m_timelineSubtitleClipMenu);
     newTimeline->setModel(timelineModel, proxy);
-    int newIndex = addTab(newTimeline, tabName);
+    // A sequence restored without timeline takes the place of its tab
+    int newIndex = -1;
+    for (int i = 0; i < count(); i++) {
+        TimelineWidget *pending = static_cast<TimelineWidget *>(widget(i));
+        if (pending->getUuid() == uuid && pending->model() == nullptr) {
+            newIndex = insertTab(i, newTimeline, tabName);
+            removeTab(i + 1);
+            delete pending;
+            break;
+        }
+    }
+    if (newIndex < 0) {
+        newIndex = addTab(newTimeline, tabName);
+    }
     setCurrentIndex(newIndex);
     connectCurrent(newIndex);
     setTabsClosable(count() > 1);
@@ -126,6 +173,16 @@ TimelineWidget *TimelineTabs::addTimeline(const QUuid uuid, const QString &tabNa
 
 void TimelineTabs::connectCurrent(int ix)
 {
+    if (ix >= 0 && ix < count() && pCore->currentDoc() && !pCore->currentDoc()->closing) {
+        TimelineWidget *timeline = static_cast<TimelineWidget *>(widget(ix));
+        if (timeline->model() == nullptr) {
+            // Build the sequence, the previous timeline stays connected until its tab replaces this one
+            const QUuid uuid = timeline->getUuid();
+            QMetaObject::invokeMethod(
+                pCore->projectManager(), [uuid]() { pCore->projectManager()->openPendingSequence(uuid); }, Qt::QueuedConnection);
+            return;
+        }
+    }
     QUuid previousTab = QUuid();
     if (m_activeTimeline && m_activeTimeline->model()) {
         previousTab = m_activeTimeline->getUuid();
@@ -176,6 +233,13 @@ void TimelineTabs::renameTab(const QUuid &uuid, const QString &name)
 void TimelineTabs::closeTimelineByIndex(int ix)
 {
     TimelineWidget *timeline = static_cast<TimelineWidget *>(widget(ix));
+    if (timeline->model() == nullptr) {
+        // Sequence not built, there is nothing to save
+        removeTab(ix);
+        delete timeline;
+        setTabsClosable(count() > 1);
+        return;
+    }
     if (timeline == m_activeTimeline) {
         Q_EMIT timeline->model()->requestClearAssetView(-1);
         pCore->clearTimeRemap();
@@ -222,7 +286,10 @@ TimelineWidget *TimelineTabs::getCurrentTimeline() const
 void TimelineTabs::closeTimelines()
 {
     for (int i = 0; i < count(); i++) {
-        static_cast<TimelineWidget *>(widget(i))->unsetModel();
+        TimelineWidget *timeline = static_cast<TimelineWidget *>(widget(i));
+        if (timeline->model()) {
+            timeline->unsetModel();
+        }
     }
 }
 
@@ -241,7 +308,9 @@ void TimelineTabs::closeTimelineTab(const QUuid uuid)
                 pCore->window()->disconnectTimeline(timeline);
                 disconnectTimeline(timeline);
             }
-            timeline->unsetModel();
+            if (timeline->model()) {
+                timeline->unsetModel();
+            }
             if (m_activeTimeline == timeline) {
                 m_activeTimeline = nullptr;
             }
@@ -330,7 +399,8 @@ TimelineWidget *TimelineTabs::getTimeline(const QUuid uuid) const
     for (int i = 0; i < count(); i++) {
         TimelineWidget *tl = static_cast<TimelineWidget *>(widget(i));
         if (tl->getUuid() == uuid) {
-            return tl;
+            // Tabs of sequences that are not built have no timeline yet
+            return tl->model() ? tl : nullptr;
         }
     }
     return nullptr;
@@ -40,8 +40,12 @@ public:
 
     /** @brief Returns a pointer to the current timeline */
     TimelineWidget *getCurrentTimeline() const;
-    /** @brief Activate a timeline tab by uuid */
+    /** @brief Activate a timeline tab by uuid. Returns false if there is no tab or its sequence is not built */
     bool raiseTimeline(const QUuid &uuid);
+    /** @brief Add a tab for a sequence that will only be built when the tab is activated */
+    void addPendingTimeline(const QUuid uuid, const QString &tabName);
+    /** @brief Replace the tab of an inactive sequence with a tab building it again on activation */
+    void unloadTimeline(const QUuid uuid);
     void disconnectTimeline(TimelineWidget *timeline);
     /** @brief Do some closing stuff on timelinewidgets */
     void closeTimelines();
@@ -52,7 +56,7 @@ public:
     void setModified(const QUuid &uuid, bool modified);
     /** @brief Returns the uuid list for opened timeline tabs. */
     const QStringList openedSequences();
-    /** @brief Get a timeline tab by uuid. */
+    /** @brief Get a timeline tab by uuid, nullptr if its sequence is not built. */
     TimelineWidget *getTimeline(const QUuid uuid) const;
     /** @brief We display the current tab's name in window title if the tab bar is hidden
      */
@@ -8,12 +8,109 @@
 #include "logger.hpp"
 #endif
 #include <QDebug>
+#include <QDir>
 #include <utility>
-FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
+
+/// Maximum delay between two operations on the same item to merge them in one undo command
+static const int mergeDelay = 1000;
+
+UndoJournal::Entry UndoJournal::write(const QByteArray &data)
+{
+    Entry entry;
+    if (!m_file.isOpen()) {
+        m_file.setFileTemplate(QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-undo-XXXXXX.journal")));
+        if (!m_file.open()) {
+            qWarning() << "Cannot create undo journal" << m_file.fileTemplate();
+            return entry;
+        }
+    }
+    const QByteArray compressed = qCompress(data);
+    const qint64 offset = m_file.size();
+    if (!m_file.seek(offset) || m_file.write(compressed) != compressed.size()) {
+        qWarning() << "Cannot write undo journal" << m_file.fileName();
+        return entry;
+    }
+    entry.offset = offset;
+    entry.size = compressed.size();
+    return entry;
+}
+
+QByteArray UndoJournal::read(const Entry &entry)
+{
+    if (entry.offset < 0 || !m_file.isOpen() || !m_file.seek(entry.offset)) {
+        return QByteArray();
+    }
+    return qUncompress(m_file.read(entry.size));
+}
+
+qint64 UndoJournal::size() const
+{
+    return m_file.isOpen() ? m_file.size() : 0;
+}
+
+AccountedUndoCommand::AccountedUndoCommand(QUndoCommand *parent)
     : QUndoCommand(parent)
+{
+}
+
+qint64 AccountedUndoCommand::memoryCost() const
+{
+    return qint64(sizeof(*this)) + text().size() * qint64(sizeof(QChar));
+}
+
+qint64 AccountedUndoCommand::spill(const std::shared_ptr<UndoJournal> &journal)
+{
+    if (m_journal || !journal) {
+        return 0;
+    }
+    const qint64 cost = memoryCost();
+    const QByteArray state = takeState();
+    if (state.isEmpty()) {
+        return 0;
+    }
+    m_journalEntry = journal->write(state);
+    if (m_journalEntry.offset < 0) {
+        // Keep the command usable if the journal cannot be written
+        restoreState(state);
+        return 0;
+    }
+    m_journal = journal;
+    return qMax(qint64(0), cost - memoryCost());
+}
+
+bool AccountedUndoCommand::isSpilled() const
+{
+    return m_journal != nullptr;
+}
+
+QByteArray AccountedUndoCommand::takeState()
+{
+    return QByteArray();
+}
+
+void AccountedUndoCommand::restoreState(const QByteArray &) {}
+
+void AccountedUndoCommand::reload()
+{
+    if (!m_journal) {
+        return;
+    }
+    const QByteArray state = m_journal->read(m_journalEntry);
+    if (state.isEmpty()) {
+        qWarning() << "Cannot read undo journal for command" << text();
+    } else {
+        restoreState(state);
+    }
+    m_journal.reset();
+}
+
+FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
+    : AccountedUndoCommand(parent)
     , m_undo(std::move(undo))
     , m_redo(std::move(redo))
     , m_undone(false)
+    , m_memoryCost(0)
+    , m_mergeKey(-1)
 {
     setText(text);
 }
@@ -40,3 +137,51 @@ void FunctionalUndoCommand::redo()
         Q_ASSERT(res);
     }
 }
+
+int FunctionalUndoCommand::id() const
+{
+    return m_mergeKey == -1 ? -1 : 4;
+}
+
+bool FunctionalUndoCommand::mergeWith(const QUndoCommand *other)
+{
+    if (other->id() != id()) {
+        return false;
+    }
+    auto *command = static_cast<const FunctionalUndoCommand *>(other);
+    if (command->m_mergeKey != m_mergeKey || command->text() != text() || m_undone || command->m_undone || m_stamp.msecsTo(command->m_stamp) > mergeDelay) {
+        return false;
+    }
+    // The other command was performed after this one: undo it first, redo it last
+    Fun undo = m_undo;
+    Fun otherUndo = command->m_undo;
+    m_undo = [undo, otherUndo]() {
+        bool res = otherUndo();
+        return undo() && res;
+    };
+    Fun redo = m_redo;
+    Fun otherRedo = command->m_redo;
+    m_redo = [redo, otherRedo]() {
+        bool res = redo();
+        return otherRedo() && res;
+    };
+    m_memoryCost += command->m_memoryCost;
+    m_stamp = command->m_stamp;
+    return true;
+}
+
+qint64 FunctionalUndoCommand::memoryCost() const
+{
+    return AccountedUndoCommand::memoryCost() + qint64(sizeof(FunctionalUndoCommand) - sizeof(AccountedUndoCommand)) + m_memoryCost;
+}
+
+void FunctionalUndoCommand::setMemoryCost(qint64 cost)
+{
+    m_memoryCost = cost;
+}
+
+void FunctionalUndoCommand::setMergeKey(int itemId)
+{
+    m_mergeKey = itemId;
+    m_stamp = QTime::currentTime();
+}
@@ -25,21 +25,87 @@ using Fun = std::function<bool(void)>;
         return v && lambda();                                                                                                                                  \
     };
 
+#include <QTemporaryFile>
+#include <QTime>
 #include <QUndoCommand>
+#include <memory>
+
+/** @class UndoJournal
+    @brief Compressed on-disk storage for the state of old undo commands.
+    Commands exceeding the undo memory budget write their state to the journal and read it back when undone or redone.
+    The journal is a temporary file, deleted with the undo stack.
+ */
+class UndoJournal
+{
+public:
+    struct Entry
+    {
+        qint64 offset{-1};
+        qint64 size{0};
+    };
+    /** @brief Compress and append @param data to the journal, returns an entry with a negative offset on error */
+    Entry write(const QByteArray &data);
+    /** @brief Returns the uncompressed data stored at @param entry */
+    QByteArray read(const Entry &entry);
+    /** @brief Returns the size of the journal file, in bytes */
+    qint64 size() const;
+
+private:
+    QTemporaryFile m_file;
+};
+
+/** @class AccountedUndoCommand
+    @brief Base class of the undo commands reporting the memory they hold.
+    Commands storing their state explicitly can also move it to an UndoJournal when the undo stack exceeds its memory budget.
+ */
+class AccountedUndoCommand : public QUndoCommand
+{
+public:
+    explicit AccountedUndoCommand(QUndoCommand *parent = nullptr);
+    /** @brief Returns an estimate of the memory held by this command (without its children), in bytes */
+    virtual qint64 memoryCost() const;
+    /** @brief Move the state of this command to @param journal, returns the number of bytes released */
+    qint64 spill(const std::shared_ptr<UndoJournal> &journal);
+    /** @brief Returns true if the state of this command is currently stored in a journal */
+    bool isSpilled() const;
+
+protected:
+    /** @brief Serialize the state of the command and release it, returns an empty array if the command cannot be spilled */
+    virtual QByteArray takeState();
+    /** @brief Restore the state previously returned by takeState */
+    virtual void restoreState(const QByteArray &state);
+    /** @brief Read back the state of the command if it was spilled, to be called before using it */
+    void reload();
+
+private:
+    std::shared_ptr<UndoJournal> m_journal;
+    UndoJournal::Entry m_journalEntry;
+};
 
 /** @brief this is a generic class that takes fonctors as undo and redo actions. It just executes them when required by Qt
   Note that QUndoStack actually executes redo() when we push the undoCommand to the stack
   This is bad for us because we execute the command as we construct the undo Function. So to prevent it to be executed twice, there is a small hack in this
   command that prevent redoing if it has not been undone before.
+  The state captured by the functors cannot be serialized, so these commands are accounted but never spilled to the journal.
  */
-class FunctionalUndoCommand : public QUndoCommand
+class FunctionalUndoCommand : public AccountedUndoCommand
 {
 public:
     FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent = nullptr);
     void undo() override;
     void redo() override;
+    int id() const override;
+    bool mergeWith(const QUndoCommand *other) override;
+    qint64 memoryCost() const override;
+    /** @brief Set the memory captured by the functors (values, xml, kept alive items), in bytes. It is only known where the command is built */
+    void setMemoryCost(qint64 cost);
+    /** @brief Allow merging with the next command operating on the same @param itemId with the same text, when pushed shortly after */
+    void setMergeKey(int itemId);
 
 private:
     Fun m_undo, m_redo;
     bool m_undone;
+    qint64 m_memoryCost;
+    int m_mergeKey;
+    QTime m_stamp;
 };
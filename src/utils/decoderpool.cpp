@@ -0,0 +1,141 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "decoderpool.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QThread>
+#include <climits>
+#include <mlt++/Mlt.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+/** @brief MLT ignores larger service cache sizes */
+const int maxMltCacheSize = 200;
+const int minBudget = 4;
+int currentBudget = 0;
+
+QHash<QUuid, int> &timelineTracks()
+{
+    static QHash<QUuid, int> tracks;
+    return tracks;
+}
+
+void applyBudget()
+{
+    // Each track may request frames from its own producer, the thread pools render several frames ahead
+    int demand = QThread::idealThreadCount();
+    for (int tracks : qAsConst(timelineTracks())) {
+        demand += (tracks + 1) * 2;
+    }
+    const int budget = DecoderPool::budget(demand, DecoderPool::occupancy().fileLimit);
+    if (budget != currentBudget) {
+        currentBudget = budget;
+        mlt_service_cache_set_size(nullptr, "producer_avformat", budget);
+        const DecoderPool::Occupancy usage = DecoderPool::occupancy();
+        qDebug() << "Decoder pool budget:" << budget << "producers for" << timelineTracks().size() << "timelines," << usage.openFiles << "/"
+                 << usage.fileLimit << "open files";
+    }
+}
+} // namespace
+
+// static
+int DecoderPool::budget(int demand, int fileLimit)
+{
+    int result = qMax(minBudget, demand);
+    if (fileLimit > 0) {
+        // A producer may keep separate audio and video demuxers, leave half of the files to the rest of the application
+        result = qMin(result, fileLimit / 4);
+    }
+    return qBound(minBudget, result, maxMltCacheSize);
+}
+
+// static
+void DecoderPool::setTimelineTracks(const QUuid &uuid, int tracks)
+{
+    timelineTracks().insert(uuid, tracks);
+    applyBudget();
+}
+
+// static
+void DecoderPool::removeTimeline(const QUuid &uuid)
+{
+    if (timelineTracks().remove(uuid) > 0) {
+        applyBudget();
+    }
+}
+
+// static
+void DecoderPool::clear()
+{
+    timelineTracks().clear();
+    currentBudget = 0;
+    mlt_service_cache_set_size(nullptr, "producer_avformat", 0);
+}
+
+// static
+DecoderPool::Occupancy DecoderPool::occupancy()
+{
+    return {currentBudget, openFiles(), fileLimit()};
+}
+
+// static
+bool DecoderPool::underPressure()
+{
+    const Occupancy usage = occupancy();
+    return usage.openFiles > 0 && usage.fileLimit > 0 && usage.openFiles > usage.fileLimit * 3 / 4;
+}
+
+// static
+void DecoderPool::raiseFileLimit()
+{
+#ifdef Q_OS_UNIX
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur == RLIM_INFINITY) {
+        return;
+    }
+    // Large projects need more files than the usual default of 1024
+    const rlim_t wanted = files.rlim_max == RLIM_INFINITY ? 8192 : qMin(files.rlim_max, rlim_t(8192));
+    if (wanted > files.rlim_cur) {
+        files.rlim_cur = wanted;
+        if (setrlimit(RLIMIT_NOFILE, &files) != 0) {
+            qWarning() << "Cannot raise the open file limit to" << wanted;
+        }
+    }
+#endif
+}
+
+// static
+int DecoderPool::fileLimit()
+{
+#ifdef Q_OS_UNIX
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur == RLIM_INFINITY) {
+        return -1;
+    }
+    return int(qMin(files.rlim_cur, rlim_t(INT_MAX)));
+#else
+    return -1;
+#endif
+}
+
+// static
+int DecoderPool::openFiles()
+{
+#ifdef Q_OS_LINUX
+    QDir fds(QStringLiteral("/proc/self/fd"));
+    if (fds.exists()) {
+        return int(fds.entryList(QDir::Files | QDir::System | QDir::NoDotAndDotDot).count());
+    }
+#endif
+    return -1;
+}
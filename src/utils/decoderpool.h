@@ -0,0 +1,48 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QUuid>
+
+/** @class DecoderPool
+    @brief Project wide budget of the demuxers and decoders kept open by MLT.
+    The avformat producers of all timelines, monitors and thumbnailers share the MLT "producer_avformat" service cache,
+    evicting the least recently used: an evicted producer reopens its file on the next requested frame.
+    This class sizes that cache from the tracks of all open timelines, within the open file limit of the process.
+ */
+class DecoderPool
+{
+public:
+    struct Occupancy
+    {
+        /** @brief Maximum number of avformat producers keeping their files open */
+        int budget;
+        /** @brief Number of files currently open by the process, -1 if unknown */
+        int openFiles;
+        /** @brief Maximum number of files the process can open, -1 if unknown */
+        int fileLimit;
+    };
+    /** @brief The timeline @param uuid now has @param tracks tracks, update the budget */
+    static void setTimelineTracks(const QUuid &uuid, int tracks);
+    /** @brief The timeline @param uuid was deleted, its tracks will not be accounted on next budget update */
+    static void removeTimeline(const QUuid &uuid);
+    /** @brief Close all pooled decoders, used when closing the project */
+    static void clear();
+    static Occupancy occupancy();
+    /** @brief Returns true if the process is close to its open file limit, idle producers should then be released */
+    static bool underPressure();
+    /** @brief Returns the number of pooled producers for @param demand concurrent users, when the process can open @param fileLimit files */
+    static int budget(int demand, int fileLimit);
+    /** @brief Raise the open file limit of the process, the default soft limit is often far below what the system allows.
+     *  Called once at startup */
+    static void raiseFileLimit();
+
+private:
+    static int fileLimit();
+    static int openFiles();
+};
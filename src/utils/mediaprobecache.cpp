@@ -0,0 +1,108 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#include "mediaprobecache.h"
+#include "core.h"
+#include "doc/kdenlivedoc.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <mlt++/Mlt.h>
+
+// static
+QString MediaProbeCache::entryFile(const QString &path, double fps)
+{
+    if (!pCore->currentDoc()) {
+        return QString();
+    }
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        return QString();
+    }
+    bool ok = false;
+    QDir dir = pCore->currentDoc()->getCacheDir(CacheProbe, &ok);
+    if (!ok) {
+        return QString();
+    }
+    const QString key = QStringLiteral("%1|%2|%3|%4")
+                            .arg(info.canonicalFilePath())
+                            .arg(info.size())
+                            .arg(info.lastModified().toMSecsSinceEpoch())
+                            .arg(QString::number(fps, 'f', 6));
+    return dir.absoluteFilePath(QString::fromLatin1(QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex()) + QStringLiteral(".json"));
+}
+
+// static
+QMap<QString, QString> MediaProbeCache::properties(const QString &path, double fps)
+{
+    QMap<QString, QString> result;
+    const QString cacheFile = entryFile(path, fps);
+    if (cacheFile.isEmpty()) {
+        return result;
+    }
+    QFile file(cacheFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+    const QJsonObject entry = QJsonDocument::fromJson(file.readAll()).object();
+    // Mark the entry as recently used
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    for (auto it = entry.constBegin(); it != entry.constEnd(); ++it) {
+        result.insert(it.key(), it.value().toString());
+    }
+    return result;
+}
+
+// static
+void MediaProbeCache::store(const QString &path, Mlt::Producer *producer, double fps)
+{
+    const QString cacheFile = entryFile(path, fps);
+    if (cacheFile.isEmpty()) {
+        return;
+    }
+    // Everything MLT and the clip loading learned from the file, but nothing coming from the project
+    static const QStringList probeProperties = {QStringLiteral("length"),       QStringLiteral("seekable"),        QStringLiteral("audio_index"),
+                                                QStringLiteral("video_index"),  QStringLiteral("creation_time"),   QStringLiteral("set.test_image"),
+                                                QStringLiteral("kdenlive:clip_type")};
+    QJsonObject entry;
+    for (int i = 0; i < producer->count(); ++i) {
+        const QString name = QString::fromUtf8(producer->get_name(i));
+        if (name.startsWith(QLatin1String("meta.")) || probeProperties.contains(name)) {
+            entry.insert(name, QString::fromUtf8(producer->get(i)));
+        }
+    }
+    if (!entry.contains(QLatin1String("length"))) {
+        return;
+    }
+    QSaveFile file(cacheFile);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+        if (file.commit()) {
+            evict(QFileInfo(cacheFile).absolutePath(), maxEntries);
+        }
+    }
+}
+
+// static
+void MediaProbeCache::evict(const QString &dir, int max)
+{
+    QDir cacheDir(dir);
+    const QStringList filter = {QStringLiteral("*.json")};
+    if (cacheDir.entryList(filter, QDir::Files).count() <= max) {
+        return;
+    }
+    // Leave some room so that we don't go through the folder again on the next store
+    const QFileInfoList entries = cacheDir.entryInfoList(filter, QDir::Files, QDir::Time);
+    for (int i = max * 9 / 10; i < entries.count(); ++i) {
+        QFile::remove(entries.at(i).absoluteFilePath());
+    }
+}
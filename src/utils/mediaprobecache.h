@@ -0,0 +1,38 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    This file is part of Kdenlive. See www.kdenlive.org.
+
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+
+#pragma once
+
+#include <QMap>
+#include <QString>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @class MediaProbeCache
+    @brief Persistent cache of the properties found by MLT when probing a media file.
+    Entries are keyed by the resolved path, size and modification time of the file, so that
+    a modified file is probed again, and by the project frame rate since lengths are counted in frames.
+    This allows loading known clips without opening them. The least recently used entries are removed
+    when the cache grows over maxEntries.
+ */
+class MediaProbeCache
+{
+public:
+    /** @brief Returns the cached probe properties of the file @param path opened at @param fps, empty if it was never probed or changed since */
+    static QMap<QString, QString> properties(const QString &path, double fps);
+    /** @brief Store the probe properties of @param producer, opened from the file @param path at @param fps */
+    static void store(const QString &path, Mlt::Producer *producer, double fps);
+
+private:
+    static const int maxEntries = 4000;
+    /** @brief Returns the file storing the cache entry for @param path, empty if the file or cache folder cannot be accessed */
+    static QString entryFile(const QString &path, double fps);
+    /** @brief Remove the least recently used entries of @param dir until it holds less than @param max entries */
+    static void evict(const QString &dir, int max);
+};
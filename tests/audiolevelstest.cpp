@@ -0,0 +1,91 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+#include "jobs/audiolevelstask.h"
+
+#include <QTemporaryDir>
+#include <QThread>
+#include <QThreadPool>
+
+TEST_CASE("Audio levels segments", "[AudioLevels]")
+{
+    SECTION("Segments cover the whole file")
+    {
+        const QVector<QPair<int, int>> ranges = AudioLevelsTask::segmentRanges(1000, 100, 4);
+        REQUIRE(ranges.size() == 4);
+        REQUIRE(ranges.first().first == 0);
+        REQUIRE(ranges.last().second == 1000);
+        for (int i = 1; i < ranges.size(); ++i) {
+            REQUIRE(ranges.at(i).first == ranges.at(i - 1).second);
+        }
+    }
+
+    SECTION("Short files are not split below the minimum segment duration")
+    {
+        REQUIRE(AudioLevelsTask::segmentRanges(250, 100, 8).size() == 2);
+        REQUIRE(AudioLevelsTask::segmentRanges(10, 100, 8) == QVector<QPair<int, int>>{{0, 10}});
+    }
+
+    SECTION("Streams outnumbering the threads are still decoded")
+    {
+        REQUIRE(AudioLevelsTask::segmentRanges(1000, 100, 0) == QVector<QPair<int, int>>{{0, 1000}});
+    }
+
+    SECTION("Tasks share one bounded pool")
+    {
+        QThreadPool *pool = AudioLevelsTask::levelsPool();
+        REQUIRE(pool == AudioLevelsTask::levelsPool());
+        REQUIRE(pool->maxThreadCount() == qMax(1, QThread::idealThreadCount()));
+    }
+}
+
+TEST_CASE("Audio peaks file", "[AudioLevels]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("clip_1_audio.peaks"));
+    QVector<uint8_t> peaks;
+    for (int i = 0; i < 1000; ++i) {
+        peaks << uint8_t(i % 256) << uint8_t(255 - i % 256);
+    }
+    REQUIRE(AudioLevelsTask::writePeaks(path, 2, 48000, peaks));
+    AudioLevelsTask::PeaksHeader header;
+    QVector<uint8_t> read;
+
+    SECTION("Read back the whole file")
+    {
+        REQUIRE(AudioLevelsTask::readPeaks(path, 0, 1000, header, read));
+        REQUIRE(header.channels == 2);
+        REQUIRE(header.frequency == 48000);
+        REQUIRE(header.count == 1000);
+        REQUIRE(header.samplesPerPeak > 0);
+        REQUIRE(read == peaks);
+    }
+
+    SECTION("Read a range")
+    {
+        REQUIRE(AudioLevelsTask::readPeaks(path, 100, 10, header, read));
+        REQUIRE(read == peaks.mid(200, 20));
+        // Ranges past the end are truncated
+        REQUIRE(AudioLevelsTask::readPeaks(path, 995, 10, header, read));
+        REQUIRE(read == peaks.mid(1990));
+        // Only the header
+        REQUIRE(AudioLevelsTask::readPeaks(path, 0, 0, header, read));
+        REQUIRE(read.isEmpty());
+        REQUIRE(header.count == 1000);
+    }
+
+    SECTION("Missing and invalid files")
+    {
+        REQUIRE_FALSE(AudioLevelsTask::readPeaks(dir.filePath(QStringLiteral("missing.peaks")), 0, 10, header, read));
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("not a peaks file");
+        file.close();
+        REQUIRE_FALSE(AudioLevelsTask::readPeaks(path, 0, 10, header, read));
+    }
+}
@@ -15,8 +15,12 @@
 
 #include "core.h"
 #include "definitions.h"
+#include "utils/mediaprobecache.h"
 #include "utils/thumbnailcache.hpp"
 
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+
 TEST_CASE("Cache insert-remove", "[Cache]")
 {
     // Create timeline
@@ -94,3 +98,84 @@ TEST_CASE("getAudioKey() should dereference `ok` param", "ThumbnailCache") {
     }
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
+
+TEST_CASE("Media probe cache", "[MediaProbeCache]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    QTemporaryDir cacheDir;
+    REQUIRE(cacheDir.isValid());
+    KdenliveDoc document(undoStack);
+    Mock<KdenliveDoc> docMock(document);
+    When(Method(docMock, getCacheDir)).AlwaysDo([&cacheDir](CacheType, bool *ok, const QUuid) {
+        *ok = true;
+        return QDir(cacheDir.path());
+    });
+    KdenliveDoc &mockedDoc = docMock.get();
+
+    pCore->projectManager()->m_project = &mockedDoc;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    pCore->projectManager()->updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = mockedDoc.getTimeline(mockedDoc.uuid());
+    pCore->projectManager()->m_activeTimelineModel = timeline;
+    pCore->projectManager()->testSetActiveDocument(&mockedDoc, timeline);
+
+    QTemporaryFile media;
+    REQUIRE(media.open());
+    media.write("media");
+    media.flush();
+    Mlt::Producer producer(pCore->getProjectProfile(), "color", "red");
+    producer.set("length", 250);
+    producer.set("meta.media.width", 1920);
+    producer.set("kdenlive:id", "12");
+
+    SECTION("Hit and miss")
+    {
+        REQUIRE(MediaProbeCache::properties(media.fileName(), 25.).isEmpty());
+        MediaProbeCache::store(media.fileName(), &producer, 25.);
+        const QMap<QString, QString> properties = MediaProbeCache::properties(media.fileName(), 25.);
+        REQUIRE(properties.value(QStringLiteral("length")) == QStringLiteral("250"));
+        REQUIRE(properties.value(QStringLiteral("meta.media.width")) == QStringLiteral("1920"));
+        // Project properties are not cached
+        REQUIRE(!properties.contains(QStringLiteral("kdenlive:id")));
+        // Another file misses
+        QTemporaryFile other;
+        REQUIRE(other.open());
+        REQUIRE(MediaProbeCache::properties(other.fileName(), 25.).isEmpty());
+    }
+
+    SECTION("Frame rate change")
+    {
+        MediaProbeCache::store(media.fileName(), &producer, 25.);
+        REQUIRE(!MediaProbeCache::properties(media.fileName(), 25.).isEmpty());
+        // Lengths are counted in frames, a different project frame rate must probe again
+        REQUIRE(MediaProbeCache::properties(media.fileName(), 30000. / 1001.).isEmpty());
+    }
+
+    SECTION("File change")
+    {
+        MediaProbeCache::store(media.fileName(), &producer, 25.);
+        media.write("more data");
+        media.flush();
+        REQUIRE(MediaProbeCache::properties(media.fileName(), 25.).isEmpty());
+    }
+
+    SECTION("Eviction of the least recently used entries")
+    {
+        QDir dir(cacheDir.path());
+        for (int i = 0; i < 20; ++i) {
+            QFile entry(dir.absoluteFilePath(QStringLiteral("%1.json").arg(i)));
+            REQUIRE(entry.open(QIODevice::WriteOnly));
+            entry.write("{}");
+            entry.setFileTime(QDateTime::currentDateTime().addSecs(i - 100), QFileDevice::FileModificationTime);
+        }
+        MediaProbeCache::evict(cacheDir.path(), 30);
+        REQUIRE(dir.entryList({QStringLiteral("*.json")}, QDir::Files).count() == 20);
+        MediaProbeCache::evict(cacheDir.path(), 10);
+        const QStringList remaining = dir.entryList({QStringLiteral("*.json")}, QDir::Files);
+        REQUIRE(remaining.count() == 9);
+        // The oldest entries were removed
+        REQUIRE(!remaining.contains(QStringLiteral("0.json")));
+        REQUIRE(remaining.contains(QStringLiteral("19.json")));
+    }
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
@@ -8,6 +8,8 @@
 // test specific headers
 #include "doc/kdenlivedoc.h"
 
+#include <climits>
+
 static QString getACompo()
 {
 
@@ -450,3 +452,80 @@ TEST_CASE("Composition manipulation", "[CompositionModel]")
     timeline.reset();
     pCore->projectItemModel()->clean();
 }
+
+TEST_CASE("Planting many compositions", "[CompositionModel]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    KdenliveDoc document(undoStack, {0, 3});
+    Mock<KdenliveDoc> docMock(document);
+    When(Method(docMock, getCacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    KdenliveDoc &mockedDoc = docMock.get();
+
+    pCore->projectManager()->m_project = &mockedDoc;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    pCore->projectManager()->updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = mockedDoc.getTimeline(mockedDoc.uuid());
+    pCore->projectManager()->m_activeTimelineModel = timeline;
+    pCore->projectManager()->testSetActiveDocument(&mockedDoc, timeline);
+
+    QString aCompo = getACompo();
+    int tid2 = timeline->getTrackIndexFromPosition(1);
+    int tid3 = timeline->getTrackIndexFromPosition(2);
+
+    // Insert 5000 compositions, alternating between the tracks so that each insertion has to find its place in the field
+    const int count = 5000;
+    for (int i = 0; i < count; ++i) {
+        int cid = -1;
+        REQUIRE(timeline->requestCompositionInsertion(aCompo, i % 2 == 0 ? tid3 : tid2, i / 2, 1, nullptr, cid, false));
+    }
+    REQUIRE(timeline->getCompositionsCount() == count);
+    REQUIRE(timeline->checkConsistency());
+
+    // Compositions must be ordered by decreasing a_track and increasing b_track from the bottom of the field
+    auto checkOrder = [&]() {
+        QScopedPointer<Mlt::Field> field(timeline->m_tractor->field());
+        field->lock();
+        int planted = 0;
+        int lastATrack = -1;
+        int lastBTrack = INT_MAX;
+        mlt_service nextservice = mlt_service_get_producer(field->get_service());
+        while (nextservice != nullptr && mlt_service_identify(nextservice) == mlt_service_transition_type) {
+            auto tr = mlt_transition(nextservice);
+            if (mlt_properties_get_int(MLT_TRANSITION_PROPERTIES(tr), "internal_added") == 0) {
+                int aTrack = mlt_transition_get_a_track(tr);
+                int bTrack = mlt_transition_get_b_track(tr);
+                // We walk from the top, so a_track is increasing and b_track decreasing
+                REQUIRE((aTrack > lastATrack || (aTrack == lastATrack && bTrack <= lastBTrack)));
+                lastATrack = aTrack;
+                lastBTrack = bTrack;
+                planted++;
+            }
+            nextservice = mlt_service_producer(nextservice);
+        }
+        field->unlock();
+        return planted;
+    };
+    REQUIRE(checkOrder() == count);
+
+    // Moving compositions to another track only replants them
+    std::vector<int> compos;
+    for (const auto &compo : timeline->m_allCompositions) {
+        compos.push_back(compo.first);
+    }
+    for (int i = 0; i < 100; ++i) {
+        int cid = compos[size_t(i)];
+        int trackId = timeline->getCompositionTrackId(cid) == tid2 ? tid3 : tid2;
+        REQUIRE(timeline->requestCompositionMove(cid, trackId, count + i));
+    }
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(checkOrder() == count);
+
+    undoStack->undo();
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(checkOrder() == count);
+
+    pCore->taskManager.slotCancelJobs();
+    mockedDoc.closeTimeline(timeline->uuid());
+    timeline.reset();
+    pCore->projectItemModel()->clean();
+}
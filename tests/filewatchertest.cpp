@@ -0,0 +1,81 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+#include "bin/filewatcher.hpp"
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+/** @brief Process events until @param condition is true, or give up after 5 seconds */
+template <typename Condition> static bool waitFor(Condition condition)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition() && timer.elapsed() < 5000) {
+        qApp->processEvents(QEventLoop::AllEvents, 50);
+    }
+    return condition();
+}
+
+TEST_CASE("Watched directory notifications", "[FileWatcher]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("clip.mp4"));
+    QFile media(path);
+    REQUIRE(media.open(QIODevice::WriteOnly));
+    media.write("media");
+    media.close();
+
+    FileWatcher watcher;
+    int waiting = 0;
+    int missing = 0;
+    QObject::connect(&watcher, &FileWatcher::binClipWaiting, [&waiting](const QString &) { waiting++; });
+    QObject::connect(&watcher, &FileWatcher::binClipMissing, [&missing](const QString &) { missing++; });
+
+    watcher.addFile(QStringLiteral("1"), path);
+    REQUIRE(watcher.contains(path));
+    REQUIRE(waitFor([&]() { return watcher.m_dirs.count(dir.path()) > 0 && watcher.m_dirs.at(dir.path()).registered; }));
+    REQUIRE(watcher.m_files.at(path).state.exists);
+
+    SECTION("Repeated notifications are checked once, off the GUI thread")
+    {
+        REQUIRE(media.open(QIODevice::Append));
+        media.write("more data");
+        media.close();
+        for (int i = 0; i < 5; ++i) {
+            watcher.slotDirChanged(dir.path());
+        }
+        // Notifications about a file resolve to its directory
+        watcher.slotDirChanged(path);
+        REQUIRE(watcher.m_changedDirs.size() == 1);
+        // Nothing was compared yet
+        REQUIRE(waiting == 0);
+        REQUIRE(watcher.m_files.at(path).state.size == 5);
+        REQUIRE(waitFor([&]() { return waiting > 0; }));
+        REQUIRE(waiting == 1);
+        REQUIRE(watcher.m_files.at(path).state.size == 14);
+        REQUIRE(watcher.m_changedDirs.empty());
+    }
+
+    SECTION("Deleted file")
+    {
+        REQUIRE(QFile::remove(path));
+        watcher.slotDirChanged(dir.path());
+        REQUIRE(missing == 0);
+        REQUIRE(waitFor([&]() { return missing > 0; }));
+        REQUIRE(!watcher.m_files.at(path).state.exists);
+    }
+
+    SECTION("Unwatched directory")
+    {
+        watcher.slotDirChanged(QDir::tempPath() + QStringLiteral("/kdenlive-unwatched"));
+        REQUIRE(watcher.m_changedDirs.empty());
+        REQUIRE(!watcher.m_dirChangeTimer.isActive());
+    }
+    watcher.clear();
+}
@@ -7,6 +7,7 @@
 #include "test_utils.hpp"
 // test specific headers
 #include "doc/kdenlivedoc.h"
+#include <QTemporaryDir>
 #include <QUndoGroup>
 
 using namespace fakeit;
@@ -1121,6 +1122,77 @@ TEST_CASE("Clip manipulation", "[ClipModel]")
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
 
+TEST_CASE("Rows in range", "[TrackModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->m_project = &document;
+    TimelineItemModel tim(document.uuid(), undoStack);
+    Mock<TimelineItemModel> timMock(tim);
+    auto timeline = std::shared_ptr<TimelineItemModel>(&timMock.get(), [](...) {});
+    TimelineItemModel::finishConstruct(timeline);
+    pCore->projectManager()->testSetActiveDocument(&document, timeline);
+    Fake(Method(timMock, adjustAssetRange));
+
+    QString binId = createProducer(pCore->getProjectProfile(), "red", binModel, 20);
+    int tid1;
+    REQUIRE(timeline->requestTrackInsertion(-1, tid1));
+    // Clips are created in reverse position order so that row order (by id) differs from position order
+    std::vector<int> clips(5);
+    for (int i = 4; i >= 0; --i) {
+        clips[size_t(i)] = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    }
+    for (int i = 0; i < 5; ++i) {
+        REQUIRE(timeline->requestClipMove(clips[size_t(i)], tid1, 100 * i));
+    }
+    auto track = timeline->getTrackById_const(tid1);
+    auto rowsOf = [&](std::vector<int> cids) {
+        std::vector<int> rows;
+        for (int cid : cids) {
+            rows.push_back(track->getRowfromClip(cid));
+        }
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    };
+    REQUIRE(timeline->checkConsistency());
+    REQUIRE(track->getRowsInRange(0, 500) == rowsOf(clips));
+    REQUIRE(track->getRowsInRange(20, 99).empty());
+    // A clip starting before the range but ending inside it is returned
+    REQUIRE(track->getRowsInRange(110, 150) == rowsOf({clips[1]}));
+    REQUIRE(track->getRowsInRange(119, 200) == rowsOf({clips[1], clips[2]}));
+    REQUIRE(track->getRowsInRange(120, 199).empty());
+    REQUIRE(track->getRowsInRange(450, 1000) == rowsOf({clips[4]}));
+
+    SECTION("Index follows moves, resizes and deletions")
+    {
+        REQUIRE(timeline->requestClipMove(clips[0], tid1, 150));
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getRowsInRange(0, 99).empty());
+        REQUIRE(track->getRowsInRange(160, 165) == rowsOf({clips[0]}));
+
+        // Resize from the left moves the clip start
+        REQUIRE(timeline->requestItemResize(clips[2], 10, false) == 10);
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getRowsInRange(200, 209).empty());
+        REQUIRE(track->getRowsInRange(210, 210) == rowsOf({clips[2]}));
+
+        REQUIRE(timeline->requestItemDeletion(clips[3]));
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getRowsInRange(300, 399).empty());
+
+        undoStack->undo();
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getRowsInRange(300, 399) == rowsOf({clips[3]}));
+        undoStack->undo();
+        undoStack->undo();
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getRowsInRange(0, 500) == rowsOf(clips));
+    }
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
+
 TEST_CASE("Check id unicity", "[ClipModel]")
 {
     auto binModel = pCore->projectItemModel();
@@ -2234,3 +2306,63 @@ TEST_CASE("New KdenliveDoc activeTrack", "KdenliveDoc")
         pCore->projectManager()->closeCurrentDocument(false, false);
     }
 }
+
+TEST_CASE("Clone producers without probing", "[ProjectClip]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->m_project = &document;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    pCore->projectManager()->updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = document.getTimeline(document.uuid());
+    pCore->projectManager()->m_activeTimelineModel = timeline;
+    pCore->projectManager()->testSetActiveDocument(&document, timeline);
+
+    // Work on a copy of the media, so that it can be hidden while cloning
+    QTemporaryDir mediaDir;
+    REQUIRE(mediaDir.isValid());
+    const QString path = mediaDir.filePath(QStringLiteral("small.mkv"));
+    const QString hiddenPath = mediaDir.filePath(QStringLiteral("hidden.mkv"));
+    REQUIRE(QFile::copy(sourcesPath + "/small.mkv", path));
+    std::shared_ptr<Mlt::Producer> producer = std::make_shared<Mlt::Producer>(pCore->getProjectProfile(), path.toUtf8().constData());
+    if (!producer->is_valid() || !QString(producer->get("mlt_service")).startsWith(QLatin1String("avformat"))) {
+        WARN("No avformat support, skipping clone test");
+        pCore->projectManager()->closeCurrentDocument(false, false);
+        return;
+    }
+    QString binId = QString::number(binModel->getFreeClipId());
+    auto binClip = ProjectClip::construct(binId, QIcon(), binModel, producer);
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    REQUIRE(binModel->addItem(binClip, binModel->getRootFolder()->clipId(), undo, redo));
+    std::shared_ptr<ProjectClip> clip = binModel->getClipByBinID(binId);
+    REQUIRE(clip != nullptr);
+
+    // The file cannot be probed anymore, so valid clones prove that they were not probed
+    REQUIRE(QFile::rename(path, hiddenPath));
+    REQUIRE(!Mlt::Producer(pCore->getProjectProfile(), path.toUtf8().constData()).is_valid());
+
+    // Cloning 200 times, as when dropping 200 clips in the timeline
+    const int count = 200;
+    std::vector<std::shared_ptr<Mlt::Producer>> clones;
+    for (int i = 0; i < count; ++i) {
+        clones.push_back(clip->cloneProducer());
+    }
+    for (const auto &clone : clones) {
+        REQUIRE(clone->is_valid());
+        REQUIRE(QString(clone->get("mlt_service")) == QLatin1String("avformat-novalidate"));
+        REQUIRE(clone->get_length() == clip->originalProducer()->get_length());
+        REQUIRE(clone->get_int("meta.media.nb_streams") == clip->originalProducer()->get_int("meta.media.nb_streams"));
+        REQUIRE(QString(clone->get("kdenlive:id")) == binId);
+    }
+
+    // Clones play the same frames as the master
+    REQUIRE(QFile::rename(hiddenPath, path));
+    std::unique_ptr<Mlt::Frame> frame(clones.front()->get_frame());
+    REQUIRE(frame->is_valid());
+    clones.clear();
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
@@ -91,3 +91,90 @@ TEST_CASE("Cut undo/redo", "[MoveClips]")
     }
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
+
+TEST_CASE("Merge consecutive moves in undo stack", "[MoveClips]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    // Create document
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->m_project = &document;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    pCore->projectManager()->updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = document.getTimeline(document.uuid());
+    pCore->projectManager()->m_activeTimelineModel = timeline;
+    pCore->projectManager()->testSetActiveDocument(&document, timeline);
+
+    int tid1 = timeline->getTrackIndexFromPosition(2);
+    QString binId = createProducer(pCore->getProjectProfile(), "red", binModel);
+    int cid1;
+    REQUIRE(timeline->requestClipInsertion(binId, tid1, 10, cid1));
+    int commands = undoStack->count();
+
+    SECTION("Repeated moves of a clip are undone in one step")
+    {
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 11));
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 12));
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 13));
+        REQUIRE(undoStack->count() == commands + 1);
+        REQUIRE(undoStack->commandCost(undoStack->count() - 1) > 0);
+        undoStack->undo();
+        REQUIRE(timeline->getClipPosition(cid1) == 10);
+        undoStack->redo();
+        REQUIRE(timeline->getClipPosition(cid1) == 13);
+        REQUIRE(timeline->checkConsistency());
+
+        // A move after undo/redo starts a new step
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 14));
+        REQUIRE(undoStack->count() == commands + 2);
+        undoStack->undo();
+        REQUIRE(timeline->getClipPosition(cid1) == 13);
+    }
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
+
+TEST_CASE("Group move sends batched view notifications", "[MoveClips]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+
+    // Create document
+    KdenliveDoc document(undoStack);
+    pCore->projectManager()->m_project = &document;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    pCore->projectManager()->updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = document.getTimeline(document.uuid());
+    pCore->projectManager()->m_activeTimelineModel = timeline;
+    pCore->projectManager()->testSetActiveDocument(&document, timeline);
+
+    int tid1 = timeline->getTrackIndexFromPosition(2);
+    QString binId = createProducer(pCore->getProjectProfile(), "red", binModel);
+    std::unordered_set<int> clips;
+    int cid1 = -1;
+    for (int i = 0; i < 8; i++) {
+        int cid;
+        REQUIRE(timeline->requestClipInsertion(binId, tid1, 10 + 20 * i, cid));
+        clips.insert(cid);
+        if (cid1 == -1) {
+            cid1 = cid;
+        }
+    }
+    REQUIRE(timeline->requestClipsGroup(clips));
+
+    SECTION("Moving the group announces consecutive rows at once")
+    {
+        int notifications = timeline->dataChangedCount();
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 20));
+        REQUIRE(timeline->getClipPosition(cid1) == 20);
+        REQUIRE(timeline->dataChangedCount() - notifications < int(clips.size()));
+        notifications = timeline->dataChangedCount();
+        undoStack->undo();
+        REQUIRE(timeline->getClipPosition(cid1) == 10);
+        REQUIRE(timeline->dataChangedCount() - notifications < int(clips.size()));
+        REQUIRE(timeline->checkConsistency());
+    }
+    pCore->projectManager()->closeCurrentDocument(false, false);
+}
@@ -7,6 +7,7 @@
 // test specific headers
 #include "bin/binplaylist.hpp"
 #include "doc/kdenlivedoc.h"
+#include "jobs/sequencerendertask.h"
 #include "timeline2/model/builders/meltBuilder.hpp"
 #include "xml/xml.hpp"
 
@@ -477,3 +478,67 @@ TEST_CASE("Save File, Reopen and check for corruption", "[SF3]")
         pCore->projectManager()->closeCurrentDocument(false, false);
     }
 }
+
+TEST_CASE("Sequence render cache key", "[SequenceRender]")
+{
+    const QString base = QStringLiteral("<mlt><tractor id=\"tractor0\"><property name=\"kdenlive:sequenceproperties.position\">%1</property>"
+                                        "<property name=\"kdenlive:clipname\">%2</property><property name=\"kdenlive:empty\"/>"
+                                        "<track producer=\"playlist0\" in=\"%3\"/></tractor></mlt>");
+    const QString hash = SequenceRenderTask::sequenceHash(base.arg(0).arg(QStringLiteral("Sequence")).arg(0));
+    // Kdenlive properties don't change the rendered frames
+    REQUIRE(SequenceRenderTask::sequenceHash(base.arg(125).arg(QStringLiteral("Renamed")).arg(0)) == hash);
+    // MLT content does
+    REQUIRE(SequenceRenderTask::sequenceHash(base.arg(0).arg(QStringLiteral("Sequence")).arg(10)) != hash);
+}
+
+TEST_CASE("Sequence render cache key follows the media files", "[SequenceRender]")
+{
+    QTemporaryFile media(QDir::temp().absoluteFilePath(QStringLiteral("kdenlive-media-XXXXXX.mkv")));
+    REQUIRE(media.open());
+    media.write("frames");
+    media.flush();
+    const QString base = QStringLiteral("<mlt><producer id=\"producer0\"><property name=\"resource\">%1</property></producer></mlt>");
+    const QString xml = base.arg(media.fileName());
+    const QString hash = SequenceRenderTask::sequenceHash(xml);
+    REQUIRE(SequenceRenderTask::sequenceHash(xml) == hash);
+
+    SECTION("Media replaced by a different file with the same name")
+    {
+        media.write("more frames");
+        media.flush();
+        REQUIRE(SequenceRenderTask::sequenceHash(xml) != hash);
+    }
+
+    SECTION("Service prefix")
+    {
+        const QString prefixed = base.arg(QStringLiteral("avformat-novalidate:") + media.fileName());
+        const QString prefixedHash = SequenceRenderTask::sequenceHash(prefixed);
+        media.write("more frames");
+        media.flush();
+        REQUIRE(SequenceRenderTask::sequenceHash(prefixed) != prefixedHash);
+    }
+
+    SECTION("Missing media")
+    {
+        const QString missing = base.arg(QStringLiteral("/nonexistent/kdenlive/media.mkv"));
+        REQUIRE(SequenceRenderTask::sequenceHash(missing) == SequenceRenderTask::sequenceHash(missing));
+        REQUIRE(SequenceRenderTask::sequenceHash(missing) != hash);
+    }
+}
+
+TEST_CASE("Sequence render intermediate is lossless", "[SequenceRender]")
+{
+    const QStringList args = SequenceRenderTask::consumerArguments(QStringLiteral("/cache/sequence.mkv.part"), 249, 4);
+    REQUIRE(args.at(0) == QStringLiteral("-consumer"));
+    REQUIRE(args.at(1) == QStringLiteral("avformat:/cache/sequence.mkv.part"));
+    REQUIRE(args.contains(QStringLiteral("out=249")));
+    REQUIRE(args.contains(QStringLiteral("vcodec=ffv1")));
+    REQUIRE(args.contains(QStringLiteral("g=1")));
+    REQUIRE(args.contains(QStringLiteral("pix_fmt=yuv422p")));
+    for (const QString &arg : args) {
+        // No lossy quantizer or full range jpeg formats
+        REQUIRE(!arg.startsWith(QLatin1String("qscale=")));
+        REQUIRE(!arg.contains(QLatin1String("yuvj")));
+        REQUIRE(!arg.contains(QLatin1String("mjpeg")));
+    }
+}
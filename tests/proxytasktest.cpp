@@ -0,0 +1,51 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+#include "jobs/proxytask.h"
+
+TEST_CASE("Ingest encoder arguments", "[ProxyIngest]")
+{
+    const QString source = QStringLiteral("/media/clip.mp4");
+    const QStringList parameters = {QStringLiteral("-noautorotate"), QStringLiteral("-i"), source,          QStringLiteral("-c:v"),
+                                    QStringLiteral("libx264"),       QStringLiteral("-sn"), QStringLiteral("-map"), QStringLiteral("0"),
+                                    QStringLiteral("/proxy/clip.mkv")};
+
+    SECTION("Video only")
+    {
+        const QStringList args = ProxyTask::ingestArguments(parameters, QSize(640, 360), 25, 1, source, false);
+        REQUIRE(!args.contains(source));
+        REQUIRE(!args.contains(QStringLiteral("-noautorotate")));
+        REQUIRE(args.count(QStringLiteral("-i")) == 1);
+        REQUIRE(args.at(args.indexOf(QStringLiteral("-i")) + 1) == QStringLiteral("pipe:0"));
+        REQUIRE(args.contains(QStringLiteral("640x360")));
+        REQUIRE(args.contains(QStringLiteral("25/1")));
+        REQUIRE(args.at(args.indexOf(QStringLiteral("-map")) + 1) == QStringLiteral("0:v"));
+        REQUIRE(args.last() == QStringLiteral("/proxy/clip.mkv"));
+    }
+
+    SECTION("Audio read from the source")
+    {
+        const QStringList args = ProxyTask::ingestArguments(parameters, QSize(640, 360), 30000, 1001, source, true);
+        REQUIRE(args.count(QStringLiteral("-i")) == 2);
+        REQUIRE(args.count(source) == 1);
+        REQUIRE(args.contains(QStringLiteral("1:a")));
+    }
+
+    SECTION("Decoded audio written to a socket, the source is never read by FFmpeg")
+    {
+        const QString socket = QStringLiteral("unix:///tmp/kdenlive-ingest");
+        const QStringList args = ProxyTask::ingestArguments(parameters, QSize(640, 360), 25, 1, source, true, socket, 48000, 2);
+        REQUIRE(!args.contains(source));
+        REQUIRE(args.count(QStringLiteral("-i")) == 2);
+        const int audioInput = args.lastIndexOf(QStringLiteral("-i"));
+        REQUIRE(args.at(audioInput + 1) == socket);
+        REQUIRE(args.at(audioInput - 1) == QStringLiteral("2"));
+        REQUIRE(args.contains(QStringLiteral("s16le")));
+        REQUIRE(args.contains(QStringLiteral("48000")));
+        REQUIRE(args.indexOf(QStringLiteral("1:a")) > args.indexOf(QStringLiteral("0:v")));
+    }
+}
@@ -293,3 +293,80 @@ TEST_CASE("Tests of the render functions to use guides for sections", "[RenderRe
         CHECK(sections.at(2).out == out);
     }
 }
+
+TEST_CASE("Render segment split points", "[RenderSegments]")
+{
+    SECTION("Evenly spaced without candidates")
+    {
+        QList<int> points = RenderRequest::segmentSplitPoints(0, 999, 4, 100, {});
+        CHECK(points == QList<int>({250, 500, 750}));
+    }
+
+    SECTION("Snap to nearby cuts")
+    {
+        QList<int> points = RenderRequest::segmentSplitPoints(0, 999, 4, 100, {240, 700});
+        CHECK(points == QList<int>({240, 500, 700}));
+    }
+
+    SECTION("Too short for segments")
+    {
+        CHECK(RenderRequest::segmentSplitPoints(0, 149, 4, 100, {}).isEmpty());
+        // Segment count is reduced to respect the minimum length
+        CHECK(RenderRequest::segmentSplitPoints(0, 299, 8, 100, {}).size() == 2);
+    }
+}
+
+TEST_CASE("Concurrent render job admission", "[RenderJobs]")
+{
+    SECTION("Thread cost of a job")
+    {
+        // Default settings: no parallel processing, automatic encoder threads
+        CHECK(RenderRequest::jobThreadCost(-1, 0) == 3);
+        CHECK(RenderRequest::jobThreadCost(-4, 0) == 6);
+        CHECK(RenderRequest::jobThreadCost(0, 8) == 9);
+        CHECK(RenderRequest::jobThreadCost(-2, 4) == 6);
+    }
+
+    SECTION("Jobs with default settings share the machine")
+    {
+        const int budget = 8;
+        const int cost = RenderRequest::jobThreadCost(-1, 0);
+        int used = 0;
+        REQUIRE(RenderRequest::canStartJob(used, cost, budget));
+        used += cost;
+        REQUIRE(RenderRequest::canStartJob(used, cost, budget));
+        used += cost;
+        CHECK_FALSE(RenderRequest::canStartJob(used, cost, budget));
+    }
+
+    SECTION("A job larger than the budget starts alone")
+    {
+        CHECK(RenderRequest::canStartJob(0, 32, 8));
+        CHECK_FALSE(RenderRequest::canStartJob(1, 32, 8));
+    }
+}
+
+TEST_CASE("Timeline preview reuse when rendering", "[RenderSmart]")
+{
+    RenderPresetParams params;
+    params.insert(QStringLiteral("f"), QStringLiteral("mp4"));
+    params.insert(QStringLiteral("vcodec"), QStringLiteral("libx264"));
+    params.insert(QStringLiteral("crf"), QStringLiteral("18"));
+    params.insert(QStringLiteral("acodec"), QStringLiteral("aac"));
+
+    SECTION("Matching video parameters")
+    {
+        QStringList preview = {QStringLiteral("f=matroska"), QStringLiteral("vcodec=libx264"), QStringLiteral("crf=18"), QStringLiteral("an=1")};
+        CHECK(RenderRequest::previewParamsMatch(preview, params));
+        params.insert(QStringLiteral("meta.attr.title.markup"), QStringLiteral("Title"));
+        CHECK(RenderRequest::previewParamsMatch(preview, params));
+    }
+
+    SECTION("Different video parameters")
+    {
+        CHECK_FALSE(RenderRequest::previewParamsMatch({QStringLiteral("vcodec=libx264"), QStringLiteral("crf=23")}, params));
+        // Resized preview
+        CHECK_FALSE(RenderRequest::previewParamsMatch({QStringLiteral("vcodec=libx264"), QStringLiteral("crf=18"), QStringLiteral("s=640x360")}, params));
+        CHECK_FALSE(RenderRequest::previewParamsMatch({}, params));
+    }
+}
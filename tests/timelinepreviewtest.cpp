@@ -18,8 +18,10 @@
 #include "bin/binplaylist.hpp"
 #include "definitions.h"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
 #include "timeline2/model/builders/meltBuilder.hpp"
 #include "timeline2/view/previewmanager.h"
+#include "timeline2/view/rampreviewchunk.h"
 #include "xml/xml.hpp"
 
 TEST_CASE("Timeline preview insert-remove", "[TimelinePreview]")
@@ -116,3 +118,85 @@ TEST_CASE("Timeline preview insert-remove", "[TimelinePreview]")
     binModel->clean();
     pCore->m_projectManager = nullptr;
 }
+
+TEST_CASE("Save timeline with in memory preview chunks", "[TimelinePreview]")
+{
+    auto binModel = pCore->projectItemModel();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    pCore->setCurrentProfile("atsc_1080p_25");
+
+    KdenliveDoc document(undoStack);
+    Mock<KdenliveDoc> docMock(document);
+    KdenliveDoc &mockedDoc = docMock.get();
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    When(Method(pmMock, cacheDir)).AlwaysReturn(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)));
+    When(Method(pmMock, current)).AlwaysReturn(&mockedDoc);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+    mocked.m_project = &mockedDoc;
+    QDateTime documentDate = QDateTime::currentDateTime();
+    mocked.updateTimeline(false, QString(), QString(), documentDate, 0);
+    auto timeline = mockedDoc.getTimeline(mockedDoc.uuid());
+    mocked.m_activeTimelineModel = timeline;
+    mocked.testSetActiveDocument(&mockedDoc, timeline);
+
+    mockedDoc.setDocumentProperty(QStringLiteral("documentid"), QString::number(QDateTime::currentMSecsSinceEpoch()));
+    mockedDoc.setDocumentProperty(QStringLiteral("previewextension"), QStringLiteral("avi"));
+    mockedDoc.setDocumentProperty(QStringLiteral("previewparameters"), QStringLiteral("vcodec=mjpeg progressive=1 qscale=10"));
+    bool ok = false;
+    QDir dir = mockedDoc.getCacheDir(CacheBase, &ok);
+    dir.mkpath(QStringLiteral("."));
+    dir.mkdir(QLatin1String("preview"));
+
+    int tid = timeline->getTrackIndexFromPosition(2);
+    QString binId = createProducer(pCore->getProjectProfile(), "red", binModel, 50);
+    int cid = -1;
+    REQUIRE(timeline->requestClipInsertion(binId, tid, 0, cid, true, true, false));
+
+    timeline->initializePreviewManager();
+    timeline->buildPreviewTrack();
+    auto preview = timeline->previewManager();
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    preview->addPreviewRange({0, chunkSize - 1}, true);
+
+    // Simulate a chunk rendered in memory
+    const QSize size(64, 36);
+    std::shared_ptr<RamPreviewChunk> chunk = RamPreviewChunk::create(size, chunkSize, qint64(64) * 1024 * 1024);
+    REQUIRE(chunk != nullptr);
+    QByteArray image(size.width() * size.height() * 2, 0);
+    for (int i = 0; i < chunkSize; i++) {
+        chunk->appendFrame(reinterpret_cast<const uint8_t *>(image.constData()));
+    }
+    preview->gotRamPreviewRender(0, chunk);
+    REQUIRE(preview->ramChunks() == QList<int>{0});
+
+    // The in memory chunk is listed as dirty so that it is rendered again after reopening
+    const QPair<QStringList, QStringList> chunks = preview->previewChunks();
+    REQUIRE(chunks.first.isEmpty());
+    REQUIRE(chunks.second == QStringList{QStringLiteral("0")});
+
+    SECTION("Timeline xml")
+    {
+        const QString xml = timeline->sceneList(dir.absolutePath());
+        REQUIRE_FALSE(xml.contains(QLatin1String("kdenlive_rampreview")));
+        Mlt::Producer reloaded(pCore->getProjectProfile(), "xml-string", xml.toUtf8().constData());
+        REQUIRE(reloaded.is_valid());
+    }
+
+    SECTION("Project xml")
+    {
+        const QString xml = binModel->sceneList(dir.absolutePath(), QString(), QString(), timeline->tractor(), timeline->duration());
+        REQUIRE_FALSE(xml.contains(QLatin1String("kdenlive_rampreview")));
+        Mlt::Producer reloaded(pCore->getProjectProfile(), "xml-string", xml.toUtf8().constData());
+        REQUIRE(reloaded.is_valid());
+    }
+
+    // The chunk is still played after saving
+    REQUIRE(preview->ramChunks() == QList<int>{0});
+
+    timeline->resetPreviewManager();
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
@@ -526,6 +526,56 @@ TEST_CASE("Simple trimming operations", "[Trimming]")
         state2();
     }
 
+    SECTION("Cut several tracks at several positions")
+    {
+        int l = timeline->getClipPlaytime(cid1);
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+        REQUIRE(timeline->requestClipMove(cid2, tid2, 0));
+        REQUIRE(timeline->requestClipMove(cid3, tid3, 0));
+        int count = timeline->getClipsCount();
+        auto state = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getClipsCount() == count);
+            REQUIRE(timeline->getClipPlaytime(cid1) == l);
+            REQUIRE(timeline->getClipPlaytime(cid3) == l);
+            REQUIRE(timeline->rowCount(timeline->makeTrackIndexFromID(tid1)) == 1);
+        };
+        state();
+
+        // Rows are announced as they are inserted, so that views stay in sync with the model
+        int insertedRows = 0;
+        const QModelIndex trackIndex = timeline->makeTrackIndexFromID(tid1);
+        auto connection = QObject::connect(timeline.get(), &QAbstractItemModel::rowsInserted, [&](const QModelIndex &parent, int first, int last) {
+            if (parent == trackIndex) {
+                insertedRows += last - first + 1;
+            }
+        });
+        // Only cut tracks 1 and 2, positions are given unsorted
+        REQUIRE(TimelineFunctions::requestMultipleClipCut(timeline, {6, 3}, {tid1, tid2}));
+        QObject::disconnect(connection);
+        REQUIRE(insertedRows == 2);
+        auto state2 = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getClipsCount() == count + 4);
+            REQUIRE(timeline->getClipPlaytime(cid1) == 3);
+            REQUIRE(timeline->getClipPlaytime(cid2) == 3);
+            REQUIRE(timeline->getClipPlaytime(cid3) == l);
+            int middle = timeline->getClipByPosition(tid1, 4);
+            REQUIRE(timeline->getClipPosition(middle) == 3);
+            REQUIRE(timeline->getClipPlaytime(middle) == 3);
+            int last = timeline->getClipByPosition(tid1, 7);
+            REQUIRE(timeline->getClipPosition(last) == 6);
+            REQUIRE(timeline->getClipPlaytime(last) == l - 6);
+            REQUIRE(timeline->rowCount(timeline->makeTrackIndexFromID(tid1)) == 3);
+        };
+        state2();
+
+        undoStack->undo();
+        state();
+        undoStack->redo();
+        state2();
+    }
+
     pCore->projectManager()->closeCurrentDocument(false, false);
 }
 
@@ -1228,6 +1278,58 @@ TEST_CASE("Copy/paste", "[CP]")
         state3(2, 2);
     }
 
+    SECTION("Paste from the in-process clipboard")
+    {
+        int cid1 = -1;
+        REQUIRE(timeline->requestClipInsertion(binId2, tid1, 3, cid1, true, true, false));
+        int l = timeline->getClipPlaytime(cid1);
+        QString cpy_str = TimelineFunctions::copyClips(timeline, {cid1});
+        REQUIRE(TimelineFunctions::canPasteFromClipboard(cpy_str));
+        // A changed clipboard content goes through the xml path
+        REQUIRE_FALSE(TimelineFunctions::canPasteFromClipboard(cpy_str + QLatin1Char(' ')));
+
+        auto state = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getTrackClipsCount(tid1) == 1);
+            REQUIRE(timeline->getTrackClipsCount(tid1b) == 0);
+        };
+        auto state2 = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getTrackClipsCount(tid1) == 1);
+            REQUIRE(timeline->getTrackClipsCount(tid1b) == 1);
+            int cid2 = timeline->getTrackById(tid1b)->getClipByPosition(0);
+            REQUIRE(cid2 != -1);
+            REQUIRE(timeline->getClipBinId(cid2) == binId2);
+            REQUIRE(timeline->getClipPosition(cid2) == 0);
+            REQUIRE(timeline->getClipPlaytime(cid2) == l);
+        };
+        state();
+
+        // Pasting inside an operation that already blocks the monitor refresh must keep it blocked
+        timeline->m_blockRefresh = true;
+        REQUIRE(TimelineFunctions::pasteClips(timeline, cpy_str, tid1b, 0));
+        REQUIRE(timeline->m_blockRefresh);
+        timeline->m_blockRefresh = false;
+        state2();
+
+        // The paste is a single undo operation
+        undoStack->undo();
+        state();
+        undoStack->redo();
+        state2();
+
+        // Same for cutting
+        timeline->m_blockRefresh = true;
+        REQUIRE(TimelineFunctions::requestClipCut(timeline, cid1, 3 + l / 2));
+        REQUIRE(timeline->m_blockRefresh);
+        timeline->m_blockRefresh = false;
+        REQUIRE(timeline->getTrackClipsCount(tid1) == 2);
+        undoStack->undo();
+        state2();
+        undoStack->undo();
+        state();
+    }
+
     SECTION("Paste when tracks get deleted")
     {
         auto state0 = [&]() {
@@ -0,0 +1,99 @@
+/*
+    SPDX-FileCopyrightText: 2026 Kdenlive contributors
+    SPDX-License-Identifier: GPL-3.0-only OR LicenseRef-KDE-Accepted-GPL
+*/
+#include "catch.hpp"
+#include "test_utils.hpp"
+
+#include "doc/docundostack.hpp"
+#include "undohelper.hpp"
+
+/** @brief An undo command holding a payload that can be moved to the journal */
+class PayloadCommand : public AccountedUndoCommand
+{
+public:
+    explicit PayloadCommand(QByteArray payload)
+        : m_payload(std::move(payload))
+    {
+        setText(QStringLiteral("Payload"));
+    }
+    void undo() override
+    {
+        reload();
+        m_applied = m_payload;
+    }
+    void redo() override
+    {
+        reload();
+        m_applied = m_payload;
+    }
+    qint64 memoryCost() const override { return AccountedUndoCommand::memoryCost() + m_payload.size(); }
+    QByteArray m_payload;
+    /** @brief The payload seen by the last undo or redo */
+    QByteArray m_applied;
+
+protected:
+    QByteArray takeState() override
+    {
+        QByteArray state = m_payload;
+        m_payload = QByteArray();
+        return state;
+    }
+    void restoreState(const QByteArray &state) override { m_payload = state; }
+};
+
+TEST_CASE("Undo stack memory budget", "[UndoStack]")
+{
+    DocUndoStack stack(nullptr);
+    stack.setMemoryBudget(0);
+    const int payloadSize = 64 * 1024;
+    auto payload = [payloadSize](int i) { return QByteArray(payloadSize, char('a' + i)); };
+    auto payloadCommand = [&stack](int i) { return static_cast<const PayloadCommand *>(stack.command(i)); };
+    auto totalCost = [&stack]() {
+        qint64 total = 0;
+        for (int i = 0; i < stack.count(); ++i) {
+            total += stack.commandCost(i);
+        }
+        return total;
+    };
+    for (int i = 0; i < 4; ++i) {
+        stack.push(new PayloadCommand(payload(i)));
+    }
+    REQUIRE(stack.count() == 4);
+    REQUIRE(stack.memoryUsage() == totalCost());
+    REQUIRE(stack.memoryUsage() > 4 * payloadSize);
+
+    SECTION("Old commands are spilled over budget and restored on undo")
+    {
+        stack.setMemoryBudget(2 * payloadSize);
+        REQUIRE(stack.memoryUsage() <= 2 * payloadSize);
+        REQUIRE(stack.memoryUsage() == totalCost());
+        REQUIRE(payloadCommand(0)->isSpilled());
+        REQUIRE(payloadCommand(0)->m_payload.isEmpty());
+        // The last command can still be merged, it stays in memory
+        REQUIRE_FALSE(payloadCommand(3)->isSpilled());
+
+        for (int i = 3; i >= 0; --i) {
+            stack.undo();
+            REQUIRE_FALSE(payloadCommand(i)->isSpilled());
+            REQUIRE(payloadCommand(i)->m_applied == payload(i));
+            REQUIRE(stack.memoryUsage() == totalCost());
+        }
+        for (int i = 0; i < 4; ++i) {
+            stack.redo();
+            REQUIRE(payloadCommand(i)->m_applied == payload(i));
+        }
+        REQUIRE(stack.memoryUsage() == totalCost());
+    }
+
+    SECTION("Running total follows the deleted commands")
+    {
+        stack.undo();
+        stack.undo();
+        stack.push(new PayloadCommand(payload(4)));
+        REQUIRE(stack.count() == 3);
+        REQUIRE(stack.memoryUsage() == totalCost());
+        stack.clear();
+        REQUIRE(stack.memoryUsage() == 0);
+    }
+}
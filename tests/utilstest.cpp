@@ -6,8 +6,11 @@
 #include "catch.hpp"
 #include "test_utils.hpp"
 // test specific headers
+#include "utils/decoderpool.h"
 #include "utils/qstringutils.h"
 
+#include <QThread>
+
 TEST_CASE("Testing for different utils", "[Utils]")
 {
 
@@ -29,4 +32,33 @@ TEST_CASE("Testing for different utils", "[Utils]")
 
         REQUIRE(names.removeDuplicates() == 0);
     }
+
+    SECTION("Decoder pool budget stays within the open file limit")
+    {
+        // Enough files: follow the demand
+        REQUIRE(DecoderPool::budget(30, 4096) == 30);
+        // Never below the MLT default
+        REQUIRE(DecoderPool::budget(1, 4096) == 4);
+        // Keep most descriptors for the rest of the application
+        REQUIRE(DecoderPool::budget(500, 1024) == 200);
+        REQUIRE(DecoderPool::budget(100, 256) == 64);
+        // Unknown limit
+        REQUIRE(DecoderPool::budget(500, -1) == 200);
+    }
+
+    SECTION("Decoder pool budget follows the open timelines")
+    {
+        DecoderPool::clear();
+        const QUuid uuid = QUuid::createUuid();
+        DecoderPool::setTimelineTracks(uuid, 40);
+        const int withTimeline = DecoderPool::occupancy().budget;
+        // Reading the limit does not change it
+        const int limit = DecoderPool::occupancy().fileLimit;
+        REQUIRE(DecoderPool::occupancy().fileLimit == limit);
+        DecoderPool::removeTimeline(uuid);
+        const int withoutTimeline = DecoderPool::occupancy().budget;
+        REQUIRE(withoutTimeline <= withTimeline);
+        REQUIRE(withoutTimeline == DecoderPool::budget(QThread::idealThreadCount(), limit));
+        DecoderPool::clear();
+    }
 }